@@ -0,0 +1,23 @@
+namespace Libigl
+{
+    /// <summary>
+    /// Value type of an attribute channel, see <see cref="Native.AddAttribute"/>.
+    /// Must match the C++ <c>AttributeType</c> in <c>InterfaceTypes.h</c>.
+    /// </summary>
+    public static class AttributeType
+    {
+        public const uint Float = 0;
+        public const uint Int = 1;
+        public const uint Byte = 2;
+    }
+
+    /// <summary>
+    /// Whether an attribute channel has one row per vertex or per face.
+    /// Must match the C++ <c>AttributeDomain</c> in <c>InterfaceTypes.h</c>.
+    /// </summary>
+    public static class AttributeDomain
+    {
+        public const uint Vertex = 0;
+        public const uint Face = 1;
+    }
+}
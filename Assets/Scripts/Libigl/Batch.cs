@@ -0,0 +1,167 @@
+using System.Runtime.InteropServices;
+using UnityEngine;
+
+namespace Libigl
+{
+    /// <summary>
+    /// Operations that can be batched with <see cref="Native.ExecuteBatch"/>.
+    /// Each corresponds to the <see cref="Native"/> function of the same name.
+    /// </summary>
+    public static class BatchOp
+    {
+        public const uint SelectSphere = 0;
+        public const uint GetSelectionMaskSphere = 1;
+        public const uint GetSelectionCenter = 2;
+        public const uint ClearSelectionMask = 3;
+        public const uint SetColorByMask = 4;
+        public const uint TranslateSelection = 5;
+        public const uint TransformSelection = 6;
+        public const uint Harmonic = 7;
+        public const uint Arap = 8;
+        public const uint ResetV = 9;
+        public const uint ApplyDirty = 10;
+        public const uint TranslateAllVertices = 11;
+        public const uint SetColorSingleByMask = 12;
+        public const uint SetCompactStorage = 13;
+        public const uint SmoothSelection = 14;
+        public const uint SmoothSelectionImplicit = 15;
+        public const uint FairSelection = 16;
+        public const uint ComputeSkinningWeights = 17;
+        public const uint TransformHandles = 18;
+        public const uint GeodesicDistance = 19;
+        public const uint GrowSelection = 20;
+        public const uint ShrinkSelection = 21;
+        public const uint SelectBorder = 22;
+        public const uint SelectBoundaryLoops = 23;
+        public const uint SelectConnected = 24;
+        public const uint SetArapConvergence = 25;
+        public const uint SetSymmetry = 26;
+        public const uint AnalyzeDeformation = 27;
+        public const uint DetectSelfIntersections = 28;
+    }
+
+    /// <summary>
+    /// Options for a <see cref="BatchCommand"/> as a bitmask.
+    /// </summary>
+    public static class BatchFlag
+    {
+        public const uint None = 0;
+
+        /// <summary>
+        /// TransformSelection: Use the center of the selections as the pivot.
+        /// </summary>
+        public const uint PivotAtSelectionCenter = 1;
+
+        /// <summary>
+        /// Harmonic: Show the deformation field.
+        /// </summary>
+        public const uint ShowDeformationField = 2;
+
+        /// <summary>
+        /// SetCompactStorage: Enable the compact storage, otherwise it is disabled.
+        /// </summary>
+        public const uint CompactStorage = 4;
+
+        /// <summary>
+        /// ComputeSkinningWeights: Compute bounded biharmonic weights, otherwise biharmonic weights.
+        /// </summary>
+        public const uint BoundedWeights = 8;
+
+        /// <summary>
+        /// GeodesicDistance: Write the distance as a color ramp to the colors.
+        /// </summary>
+        public const uint ColorByDistance = 16;
+        /// <summary>
+        /// DetectSelfIntersections: Color the vertices of the intersecting faces.
+        /// </summary>
+        public const uint ColorIntersections = 32;
+    }
+
+    /// <summary>
+    /// One operation in a flat array of commands for <see cref="Native.ExecuteBatch"/>, which may contain
+    /// commands for several meshes. Only the members used by the <see cref="Op"/> need to be set.<p/>
+    /// Must match the C++ <c>BatchCommand</c> in <c>InterfaceTypes.h</c> exactly.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public unsafe struct BatchCommand
+    {
+        public MeshState* State;
+        /// <summary>ApplyDirty: Pointers to the Unity mesh data</summary>
+        public UMeshDataNative Data;
+
+        /// <summary>Use <see cref="BatchOp"/> constants</summary>
+        public uint Op;
+        /// <summary>Use <see cref="BatchFlag"/> constants</summary>
+        public uint Flags;
+        /// <summary>
+        /// Selections to operate on. Harmonic/Arap: boundary mask, ApplyDirty: visible selection mask,
+        /// ComputeSkinningWeights: handle mask, GeodesicDistance: source mask
+        /// </summary>
+        public uint MaskId;
+        /// <summary>
+        /// Translate/TransformSelection/TransformHandles: Index of an earlier GetSelectionMaskSphere command of the same mesh, or -1.
+        /// If the selections inside that sphere, filtered by <see cref="MaskFilter"/>, are not empty they replace <see cref="MaskId"/>.
+        /// </summary>
+        public int MaskSource;
+        public uint MaskFilter;
+
+        /// <summary>
+        /// SelectSphere, Grow/ShrinkSelection, SelectBorder/BoundaryLoops/Connected: Which selection to modify.
+        /// SetColorSingleByMask: colorId
+        /// </summary>
+        public int SelectionId;
+        public uint SelectionMode;
+        public Vector3 Position;
+        public float Radius;
+
+        public Vector3 Translation;
+        /// <summary>TransformSelection/TransformHandles: Scale</summary>
+        public float Scale;
+        public Quaternion Rotation;
+        public Vector3 Pivot;
+
+        /// <summary>SmoothSelection/SmoothSelectionImplicit: Step size. SetArapConvergence: tolerance</summary>
+        public float Lambda;
+        /// <summary>SmoothSelection: Number of smoothing steps. Grow/ShrinkSelection: rings. SetArapConvergence: maxIterations</summary>
+        public int Iterations;
+
+        /// <summary>SetSymmetry: Normal of the plane, 0, 1 or 2 for x, y or z, -1 to disable symmetry</summary>
+        public int Axis;
+        /// <summary>SetSymmetry: Position of the plane along the axis in local space</summary>
+        public float Plane;
+        /// <summary>SetSymmetry: Maximum distance of a mirrored vertex to the reflection, relative to the bounding box diagonal</summary>
+        public float Tolerance;
+
+        /// <summary>AnalyzeDeformation: Use <see cref="DeformationColor"/> constants</summary>
+        public uint ColorMode;
+        /// <summary>AnalyzeDeformation: Value shown red, 0 to use the largest value of the call</summary>
+        public float ColorMax;
+
+        /// <returns>A command for the <paramref name="state"/> with no MaskSource and identity transformation</returns>
+        public static BatchCommand Create(MeshState* state, uint op)
+        {
+            return new BatchCommand
+            {
+                State = state, Op = op, MaskSource = -1, MaskId = uint.MaxValue,
+                Scale = 1f, Rotation = Quaternion.identity
+            };
+        }
+    }
+
+    /// <summary>
+    /// Output of one <see cref="BatchCommand"/>, written to the same index as the command.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct BatchResult
+    {
+        /// <summary>GetSelectionMaskSphere: The selections inside the sphere. Translate/TransformSelection: The mask used</summary>
+        public uint Mask;
+        /// <summary>GetSelectionCenter: The mean vertex. TransformSelection: The pivot used</summary>
+        public Vector3 Center;
+
+        /// <summary>Dirty state of the mesh after executing the command, see <see cref="MeshState"/></summary>
+        public uint DirtyState;
+        public uint DirtySelections;
+        public uint DirtySelectionsResized;
+    }
+}
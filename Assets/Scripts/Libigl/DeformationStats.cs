@@ -0,0 +1,45 @@
+using System.Runtime.InteropServices;
+
+namespace Libigl
+{
+    /// <summary>
+    /// Which quantity <see cref="Native.AnalyzeDeformation"/> writes as a color ramp to the colors.
+    /// Must match the C++ <c>DeformationColor</c> in <c>InterfaceTypes.h</c>.
+    /// </summary>
+    public static class DeformationColor
+    {
+        public const uint None = 0;
+        /// <summary>Distance of each vertex from its rest position</summary>
+        public const uint Displacement = 1;
+        /// <summary>Mean |log2| of the area ratio of the faces of each vertex</summary>
+        public const uint AreaDistortion = 2;
+        /// <summary>Mean angle distortion of the faces of each vertex in radians</summary>
+        public const uint AngleDistortion = 3;
+    }
+
+    /// <summary>
+    /// Summary of how far the mesh has moved from its rest positions, see <see cref="Native.AnalyzeDeformation"/>.<p/>
+    /// Must match the C++ <c>DeformationStats</c> in <c>InterfaceTypes.h</c> exactly.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct DeformationStats
+    {
+        public float MaxDisplacement;
+        public float MeanDisplacement;
+        public float RmsDisplacement;
+        /// <summary>The vertex with the <see cref="MaxDisplacement"/>, -1 if no vertex has moved</summary>
+        public int MaxDisplacementVertex;
+
+        /// <summary>Smallest ratio of the area of a face to its rest area</summary>
+        public float MinAreaRatio;
+        /// <summary>Largest ratio of the area of a face to its rest area</summary>
+        public float MaxAreaRatio;
+        /// <summary>Total area divided by the total rest area</summary>
+        public float AreaRatio;
+
+        /// <summary>Largest change of an angle of a face in radians</summary>
+        public float MaxAngleDistortion;
+        /// <summary>Mean over the faces of their largest angle change in radians</summary>
+        public float MeanAngleDistortion;
+    }
+}
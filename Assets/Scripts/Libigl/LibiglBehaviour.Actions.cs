@@ -13,6 +13,11 @@ namespace Libigl
         private uint _currentTranslateMaskL;
         private uint _currentTranslateMaskR;
 
+        /// <summary>
+        /// Whether the self-intersections were colored in the previous frame, so the colors are restored once
+        /// </summary>
+        private bool _showingSelfIntersections;
+
         /// <summary>
         /// Transforms the selections based on the <see cref="TransformDelta"/>s given in the <see cref="MeshInputState"/>
         /// It also decides which selections should be translated, storing this in <see cref="_currentTranslateMaskL"/>
@@ -92,7 +97,16 @@ namespace Libigl
         /// </summary>
         private void ActionTransformSelectionGeneric(ref TransformDelta transformDelta, uint maskId)
         {
-            if (transformDelta.Rotate == Quaternion.identity && transformDelta.Scale == 1f)
+            if (_executeInput.SkinningMode)
+            {
+                // Move the handles, the whole mesh is deformed
+                var handlePivot = transformDelta.Mode == PivotMode.Selection
+                    ? Native.GetSelectionCenter(State, maskId)
+                    : transformDelta.Pivot;
+                Native.TransformHandles(State, transformDelta.Translate, transformDelta.Scale,
+                    transformDelta.Rotate, handlePivot, maskId);
+            }
+            else if (transformDelta.Rotate == Quaternion.identity && transformDelta.Scale == 1f)
             {
                 // Only translate selection
                 Native.TranslateSelection(State, transformDelta.Translate, maskId);
@@ -162,15 +176,55 @@ namespace Libigl
         }
 
         /// <summary>
-        /// Runs the <c>igl::arap</c> As-Rigid-As-Possible Deformation
+        /// Relative displacement at which a repeated Arap stops iterating, see <see cref="Native.SetArapConvergence"/>
+        /// </summary>
+        private const float ArapRepeatTolerance = 1e-4f;
+
+        /// <summary>
+        /// Runs the <c>igl::arap</c> As-Rigid-As-Possible Deformation.
+        /// When repeated every frame it stops once converged, as it continues from the previous frame.
         /// </summary>
         private void ActionArap()
         {
             if (!_executeInput.DoArap) return;
 
+            Native.SetArapConvergence(State, 100, _executeInput.DoArapRepeat ? ArapRepeatTolerance : 0f);
             Native.Arap(State, _executeInput.VisibleSelectionMask);
         }
 
+        /// <summary>
+        /// Precomputes the linear blend skinning with the visible selections as handles, see <see cref="MeshInputState.SkinningMode"/>
+        /// </summary>
+        private void ActionSkinningWeights()
+        {
+            if (!_executeInput.DoSkinningWeights) return;
+
+            Native.ComputeSkinningWeights(State, _executeInput.VisibleSelectionMask);
+        }
+
+        /// <summary>
+        /// Colors the self-intersections, only the moved region is checked each frame
+        /// </summary>
+        private void ActionSelfIntersections()
+        {
+            if (!_executeInput.ShowSelfIntersections && !_showingSelfIntersections) return;
+
+            Native.DetectSelfIntersections(State, _executeInput.ShowSelfIntersections);
+            _showingSelfIntersections = _executeInput.ShowSelfIntersections;
+        }
+
+        /// <summary>
+        /// Loads or saves the session, including the deformation caches
+        /// </summary>
+        private void ActionSession()
+        {
+            if (!string.IsNullOrEmpty(_executeInput.LoadSessionPath))
+                Native.LoadSession(State, _executeInput.LoadSessionPath);
+
+            if (!string.IsNullOrEmpty(_executeInput.SaveSessionPath))
+                Native.SaveSession(State, _executeInput.SaveSessionPath);
+        }
+
         /// <summary>
         /// Applies various actions triggered from the UI or other input
         /// </summary>
@@ -62,7 +62,7 @@ namespace Libigl
             Mesh = libiglMesh;
 
             // Initialize C++ and create the State from the DataRowMajor
-            State = Native.InitializeMesh(libiglMesh.DataRowMajor.GetNative(), Mesh.name);
+            State = Native.InitializeMesh(libiglMesh.DataRowMajor.GetNative(), Mesh.name, libiglMesh.reorderVertices);
             Input = MeshInputState.GetInstance();
 
             _uiDetails = UiManager.get.CreateDetailsPanel();
@@ -113,6 +113,7 @@ namespace Libigl
         /// RowMajor <see cref="UMeshData"/> outside the main thread.</remarks>
         public void Execute()
         {
+            ActionSession();
             ActionUi();
             if (Mesh.IsActiveMesh())
             {
@@ -128,8 +129,11 @@ namespace Libigl
 
                 ActionHarmonic();
                 ActionArap();
+                ActionSkinningWeights();
             }
 
+            ActionSelfIntersections();
+
             // Apply changes back to the RowMajor so they can be applied to the mesh
             Mesh.DataRowMajor.ApplyDirty(State, _executeInput);
         }
@@ -143,11 +147,15 @@ namespace Libigl
         {
             _uiDetails.UpdatePostExecute();
 
-            // Apply RowMajor changes to the Unity mesh, this must be done with RowMajor data
-            Mesh.DataRowMajor.ApplyDirtyToMesh(Mesh.Mesh);
+            // With output frames the mesh is updated in ApplyFrame, whilst the next Execute is running
+            if (!Mesh.DataRowMajor.UsesOutputFrames)
+            {
+                // Apply RowMajor changes to the Unity mesh, this must be done with RowMajor data
+                Mesh.DataRowMajor.ApplyDirtyToMesh(Mesh.Mesh);
 
-            if ((State->DirtyState & DirtyFlag.VDirty) > 0 && (State->DirtyState & DirtyFlag.DontComputeBounds) == 0)
-                Mesh.UpdateBoundingBoxSize();
+                if ((State->DirtyState & DirtyFlag.VDirty) > 0 && (State->DirtyState & DirtyFlag.DontComputeBounds) == 0)
+                    Mesh.UpdateBoundingBoxSize();
+            }
 
             // Consume Dirty
             State->DirtyState = DirtyFlag.None;
@@ -155,6 +163,35 @@ namespace Libigl
             State->DirtySelectionsResized = 0;
         }
 
+        /// <summary>
+        /// Apply the latest output frame published by <see cref="Execute"/> to the mesh, if output frames are used.
+        /// Called every frame after the worker thread has been started, so the upload overlaps with the next Execute.<p/>
+        /// Called on the main thread.
+        /// </summary>
+        public void ApplyFrame()
+        {
+            if (!Mesh.DataRowMajor.UsesOutputFrames) return;
+
+            var dirtyState = Mesh.DataRowMajor.ApplyFrameToMesh(State, Mesh.Mesh);
+            if ((dirtyState & DirtyFlag.VDirty) > 0 && (dirtyState & DirtyFlag.DontComputeBounds) == 0)
+                Mesh.UpdateBoundingBoxSize();
+        }
+
+        /// <summary>
+        /// Priority of meshes the user is not interacting with when sharing the solver threads,
+        /// see <see cref="Native.SetSolverPriority"/>
+        /// </summary>
+        private const float BackgroundSolverPriority = 0.1f;
+
+        /// <summary>
+        /// Give the solvers of the active mesh most of the worker threads, the others run their precomputations
+        /// at a low priority. Called on the main thread when the active mesh changes.
+        /// </summary>
+        public void UpdateSolverPriority()
+        {
+            Native.SetSolverPriority(State, Mesh.IsActiveMesh() ? 1f : BackgroundSolverPriority);
+        }
+
         /// <summary>
         /// This is the destructor. Ensure all C++ owned data is deleted. Calls <see cref="Native.DisposeMesh"/>
         /// </summary>
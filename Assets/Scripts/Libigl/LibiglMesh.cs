@@ -4,6 +4,7 @@ using System.Linq;
 using System.Threading;
 using UnityEngine;
 using UnityEngine.Assertions;
+using UnityEngine.Rendering;
 using UnityNativeTool;
 using XrInput;
 
@@ -29,6 +30,27 @@ namespace Libigl
         /// </summary>
         public UMeshData DataRowMajor { get; private set; }
 
+        /// <summary>
+        /// Upload the vertex positions directly from C++ to the GPU, see <see cref="UMeshData.EnableNativeUpload"/>.
+        /// Normals and bounds are then not recalculated.
+        /// </summary>
+        [Tooltip("Upload vertex positions directly from C++ to the GPU on the render thread")]
+        public bool useNativeUpload;
+
+        /// <summary>
+        /// Triple buffer the output in C++, so the next <see cref="LibiglBehaviour.Execute"/> runs whilst the
+        /// previous result is applied to the mesh, see <see cref="UMeshData.EnableOutputFrames"/>.
+        /// </summary>
+        [Tooltip("Compute the next frame whilst the previous one is applied to the mesh, uses three copies of the mesh data")]
+        public bool useOutputFrames;
+
+        /// <summary>
+        /// Reorder the vertices and faces in C++ so vertices close in space are close in memory,
+        /// see <see cref="Native.InitializeMesh"/>. The reordered mesh is written back to the <see cref="Mesh"/>.
+        /// </summary>
+        [Tooltip("Sort the vertices along a space-filling curve when loading, the mesh must only have positions, normals, colors and uvs")]
+        public bool reorderVertices;
+
         /// <summary>
         /// The libigl behaviour instance that is executing on this mesh
         /// </summary>
@@ -66,12 +88,24 @@ namespace Libigl
             Mesh.MarkDynamic();
             ResetTransformToSpawn();
 
+            if (reorderVertices && !CanReorderVertices(Mesh))
+            {
+                Debug.LogWarning($"Not reordering the vertices of {name}, it has submeshes, blend shapes or " +
+                                 "vertex attributes other than positions, normals, colors and uvs.");
+                reorderVertices = false;
+            }
+
             // First copy the Mesh arrays into a RowMajor UMeshData instance
             DataRowMajor = new UMeshData(Mesh);
             // Then create the LibiglBehaviour instance which will create a ColMajor instance of the data in the State
             Behaviour = new LibiglBehaviour(this);
 
             DataRowMajor.LinkBehaviourState(Behaviour);
+            Behaviour.UpdateSolverPriority();
+            if (useNativeUpload && !DataRowMajor.EnableNativeUpload(Behaviour.State, Mesh))
+                Debug.LogWarning("Native upload is not supported for the current graphics device, using managed upload.");
+            if (useOutputFrames)
+                DataRowMajor.EnableOutputFrames(Behaviour.State);
 
             BoundingBox = Instantiate(MeshManager.get.boundingBoxPrefab, Vector3.zero, Quaternion.identity, transform)
                 .transform;
@@ -86,9 +120,24 @@ namespace Libigl
 #endif
         }
 
+        /// <returns>True if the reordered <see cref="UMeshData"/> is the whole mesh, i.e. no other data of the
+        /// <paramref name="mesh"/> is indexed by the vertices or faces and would be left in the old order</returns>
+        private static bool CanReorderVertices(Mesh mesh)
+        {
+            if (mesh.subMeshCount > 1 || mesh.blendShapeCount > 0)
+                return false;
+
+            foreach (var attribute in mesh.GetVertexAttributes())
+                if (attribute.attribute != VertexAttribute.Position && attribute.attribute != VertexAttribute.Normal &&
+                    attribute.attribute != VertexAttribute.Color && attribute.attribute != VertexAttribute.TexCoord0)
+                    return false;
+            return true;
+        }
+
         private void OnActiveMeshChanged()
         {
             RepaintBounds();
+            Behaviour.UpdateSolverPriority();
         }
 
         private void Update()
@@ -103,6 +152,9 @@ namespace Libigl
 
             if (_workerThread == null)
                 ExecuteThread();
+
+            // Apply the latest output frame whilst the worker thread computes the next one
+            Behaviour.ApplyFrame();
         }
 
         /// <summary>
@@ -160,10 +212,11 @@ namespace Libigl
                 _workerThread = null;
             }
 
-            DataRowMajor?.Dispose();
-            DataRowMajor = null;
+            // The state first, DisposeMesh waits for the deferred initialization still reading the DataRowMajor
             Behaviour?.Dispose();
             Behaviour = null;
+            DataRowMajor?.Dispose();
+            DataRowMajor = null;
 
             MeshManager.get.UnregisterMesh(this);
 
@@ -72,9 +72,31 @@ namespace Libigl
         public bool HarmonicShowDisplacement;
         public bool DoArap;
         public bool DoArapRepeat;
+        /// <summary>
+        /// Compute the skinning weights once, with the visible selections as handles
+        /// </summary>
+        public bool DoSkinningWeights;
+        /// <summary>
+        /// Transform the skinning handles instead of the selected vertices
+        /// </summary>
+        public bool SkinningMode;
+        /// <summary>
+        /// Detect self-intersections every frame and color the intersecting faces
+        /// </summary>
+        public bool ShowSelfIntersections;
 
         public bool ResetV;
 
+        // Session
+        /// <summary>
+        /// Save the session to this file once, see <see cref="Native.SaveSession"/>
+        /// </summary>
+        public string SaveSessionPath;
+        /// <summary>
+        /// Load the session from this file once, see <see cref="Native.LoadSession"/>
+        /// </summary>
+        public string LoadSessionPath;
+
         /// <returns>An instance with the default values</returns>
         public static MeshInputState GetInstance()
         {
@@ -104,7 +126,10 @@ namespace Libigl
                 DoHarmonic = false;
             if (!DoArapRepeat)
                 DoArap = false;
+            DoSkinningWeights = false;
             ResetV = false;
+            SaveSessionPath = null;
+            LoadSessionPath = null;
             
             ConsumeTransform();
         }
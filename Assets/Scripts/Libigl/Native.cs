@@ -1,3 +1,4 @@
+using System;
 using System.Runtime.InteropServices;
 using UnityEngine;
 using UnityEngine.Rendering;
@@ -89,7 +90,11 @@ namespace Libigl
             NativeCallbacks.StringCallback debugWarningCallback, NativeCallbacks.StringCallback debugErrorCallback);
 
         [DllImport(DllName)]
-        public static extern unsafe MeshState* InitializeMesh(UMeshDataNative data, string name);
+        public static extern unsafe MeshState* InitializeMesh(UMeshDataNative data, string name, bool reorder);
+
+        [DllImport(DllName)]
+        [return: MarshalAs(UnmanagedType.U1)]
+        public static extern unsafe bool IsMeshInitialized(MeshState* state);
 
         [DllImport(DllName)]
         public static extern unsafe void DisposeMesh(MeshState* data);
@@ -107,6 +112,20 @@ namespace Libigl
             out uint* FPtr, out int FSize,
             bool calculateNormalsIfEmpty);
 
+        // Session.cpp
+        [DllImport(DllName, ExactSpelling = true, CharSet = CharSet.Ansi)]
+        [return: MarshalAs(UnmanagedType.U1)]
+        public static extern unsafe bool SaveSession(MeshState* state, string path, bool includeCaches = true);
+
+        [DllImport(DllName, ExactSpelling = true, CharSet = CharSet.Ansi)]
+        [return: MarshalAs(UnmanagedType.U1)]
+        public static extern unsafe bool LoadSession(MeshState* state, string path);
+
+
+        // Reorder.cpp
+        [DllImport(DllName)]
+        [return: MarshalAs(UnmanagedType.U1)]
+        public static extern unsafe bool GetMeshOrder(MeshState* state, int* vertexOrder, int* faceOrder);
 
         // ModifyMesh.cpp
         [DllImport(DllName)]
@@ -125,10 +144,53 @@ namespace Libigl
         [DllImport(DllName)]
         public static extern unsafe void Arap(MeshState* state, uint boundaryMask);
 
+        [DllImport(DllName)]
+        public static extern unsafe void HarmonicSets(MeshState* state, SelectionMask boundary, bool showDeformationField);
+
+        [DllImport(DllName)]
+        public static extern unsafe void ArapSets(MeshState* state, SelectionMask boundary);
+
+        [DllImport(DllName)]
+        public static extern unsafe void SetArapConvergence(MeshState* state, int maxIterations, float tolerance);
+
+        [DllImport(DllName)]
+        public static extern unsafe int GetArapStats(MeshState* state, out float residual);
+
+        [DllImport(DllName)]
+        public static extern unsafe float GetArapEnergy(MeshState* state);
+
         [DllImport(DllName)]
         public static extern unsafe void ResetV(MeshState* state);
 
 
+        // Geodesic.cpp
+        [DllImport(DllName)]
+        public static extern unsafe float GeodesicDistance(MeshState* state, uint sourceMask, float* distances = null,
+            bool colorByDistance = false);
+
+        // Intersection.cpp
+        [DllImport(DllName)]
+        public static extern unsafe int DetectSelfIntersections(MeshState* state, bool colorFaces = true);
+
+        [DllImport(DllName)]
+        public static extern unsafe int GetSelfIntersections(MeshState* state, int* pairs, int capacity);
+
+        // Topology.cpp
+        [DllImport(DllName)]
+        public static extern unsafe void GrowSelection(MeshState* state, int selectionId, int rings = 1);
+
+        [DllImport(DllName)]
+        public static extern unsafe void ShrinkSelection(MeshState* state, int selectionId, int rings = 1);
+
+        [DllImport(DllName)]
+        public static extern unsafe void SelectBorder(MeshState* state, int selectionId);
+
+        [DllImport(DllName)]
+        public static extern unsafe void SelectBoundaryLoops(MeshState* state, int selectionId);
+
+        [DllImport(DllName)]
+        public static extern unsafe void SelectConnected(MeshState* state, int selectionId);
+
         // Selection.cpp
         [DllImport(DllName)]
         public static extern unsafe void SelectSphere(MeshState* state, Vector3 position, float radius,
@@ -149,6 +211,169 @@ namespace Libigl
         [DllImport(DllName)]
         public static extern unsafe void SetColorByMask(MeshState* state, uint maskId);
 
+        // Symmetry.cpp
+        [DllImport(DllName)]
+        public static extern unsafe int SetSymmetry(MeshState* state, int axis, float plane, float tolerance);
+
+
+        // SelectionSets.cpp
+        [DllImport(DllName, ExactSpelling = true, CharSet = CharSet.Ansi)]
+        public static extern unsafe int AddSelectionSet(MeshState* state, string name);
+
+        [DllImport(DllName)]
+        public static extern unsafe void RemoveSelectionSet(MeshState* state, int id);
+
+        [DllImport(DllName, ExactSpelling = true, CharSet = CharSet.Ansi)]
+        public static extern unsafe int FindSelectionSet(MeshState* state, string name);
+
+        [DllImport(DllName)]
+        public static extern unsafe uint GetSelectionSize(MeshState* state, SelectionMask mask);
+
+        [DllImport(DllName)]
+        public static extern unsafe int GetSelectionSetsSphere(MeshState* state, Vector3 position, float radius,
+            int* setIds, int capacity);
+
+        [DllImport(DllName)]
+        public static extern unsafe Vector3 GetSelectionSetsCenter(MeshState* state, SelectionMask mask);
+
+        [DllImport(DllName)]
+        public static extern unsafe void ClearSelectionSets(MeshState* state, SelectionMask mask);
+
+        [DllImport(DllName)]
+        public static extern unsafe void TransformSelectionSets(MeshState* state, Vector3 translation, float scale,
+            Quaternion rotation, Vector3 pivot, SelectionMask mask);
+
+        [DllImport(DllName)]
+        public static extern unsafe void SetColorBySelectionSets(MeshState* state, int* setIds, int setCount);
+
+
+        // Smooth.cpp
+        [DllImport(DllName)]
+        public static extern unsafe void SmoothSelection(MeshState* state, uint maskId, float lambda = 0.5f,
+            int iterations = 1);
+
+        [DllImport(DllName)]
+        public static extern unsafe void SmoothSelectionImplicit(MeshState* state, uint maskId, float lambda = 1f);
+
+        [DllImport(DllName)]
+        public static extern unsafe void FairSelection(MeshState* state, uint maskId);
+
+        // Analysis.cpp
+        [DllImport(DllName)]
+        public static extern unsafe void AnalyzeDeformation(MeshState* state, ref DeformationStats stats,
+            float* displacement = null, float* areaDistortion = null, float* angleDistortion = null,
+            uint colorMode = DeformationColor.None, float colorMax = 0f);
+
+        // Skinning.cpp
+        [DllImport(DllName)]
+        public static extern unsafe void ComputeSkinningWeights(MeshState* state, uint handleMask, bool bounded = false);
+
+        [DllImport(DllName)]
+        public static extern unsafe void TransformHandles(MeshState* state, Vector3 translation, float scale,
+            Quaternion rotation, Vector3 pivot, uint maskId);
+
+        // Attributes.cpp
+        [DllImport(DllName, ExactSpelling = true, CharSet = CharSet.Ansi)]
+        public static extern unsafe int AddAttribute(MeshState* state, string name, uint type = AttributeType.Float,
+            int components = 1, uint domain = AttributeDomain.Vertex);
+
+        [DllImport(DllName)]
+        public static extern unsafe void RemoveAttribute(MeshState* state, int id);
+
+        [DllImport(DllName, ExactSpelling = true, CharSet = CharSet.Ansi)]
+        public static extern unsafe int FindAttribute(MeshState* state, string name);
+
+        [DllImport(DllName)]
+        public static extern unsafe void* GetAttributeData(MeshState* state, int id);
+
+        [DllImport(DllName)]
+        [return: MarshalAs(UnmanagedType.U1)]
+        public static extern unsafe bool SetAttributeTarget(MeshState* state, int id, void* target);
+
+        [DllImport(DllName)]
+        public static extern unsafe void SetAttribute(MeshState* state, int id, void* values, int begin, int end);
+
+        [DllImport(DllName)]
+        [return: MarshalAs(UnmanagedType.U1)]
+        public static extern unsafe bool GetAttributeChanged(MeshState* state, int id, ref int begin, ref int end);
+
+        // Storage.cpp
+        [DllImport(DllName)]
+        public static extern unsafe void SetCompactStorage(MeshState* state, bool compact);
+
+        [DllImport(DllName)]
+        public static extern unsafe ulong GetMeshMemoryUsage(MeshState* state);
+
+        // Batch.cpp
+        [DllImport(DllName)]
+        public static extern unsafe void ExecuteBatch(BatchCommand* commands, int count, BatchResult* results);
+
+        // Scheduler.cpp
+        [DllImport(DllName)]
+        public static extern unsafe void SetSolverPriority(MeshState* state, float priority);
+
+        [DllImport(DllName)]
+        public static extern unsafe int GetSolverThreads(MeshState* state);
+
+        // Trace.cpp
+        [DllImport(DllName, ExactSpelling = true, CharSet = CharSet.Ansi)]
+        [return: MarshalAs(UnmanagedType.U1)]
+        public static extern bool StartTrace(string path);
+
+        [DllImport(DllName)]
+        public static extern void StopTrace();
+
+        // Upload.cpp
+        [DllImport(DllName)]
+        public static extern IntPtr GetUploadMeshPtr();
+
+        [DllImport(DllName)]
+        public static extern unsafe IntPtr EnableNativeUpload(MeshState* state, IntPtr gfxVertexBufferPtr);
+
+        [DllImport(DllName)]
+        public static extern unsafe void DisableNativeUpload(MeshState* state);
+
+        // Frames.cpp
+        /// <summary>Number of output frames allocated by <see cref="EnableOutputFrames"/></summary>
+        public const int OutputFrameCount = 3;
+
+        [DllImport(DllName)]
+        public static extern unsafe void EnableOutputFrames(MeshState* state);
+
+        [DllImport(DllName)]
+        public static extern unsafe void DisableOutputFrames(MeshState* state);
+
+        [DllImport(DllName)]
+        public static extern unsafe UMeshDataNative GetOutputFrame(MeshState* state, int frame);
+
+        [DllImport(DllName)]
+        public static extern unsafe int AcquireOutputFrame(MeshState* state, out uint dirtyState);
+
+        // Streaming.cpp
+        [DllImport(DllName)]
+        public static extern unsafe bool SaveStreamingMesh(MeshState* state, string path, int chunkVertices = 65536);
+
+        /// <returns>The StreamingMesh* or <c>IntPtr.Zero</c> if the file is invalid</returns>
+        [DllImport(DllName)]
+        public static extern IntPtr OpenStreamingMesh(string path, ulong memoryBudget, out int vSize, out int fSize);
+
+        [DllImport(DllName)]
+        public static extern void CloseStreamingMesh(IntPtr mesh);
+
+        [DllImport(DllName)]
+        public static extern int UpdateStreaming(IntPtr mesh, Vector3 brush, float brushRadius, Vector3 view,
+            float viewRadius);
+
+        [DllImport(DllName)]
+        public static extern void StreamingSelectSphere(IntPtr mesh, Vector3 position, float radius, int selectionId,
+            uint selectionMode);
+
+        [DllImport(DllName)]
+        public static extern void StreamingTranslateSelection(IntPtr mesh, Vector3 translation, int selectionId);
+
+        [DllImport(DllName)]
+        public static extern uint StreamingApplyDirty(IntPtr mesh, UMeshDataNative data, uint visibleSelectionMask);
+
         #endregion
     }
 }
\ No newline at end of file
@@ -0,0 +1,29 @@
+using System.Runtime.InteropServices;
+
+namespace Libigl
+{
+    /// <summary>
+    /// Selects vertices from both the 32 selections in <see cref="MeshState.SPtr"/> and the selection sets,
+    /// see <see cref="Native.AddSelectionSet"/>. The <see cref="SetIds"/> must be fixed for the duration of the call.<p/>
+    /// Must match the C++ <c>SelectionMask</c> in <c>InterfaceTypes.h</c> exactly.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public unsafe struct SelectionMask
+    {
+        /// <summary>Id of the first selection set, lower ids are bits of the selection mask</summary>
+        public const int FirstSetId = 32;
+
+        /// <summary>Bitmask of the selections, as for the functions taking a maskId</summary>
+        public uint Mask;
+        /// <summary>Ids of the selection sets, may be null if <see cref="SetCount"/> is 0</summary>
+        public int* SetIds;
+        public int SetCount;
+
+        public SelectionMask(uint mask, int* setIds = null, int setCount = 0)
+        {
+            Mask = mask;
+            SetIds = setIds;
+            SetCount = setCount;
+        }
+    }
+}
@@ -3,6 +3,7 @@ using Unity.Collections;
 using Unity.Collections.LowLevel.Unsafe;
 using UnityEngine;
 using UnityEngine.Assertions;
+using UnityEngine.Rendering;
 
 namespace Libigl
 {
@@ -41,7 +42,19 @@ namespace Libigl
         /// </summary>
         public const uint VDirtyExclBoundary = 256;
 
-        public const uint All = uint.MaxValue - DontComputeNormals - DontComputeBounds;
+        /// <summary>
+        /// Set by <see cref="Native.ApplyDirty"/> when V has been staged for the native upload instead of being
+        /// written to <see cref="UMeshData.V"/>, see <see cref="UMeshData.EnableNativeUpload"/>.
+        /// </summary>
+        public const uint VUploaded = 512;
+
+        /// <summary>
+        /// Set by <see cref="Native.ApplyDirty"/> when an attribute channel has been modified,
+        /// see <see cref="Native.GetAttributeChanged"/>.
+        /// </summary>
+        public const uint AttributesDirty = 1024;
+
+        public const uint All = uint.MaxValue - DontComputeNormals - DontComputeBounds - VUploaded;
     }
 
     /// <summary>
@@ -72,6 +85,53 @@ namespace Libigl
         /// </summary>
         private UMeshDataNative _native;
 
+        /// <summary>
+        /// The data returned by <see cref="Native.EnableNativeUpload"/>, passed to the render event.
+        /// Zero if the vertices are uploaded via the managed mesh.
+        /// </summary>
+        private IntPtr _uploadData;
+        private CommandBuffer _uploadCommands;
+
+        /// <summary>
+        /// Views of the native output frames, see <see cref="EnableOutputFrames"/>.
+        /// Null if <see cref="Native.ApplyDirty"/> writes to the arrays of this instance.
+        /// </summary>
+        private FrameArrays[] _frames;
+
+        /// <summary>
+        /// The attributes of one native output frame as NativeArrays, the memory is owned by C++
+        /// </summary>
+        private struct FrameArrays
+        {
+            public NativeArray<Vector3> V;
+            public NativeArray<Vector3> N;
+            public NativeArray<Color> C;
+            public NativeArray<Vector2> UV;
+            public NativeArray<int> F;
+
+            public unsafe FrameArrays(UMeshDataNative data)
+            {
+                V = NativeArrayUnsafeUtility.ConvertExistingDataToNativeArray<Vector3>(data.VPtr, data.VSize, Allocator.None);
+                N = NativeArrayUnsafeUtility.ConvertExistingDataToNativeArray<Vector3>(data.NPtr, data.VSize, Allocator.None);
+                C = NativeArrayUnsafeUtility.ConvertExistingDataToNativeArray<Color>(data.CPtr, data.VSize, Allocator.None);
+                UV = NativeArrayUnsafeUtility.ConvertExistingDataToNativeArray<Vector2>(data.UVPtr, data.VSize, Allocator.None);
+                F = NativeArrayUnsafeUtility.ConvertExistingDataToNativeArray<int>(data.FPtr, 3 * data.FSize, Allocator.None);
+
+#if ENABLE_UNITY_COLLECTIONS_CHECKS
+                NativeArrayUnsafeUtility.SetAtomicSafetyHandle(ref V, AtomicSafetyHandle.Create());
+                NativeArrayUnsafeUtility.SetAtomicSafetyHandle(ref N, AtomicSafetyHandle.Create());
+                NativeArrayUnsafeUtility.SetAtomicSafetyHandle(ref C, AtomicSafetyHandle.Create());
+                NativeArrayUnsafeUtility.SetAtomicSafetyHandle(ref UV, AtomicSafetyHandle.Create());
+                NativeArrayUnsafeUtility.SetAtomicSafetyHandle(ref F, AtomicSafetyHandle.Create());
+#endif
+            }
+        }
+
+        /// <summary>
+        /// True if the output is triple buffered in C++, see <see cref="EnableOutputFrames"/>
+        /// </summary>
+        public bool UsesOutputFrames => _frames != null;
+
         /// <param name="mesh">Unity Mesh to copy from</param>
         public UMeshData(Mesh mesh)
         {
@@ -146,6 +206,39 @@ namespace Libigl
             F.CopyFrom(mesh.triangles);
         }
 
+        /// <summary>
+        /// Upload the vertex positions from C++ directly to the GPU vertex buffer on the render thread,
+        /// instead of via <see cref="V"/> and <c>mesh.SetVertices</c>. See <see cref="Native.EnableNativeUpload"/>.<p/>
+        /// Must be called on the main thread whilst no worker thread is running.
+        /// </summary>
+        /// <returns>True if the native upload is supported by the current graphics device</returns>
+        public unsafe bool EnableNativeUpload(MeshState* state, Mesh mesh)
+        {
+            _uploadData = Native.EnableNativeUpload(state, mesh.GetNativeVertexBufferPtr(0));
+            if (_uploadData == IntPtr.Zero)
+                return false;
+
+            _uploadCommands?.Release();
+            _uploadCommands = new CommandBuffer {name = "UploadMesh"};
+            _uploadCommands.IssuePluginEventAndData(Native.GetUploadMeshPtr(), 0, _uploadData);
+            return true;
+        }
+
+        /// <summary>
+        /// Triple buffer the output in C++, so the worker thread can compute the next frame whilst the previous one is
+        /// applied to the mesh with <see cref="ApplyFrameToMesh"/>. The arrays of this instance are then not updated.
+        /// See <see cref="Native.EnableOutputFrames"/>.<p/>
+        /// Must be called on the main thread whilst no worker thread is running.
+        /// </summary>
+        public unsafe void EnableOutputFrames(MeshState* state)
+        {
+            Native.EnableOutputFrames(state);
+
+            _frames = new FrameArrays[Native.OutputFrameCount];
+            for (var i = 0; i < _frames.Length; i++)
+                _frames[i] = new FrameArrays(Native.GetOutputFrame(state, i));
+        }
+
         /// <summary>
         /// Applies changes to the C++ State to this instance. Use this to copy changes from Col to RowMajor.<p/>
         /// Can and should be called from a worker thread. Behind the scenes this tranposes and copies the matrices.<p/>
@@ -159,6 +252,10 @@ namespace Libigl
             // Copy over and transpose data that has changed
             Native.ApplyDirty(state, _native, inputState.VisibleSelectionMask);
 
+            // With output frames the dirty state is published with the frame, see ApplyFrameToMesh
+            if (UsesOutputFrames)
+                return;
+
             DirtyState |= state->DirtyState;
             DirtySelections |= state->DirtySelections;
             DirtySelectionsResized |= state->DirtySelectionsResized;
@@ -171,35 +268,66 @@ namespace Libigl
         /// <remarks>Assert: <see cref="IsRowMajor"/> is true.</remarks>
         /// </summary>
         public void ApplyDirtyToMesh(Mesh mesh)
+        {
+            ApplyToMesh(mesh, DirtyState, V, N, C, UV, F);
+
+            DirtyState = DirtyFlag.None;
+            DirtySelections = 0;
+            DirtySelectionsResized = 0;
+        }
+
+        /// <summary>
+        /// Apply the latest output frame published by <see cref="Native.ApplyDirty"/> to the Unity mesh,
+        /// if there is a new one. The worker thread may be running meanwhile, see <see cref="EnableOutputFrames"/>.<p/>
+        /// Must be called on the main thread as it accesses the Unity API.
+        /// </summary>
+        /// <returns>The <see cref="DirtyFlag"/> state of the frame that was applied, <see cref="DirtyFlag.None"/> if none</returns>
+        public unsafe uint ApplyFrameToMesh(MeshState* state, Mesh mesh)
+        {
+            var frame = Native.AcquireOutputFrame(state, out var dirtyState);
+            if (frame < 0)
+                return DirtyFlag.None;
+
+            var arrays = _frames[frame];
+            ApplyToMesh(mesh, dirtyState, arrays.V, arrays.N, arrays.C, arrays.UV, arrays.F);
+            return dirtyState;
+        }
+
+        /// <summary>
+        /// Set the attributes of the Unity mesh that are dirty in <paramref name="dirtyState"/>
+        /// </summary>
+        private void ApplyToMesh(Mesh mesh, uint dirtyState, NativeArray<Vector3> v, NativeArray<Vector3> n,
+            NativeArray<Color> c, NativeArray<Vector2> uv, NativeArray<int> f)
         {
             Assert.IsTrue(IsRowMajor, "Data must be in RowMajor format to apply changes to the Unity mesh.");
 
-            if ((DirtyState & DirtyFlag.VDirty) > 0)
+            if ((dirtyState & DirtyFlag.VUploaded) > 0)
+            {
+                // The vertices have been staged in C++, the render thread copies them to the GPU
+                Graphics.ExecuteCommandBuffer(_uploadCommands);
+            }
+            else if ((dirtyState & DirtyFlag.VDirty) > 0)
             {
-                mesh.SetVertices(V);
-                if ((DirtyState & DirtyFlag.DontComputeBounds) == 0)
+                mesh.SetVertices(v);
+                if ((dirtyState & DirtyFlag.DontComputeBounds) == 0)
                     mesh.RecalculateBounds();
-                if ((DirtyState & DirtyFlag.DontComputeNormals & DirtyState & DirtyFlag.NDirty) == 0)
+                if ((dirtyState & DirtyFlag.DontComputeNormals & dirtyState & DirtyFlag.NDirty) == 0)
                     mesh.RecalculateNormals();
             }
 
-            if ((DirtyState & DirtyFlag.NDirty) > 0)
-                mesh.SetNormals(N);
-            if ((DirtyState & DirtyFlag.CDirty) > 0)
-                mesh.SetColors(C);
-            if ((DirtyState & DirtyFlag.UVDirty) > 0)
-                mesh.SetUVs(0, UV);
-            if ((DirtyState & DirtyFlag.FDirty) > 0)
-                mesh.SetIndices(F, MeshTopology.Triangles, 0);
+            if ((dirtyState & DirtyFlag.NDirty) > 0)
+                mesh.SetNormals(n);
+            if ((dirtyState & DirtyFlag.CDirty) > 0)
+                mesh.SetColors(c);
+            if ((dirtyState & DirtyFlag.UVDirty) > 0)
+                mesh.SetUVs(0, uv);
+            if ((dirtyState & DirtyFlag.FDirty) > 0)
+                mesh.SetIndices(f, MeshTopology.Triangles, 0);
             // if (DirtySelections > 0)
             // mesh.SetUVs(1, SPtr);
             // BUG: mesh.SetUVs is from the older API and expects a Vector2[] (floats)
             // Unsupported conversion of vertex data (format 11 to 0, dimensions 1 to 1)
             // UnityEngine.Mesh:SetUVs(Int32, NativeArray`1)
-
-            DirtyState = DirtyFlag.None;
-            DirtySelections = 0;
-            DirtySelectionsResized = 0;
         }
 
         /// <summary> 
@@ -220,7 +348,11 @@ namespace Libigl
             if (C.IsCreated) C.Dispose();
             if (UV.IsCreated) UV.Dispose();
             if (F.IsCreated) F.Dispose();
-            // S disposed by C++
+            // S and the native upload data disposed by C++
+            _uploadCommands?.Release();
+            _uploadCommands = null;
+            // The output frames are deleted with the state
+            _frames = null;
         }
     }
 }
\ No newline at end of file
@@ -0,0 +1,164 @@
+/**
+ * Micro-benchmarks of the selection kernels on a generated grid mesh.
+ * Compares the throughput in vertices per second of the kernels in SelectionKernels.h to the previous
+ * implementation, which applied the SelectionMode through a std::function per element of an Eigen binaryExpr.
+ * Each kernel is run with the full 32 bit selections and with the 8 bit compact storage.
+ *
+ * Usage: libigl-bench [vertices] [repeat]
+ */
+#include "Native.h"
+#include "Storage.h"
+#include "SelectionKernels.h"
+#include "MeshGenerator.h"
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+
+static void UNITY_INTERFACE_API Print(const char* message)
+{
+	std::cout << message << std::endl;
+}
+
+// --- Previous implementation, for comparison
+static void ReferenceSelectSphere(MeshState* state, Vector3 position, float radius, int selectionId,
+                                  unsigned int selectionMode)
+{
+	const Eigen::RowVector3f posEigen = position.AsEigenRow();
+	const float radiusSqr = radius * radius;
+
+	using BinaryExpr = const std::function<int(int, int)>;
+	BinaryExpr AddSelection = [&](int a, int s) -> int { return a << selectionId | s; };
+	BinaryExpr SubtractSelection = [&](int a, int s) -> int { return ~(a << selectionId) & s; };
+	BinaryExpr ToggleSelection = [&](int a, int s) -> int { return a << selectionId ^ s; };
+
+	BinaryExpr* Apply = selectionMode == SelectionMode::Add ? &AddSelection
+	                    : selectionMode == SelectionMode::Subtract ? &SubtractSelection : &ToggleSelection;
+
+	VisitS(state, [&](auto& S) {
+		using Scalar = typename std::decay<decltype(S)>::type::Scalar;
+		S = ((state->V->rowwise() - posEigen).array().square().matrix().rowwise().sum().array() < radiusSqr)
+				.cast<int>().matrix()
+				.binaryExpr(S.template cast<int>(), *Apply)
+				.template cast<Scalar>();
+	});
+}
+
+static unsigned int ReferenceGetSelectionMaskSphere(MeshState* state, Vector3 position, float radius)
+{
+	const Eigen::RowVector3f posEigen = position.AsEigenRow();
+	const float radiusSqr = radius * radius;
+	unsigned int mask = 0;
+	VisitS(state, [&](const auto& S) {
+		mask = ((state->V->rowwise() - posEigen).array().square().matrix().rowwise().sum().array() < radiusSqr)
+				.cast<int>().matrix()
+				.cwiseProduct(S.template cast<int>())
+				.redux([](const int a, const int b) -> int { return a | b; });
+	});
+	return mask;
+}
+
+// --- Benchmarks
+/**
+ * @return Vertices per second of <code>fn</code>, run <code>repeat</code> times after a warm up
+ */
+template<typename Fn>
+static double Throughput(MeshState* state, int repeat, Fn&& fn)
+{
+	fn();
+	const auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < repeat; ++i)
+		fn();
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return (double) state->VSize * repeat / seconds;
+}
+
+/**
+ * @return The selection vector widened to 32 bits, to compare the results
+ */
+static Eigen::VectorXi GetS(MeshState* state)
+{
+	Eigen::VectorXi S;
+	VisitS(state, [&](const auto& s) { S = s.template cast<int>(); });
+	return S;
+}
+
+static void SetS(MeshState* state, const Eigen::VectorXi& S)
+{
+	VisitS(state, [&](auto& s) {
+		using Scalar = typename std::decay<decltype(s)>::type::Scalar;
+		s = S.cast<Scalar>();
+	});
+}
+
+static void PrintRow(const char* name, double reference, double kernel, bool equal)
+{
+	std::cout << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(1)
+	          << std::setw(16) << reference * 1e-6 << std::setw(16) << kernel * 1e-6
+	          << std::setw(10) << kernel / reference << "x" << (equal ? "" : "  MISMATCH") << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+	const int vertices = argc > 1 ? std::max(4, std::atoi(argv[1])) : 1000000;
+	const int repeat = argc > 2 ? std::max(1, std::atoi(argv[2])) : 20;
+
+	Initialize(Print, Print, Print);
+
+	GeneratedMesh mesh = GenerateGrid(vertices);
+	MeshState* state = InitializeMesh(mesh.Data(), "Grid");
+	state->EnsureInitialized();
+	std::cout << state->VSize << " vertices, " << repeat << " repetitions, " << GetWorkerThreads() << " threads"
+	          << std::endl;
+
+	const Vector3 center(0.5f, 0.5f, 0.f);
+	const float radius = 0.25f;
+	const int selectionId = 3;
+	const char* modeNames[] = {"Add", "Subtract", "Toggle"};
+
+	std::cout << std::left << std::setw(28) << "[M vertices/s]" << std::right << std::setw(16) << "Reference"
+	          << std::setw(16) << "Kernel" << std::setw(11) << "Speedup" << std::endl;
+	for (const bool compact : {false, true})
+	{
+		SetCompactStorage(state, compact);
+		// Start with some vertices in the selection, so Subtract and Toggle have an effect
+		ClearSelectionMask(state, -1);
+		SelectSphere(state, Vector3(0.4f, 0.4f, 0.f), radius, selectionId, SelectionMode::Add);
+		const Eigen::VectorXi S0 = GetS(state);
+
+		for (unsigned int mode = SelectionMode::Add; mode <= SelectionMode::Toggle; ++mode)
+		{
+			SetS(state, S0);
+			ReferenceSelectSphere(state, center, radius, selectionId, mode);
+			const Eigen::VectorXi expected = GetS(state);
+			SetS(state, S0);
+			SelectSphere(state, center, radius, selectionId, mode);
+			const bool equal = GetS(state) == expected;
+
+			const double reference = Throughput(state, repeat, [&]() {
+				ReferenceSelectSphere(state, center, radius, selectionId, mode);
+			});
+			const double kernel = Throughput(state, repeat, [&]() {
+				SelectSphere(state, center, radius, selectionId, mode);
+			});
+
+			const std::string name = std::string("SelectSphere ") + modeNames[mode] + (compact ? " S8" : " S32");
+			PrintRow(name.c_str(), reference, kernel, equal);
+		}
+
+		SetS(state, S0);
+		const bool equal = ReferenceGetSelectionMaskSphere(state, center, radius) ==
+		                   GetSelectionMaskSphere(state, center, radius);
+		const double reference = Throughput(state, repeat, [&]() {
+			ReferenceGetSelectionMaskSphere(state, center, radius);
+		});
+		const double kernel = Throughput(state, repeat, [&]() {
+			GetSelectionMaskSphere(state, center, radius);
+		});
+		PrintRow(compact ? "GetSelectionMask S8" : "GetSelectionMask S32", reference, kernel, equal);
+	}
+
+	DisposeMesh(state);
+	return 0;
+}
@@ -0,0 +1,271 @@
+#include "MeshGenerator.h"
+#include <igl/PI.h>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <random>
+#include <utility>
+
+// --- GeneratedMesh
+UMeshDataNative GeneratedMesh::Data()
+{
+	return {V.data(), N.data(), C.data(), UV.data(), F.data(), VSize(), FSize()};
+}
+
+void GeneratedMesh::Resize(int VSize, int FSize)
+{
+	V.resize(3 * VSize);
+	N.resize(3 * VSize);
+	C.assign(4 * VSize, 1.f);
+	UV.resize(2 * VSize);
+	F.resize(3 * FSize);
+}
+
+void GeneratedMesh::ComputeNormals()
+{
+	using RowMatrix3f = Eigen::Matrix<float, Eigen::Dynamic, 3, Eigen::RowMajor>;
+	Eigen::Map<const RowMatrix3f> positions(V.data(), VSize(), 3);
+	Eigen::Map<RowMatrix3f> normals(N.data(), VSize(), 3);
+	normals.setZero();
+	for (int f = 0; f < FSize(); ++f)
+	{
+		const int a = F[3 * f], b = F[3 * f + 1], c = F[3 * f + 2];
+		// The cross product is twice the area times the normal
+		const Eigen::RowVector3f n = (positions.row(b) - positions.row(a)).cross(positions.row(c) - positions.row(a));
+		normals.row(a) += n;
+		normals.row(b) += n;
+		normals.row(c) += n;
+	}
+	normals.rowwise().normalize();
+}
+
+void GeneratedMesh::Append(const GeneratedMesh& other)
+{
+	const int offset = VSize();
+	V.insert(V.end(), other.V.begin(), other.V.end());
+	N.insert(N.end(), other.N.begin(), other.N.end());
+	C.insert(C.end(), other.C.begin(), other.C.end());
+	UV.insert(UV.end(), other.UV.begin(), other.UV.end());
+	F.reserve(F.size() + other.F.size());
+	for (const int i : other.F)
+		F.push_back(i + offset);
+}
+
+// --- Generators
+/**
+ * Grid of n x n vertices in [0, 1]^2 in the xy-plane, row i has the vertices i * n to (i + 1) * n
+ */
+static GeneratedMesh GenerateGridN(int n)
+{
+	GeneratedMesh mesh;
+	mesh.Resize(n * n, 2 * (n - 1) * (n - 1));
+	for (int i = 0; i < n; ++i)
+		for (int j = 0; j < n; ++j)
+		{
+			const int k = i * n + j;
+			mesh.V[3 * k] = mesh.UV[2 * k] = (float) i / (n - 1);
+			mesh.V[3 * k + 1] = mesh.UV[2 * k + 1] = (float) j / (n - 1);
+			mesh.V[3 * k + 2] = 0.f;
+			mesh.N[3 * k] = mesh.N[3 * k + 1] = 0.f;
+			mesh.N[3 * k + 2] = 1.f;
+		}
+
+	for (int i = 0, f = 0; i + 1 < n; ++i)
+		for (int j = 0; j + 1 < n; ++j, f += 2)
+		{
+			const int a = i * n + j;
+			const int faces[6] = {a, a + 1, a + n, a + 1, a + n + 1, a + n};
+			std::copy(faces, faces + 6, mesh.F.begin() + 3 * f);
+		}
+	return mesh;
+}
+
+GeneratedMesh GenerateGrid(int vertices)
+{
+	return GenerateGridN(std::max(2, (int) std::sqrt((double) vertices)));
+}
+
+/**
+ * Geodesic sphere of frequency n, each face of the icosahedron is split into n^2 triangles.
+ * The vertices are the 12 corners, then n - 1 per edge, then (n - 1)(n - 2) / 2 inside each face.
+ */
+static GeneratedMesh GenerateSphereN(int n)
+{
+	const float t = (1.f + std::sqrt(5.f)) / 2.f;
+	const Eigen::Vector3f corners[12] = {
+			{-1, t, 0}, {1, t, 0}, {-1, -t, 0}, {1, -t, 0}, {0, -1, t}, {0, 1, t},
+			{0, -1, -t}, {0, 1, -t}, {t, 0, -1}, {t, 0, 1}, {-t, 0, -1}, {-t, 0, 1}};
+	const int faces[20][3] = {
+			{0, 11, 5}, {0, 5, 1}, {0, 1, 7}, {0, 7, 10}, {0, 10, 11}, {1, 5, 9}, {5, 11, 4}, {11, 10, 2},
+			{10, 7, 6}, {7, 1, 8}, {3, 9, 4}, {3, 4, 2}, {3, 2, 6}, {3, 6, 8}, {3, 8, 9}, {4, 9, 5},
+			{2, 4, 11}, {6, 2, 10}, {8, 6, 7}, {9, 8, 1}};
+
+	std::map<std::pair<int, int>, int> edges;
+	for (const auto& face : faces)
+		for (int k = 0; k < 3; ++k)
+		{
+			const int u = face[k], v = face[(k + 1) % 3];
+			edges.emplace(std::make_pair(std::min(u, v), std::max(u, v)), edges.size());
+		}
+
+	const int edgeBase = 12;
+	const int faceBase = edgeBase + 30 * (n - 1);
+	const int perFace = (n - 1) * (n - 2) / 2;
+
+	GeneratedMesh mesh;
+	mesh.Resize(faceBase + 20 * perFace, 20 * n * n);
+	auto setVertex = [&](int index, const Eigen::Vector3f& position) {
+		const Eigen::Vector3f p = position.normalized();
+		std::copy(p.data(), p.data() + 3, mesh.V.begin() + 3 * index);
+		std::copy(p.data(), p.data() + 3, mesh.N.begin() + 3 * index);
+		mesh.UV[2 * index] = 0.5f + std::atan2(p.z(), p.x()) / (2.f * (float) igl::PI);
+		mesh.UV[2 * index + 1] = 0.5f + std::asin(p.y()) / (float) igl::PI;
+	};
+
+	for (int i = 0; i < 12; ++i)
+		setVertex(i, corners[i]);
+	for (const auto& edge : edges)
+		for (int s = 1; s < n; ++s)
+			setVertex(edgeBase + edge.second * (n - 1) + s - 1,
+			          corners[edge.first.first] + (corners[edge.first.second] - corners[edge.first.first]) * s / n);
+
+	// s-th vertex from u towards v on the edge uv
+	auto edgeVertex = [&](int u, int v, int s) -> int {
+		const int id = edges[std::make_pair(std::min(u, v), std::max(u, v))];
+		return edgeBase + id * (n - 1) + (u < v ? s : n - s) - 1;
+	};
+
+	for (int f = 0; f < 20; ++f)
+	{
+		const int a = faces[f][0], b = faces[f][1], c = faces[f][2];
+		// Vertex at a + (b - a) i / n + (c - a) j / n
+		auto index = [&](int i, int j) -> int {
+			if (i == 0 && j == 0)
+				return a;
+			if (i == n)
+				return b;
+			if (j == n)
+				return c;
+			if (j == 0)
+				return edgeVertex(a, b, i);
+			if (i == 0)
+				return edgeVertex(a, c, j);
+			if (i + j == n)
+				return edgeVertex(b, c, j);
+			return faceBase + f * perFace + (i - 1) * (n - 1) - (i - 1) * i / 2 + j - 1;
+		};
+
+		for (int i = 1; i < n; ++i)
+			for (int j = 1; i + j < n; ++j)
+				setVertex(index(i, j), corners[a] + ((corners[b] - corners[a]) * i + (corners[c] - corners[a]) * j) / n);
+
+		int* F = mesh.F.data() + 3 * f * n * n;
+		for (int i = 0; i < n; ++i)
+			for (int j = 0; i + j < n; ++j)
+			{
+				*F++ = index(i, j);
+				*F++ = index(i + 1, j);
+				*F++ = index(i, j + 1);
+				if (i + j + 1 < n)
+				{
+					*F++ = index(i + 1, j);
+					*F++ = index(i + 1, j + 1);
+					*F++ = index(i, j + 1);
+				}
+			}
+	}
+	return mesh;
+}
+
+GeneratedMesh GenerateSphere(int vertices)
+{
+	return GenerateSphereN(std::max(1, (int) std::ceil(std::sqrt((vertices - 2) / 10.0))));
+}
+
+/**
+ * Smooth value noise in [0, 1), bilinear interpolation with smoothstep of hashed lattice values
+ */
+static float ValueNoise(float x, float y, unsigned int seed)
+{
+	auto hash = [seed](int ix, int iy) -> float {
+		unsigned int h = seed * 0x9e3779b9u ^ (unsigned int) ix * 0x85ebca6bu ^ (unsigned int) iy * 0xc2b2ae35u;
+		h ^= h >> 16;
+		h *= 0x7feb352du;
+		h ^= h >> 15;
+		return (h & 0xffffff) / (float) 0x1000000;
+	};
+	const int ix = (int) std::floor(x), iy = (int) std::floor(y);
+	const float fx = x - ix, fy = y - iy;
+	const float sx = fx * fx * (3.f - 2.f * fx), sy = fy * fy * (3.f - 2.f * fy);
+	const float top = hash(ix, iy) + (hash(ix + 1, iy) - hash(ix, iy)) * sx;
+	const float bottom = hash(ix, iy + 1) + (hash(ix + 1, iy + 1) - hash(ix, iy + 1)) * sx;
+	return top + (bottom - top) * sy;
+}
+
+GeneratedMesh GenerateScan(int vertices, unsigned int seed)
+{
+	GeneratedMesh mesh = GenerateGrid(vertices);
+	const int n = (int) std::sqrt((double) mesh.VSize());
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> jitter(-0.25f / n, 0.25f / n);
+	std::normal_distribution<float> noise(0.f, 0.1f / n);
+
+	for (int i = 0; i < mesh.VSize(); ++i)
+	{
+		float* p = mesh.V.data() + 3 * i;
+		float height = 0.f;
+		for (int octave = 0; octave < 6; ++octave)
+		{
+			const float frequency = 4.f * (1 << octave);
+			height += ValueNoise(p[0] * frequency, p[1] * frequency, seed + octave) * 0.15f / (1 << octave);
+		}
+		p[0] += jitter(random);
+		p[1] += jitter(random);
+		p[2] = height + noise(random);
+	}
+	mesh.ComputeNormals();
+	return mesh;
+}
+
+GeneratedMesh GenerateComponents(int vertices, int components, unsigned int seed)
+{
+	components = std::max(1, components);
+	// One sphere per cell of a lattice so they are disjoint, with a random offset in the cell
+	const int cells = (int) std::ceil(std::cbrt((double) components));
+	const float cell = 1.f / cells;
+	const float radius = 0.35f * cell;
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> offset(-0.1f * cell, 0.1f * cell);
+
+	const GeneratedMesh sphere = GenerateSphere(std::max(12, vertices / components));
+	GeneratedMesh mesh;
+	mesh.V.reserve(sphere.V.size() * components);
+	mesh.F.reserve(sphere.F.size() * components);
+	for (int c = 0; c < components; ++c)
+	{
+		const Eigen::Vector3f center((c % cells + 0.5f) * cell + offset(random),
+		                             (c / cells % cells + 0.5f) * cell + offset(random),
+		                             (c / (cells * cells) + 0.5f) * cell + offset(random));
+		GeneratedMesh component = sphere;
+		for (int i = 0; i < component.VSize(); ++i)
+			for (int k = 0; k < 3; ++k)
+				component.V[3 * i + k] = center(k) + radius * sphere.V[3 * i + k];
+		mesh.Append(component);
+	}
+	return mesh;
+}
+
+bool GenerateMesh(const std::string& kind, int vertices, GeneratedMesh& mesh, unsigned int seed)
+{
+	if (kind == "grid")
+		mesh = GenerateGrid(vertices);
+	else if (kind == "sphere")
+		mesh = GenerateSphere(vertices);
+	else if (kind == "scan")
+		mesh = GenerateScan(vertices, seed);
+	else if (kind == "components")
+		mesh = GenerateComponents(vertices, 1000, seed);
+	else
+		return false;
+	return true;
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "InterfaceTypes.h"
+#include <string>
+#include <vector>
+
+/**
+ * A generated mesh in the row major layout of the Unity mesh data, pass Data() to InitializeMesh
+ */
+struct GeneratedMesh
+{
+	std::vector<float> V;
+	std::vector<float> N;
+	std::vector<float> C;
+	std::vector<float> UV;
+	std::vector<int> F;
+
+	int VSize() const
+	{ return V.size() / 3; }
+
+	int FSize() const
+	{ return F.size() / 3; }
+
+	/** @return Pointers to the attributes, valid as long as the mesh is not modified */
+	UMeshDataNative Data();
+
+	/** Resize the attributes, C is white */
+	void Resize(int VSize, int FSize);
+
+	/** Area weighted vertex normals of the faces */
+	void ComputeNormals();
+
+	/** Append another mesh, its faces are offset by the vertices of this mesh */
+	void Append(const GeneratedMesh& other);
+};
+
+/**
+ * A square grid in the xy-plane in [0, 1]^2 with n x n vertices, n is the root of <code>vertices</code>
+ */
+GeneratedMesh GenerateGrid(int vertices);
+
+/**
+ * A unit sphere from an icosahedron with each face subdivided into a triangular grid (a geodesic sphere),
+ * with the frequency chosen so it has at least <code>vertices</code> vertices, i.e. 10 n^2 + 2
+ */
+GeneratedMesh GenerateSphere(int vertices);
+
+/**
+ * A grid in [0, 1]^2 displaced along z by a few octaves of smooth noise, with per vertex jitter in all directions,
+ * approximating a photogrammetry scan of a terrain or surface
+ */
+GeneratedMesh GenerateScan(int vertices, unsigned int seed = 1);
+
+/**
+ * Many small disjoint spheres scattered in [0, 1]^3, with about <code>vertices</code> vertices in total
+ */
+GeneratedMesh GenerateComponents(int vertices, int components, unsigned int seed = 1);
+
+/**
+ * Generate a mesh by name: grid, sphere, scan or components (with 1000 components)
+ * @return False if the kind is unknown
+ */
+bool GenerateMesh(const std::string& kind, int vertices, GeneratedMesh& mesh, unsigned int seed = 1);
@@ -0,0 +1,257 @@
+/**
+ * Stress test of the native library on a large generated mesh, see MeshGenerator.h.
+ * Runs InitializeMesh, a random stream of selections and transformations each followed by ApplyDirty, and Arap,
+ * then reports for each phase the time, the throughput, the number of heap allocations and the peak resident memory.
+ *
+ * Usage: libigl-stress <grid|sphere|scan|components> [vertices] [operations] [arapIterations] [seed] [reorder]
+ */
+#include "Native.h"
+#include "Util.h"
+#include "MeshGenerator.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// --- Allocation counting
+static std::atomic<unsigned long long> Allocations{0};
+
+#if defined(__GLIBC__)
+// Interpose malloc, so the allocations of Eigen and libigl are counted as well as operator new
+extern "C"
+{
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+
+void* malloc(size_t size)
+{
+	Allocations.fetch_add(1, std::memory_order_relaxed);
+	return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size)
+{
+	Allocations.fetch_add(1, std::memory_order_relaxed);
+	return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+	Allocations.fetch_add(1, std::memory_order_relaxed);
+	return __libc_realloc(ptr, size);
+}
+}
+#else
+// Only operator new can be replaced portably, allocations of Eigen with malloc are not counted
+void* operator new(size_t size)
+{
+	Allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* ptr = std::malloc(size > 0 ? size : 1))
+		return ptr;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+#endif
+
+/**
+ * @return Peak resident memory of the process in bytes
+ */
+static size_t GetPeakMemory()
+{
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS counters;
+	GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+	return counters.PeakWorkingSetSize;
+#else
+	rusage usage{};
+	getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+	return usage.ru_maxrss;
+#else
+	return (size_t) usage.ru_maxrss * 1024;
+#endif
+#endif
+}
+
+static void UNITY_INTERFACE_API PrintQuiet(const char*)
+{}
+
+static void UNITY_INTERFACE_API Print(const char* message)
+{
+	std::cout << message << std::endl;
+}
+
+// --- Phases
+/**
+ * Timing and allocations of all calls of one kind
+ */
+struct Phase
+{
+	const char* Name;
+	int Calls{0};
+	double Total{0};
+	double Max{0};
+	unsigned long long Allocations{0};
+
+	explicit Phase(const char* name) : Name(name)
+	{}
+
+	template<typename Fn>
+	void Run(Fn&& fn)
+	{
+		const unsigned long long allocations = ::Allocations.load();
+		const auto start = std::chrono::steady_clock::now();
+		fn();
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		Allocations += ::Allocations.load() - allocations;
+		Total += seconds;
+		Max = std::max(Max, seconds);
+		++Calls;
+	}
+
+	void Print(int VSize) const
+	{
+		if (Calls == 0)
+			return;
+		std::cout << std::left << std::setw(20) << Name << std::right << std::fixed << std::setprecision(2)
+		          << std::setw(8) << Calls << std::setw(12) << Total * 1e3 << std::setw(12) << Total * 1e3 / Calls
+		          << std::setw(12) << Max * 1e3 << std::setw(12) << (double) VSize * Calls / Total * 1e-6
+		          << std::setw(12) << (double) Allocations / Calls << std::endl;
+	}
+};
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		std::cout << "Usage: libigl-stress <grid|sphere|scan|components> [vertices] [operations] [arapIterations] [seed] [reorder]"
+		          << std::endl;
+		return 1;
+	}
+	const std::string kind = argv[1];
+	const int vertices = argc > 2 ? std::max(4, std::atoi(argv[2])) : 1000000;
+	const int operations = argc > 3 ? std::max(0, std::atoi(argv[3])) : 200;
+	const int arapIterations = argc > 4 ? std::max(0, std::atoi(argv[4])) : 5;
+	const unsigned int seed = argc > 5 ? (unsigned int) std::atoi(argv[5]) : 1;
+	const bool reorder = argc > 6 && std::atoi(argv[6]) != 0;
+
+	Initialize(PrintQuiet, Print, Print);
+
+	Phase generate("Generate");
+	Phase initialize("InitializeMesh");
+	Phase select("SelectSphere");
+	Phase translate("TranslateSelection");
+	Phase transform("TransformSelection");
+	Phase applyDirty("ApplyDirty");
+	Phase arapFirst("Arap (precompute)");
+	Phase arap("Arap");
+
+	GeneratedMesh mesh;
+	bool valid = true;
+	generate.Run([&]() { valid = GenerateMesh(kind, vertices, mesh, seed); });
+	if (!valid)
+	{
+		std::cout << "Unknown mesh kind " << kind << std::endl;
+		return 1;
+	}
+	const UMeshDataNative data = mesh.Data();
+
+	MeshState* state = nullptr;
+	initialize.Run([&]() {
+		state = InitializeMesh(data, kind.c_str(), reorder);
+		state->EnsureInitialized();
+	});
+	std::cout << kind << ": " << state->VSize << " vertices, " << state->FSize << " faces, " << GetWorkerThreads()
+	          << " threads" << std::endl;
+	applyDirty.Run([&]() { ApplyDirty(state, data, -1); });
+
+	// Brushes are centered on random vertices with a radius relative to the size of the mesh
+	std::mt19937 random(seed);
+	std::uniform_int_distribution<int> vertex(0, state->VSize - 1);
+	std::uniform_int_distribution<int> selectionId(0, 3);
+	std::uniform_int_distribution<unsigned int> selectionMode(SelectionMode::Add, SelectionMode::Toggle);
+	std::uniform_real_distribution<float> unit(-1.f, 1.f);
+	const float size = (state->V->colwise().maxCoeff() - state->V->colwise().minCoeff()).norm();
+	std::uniform_real_distribution<float> radius(0.02f * size, 0.1f * size);
+	auto randomVertex = [&]() {
+		return Vector3(Eigen::Vector3f(state->V->row(vertex(random)).transpose()));
+	};
+
+	for (int i = 0; i < operations; ++i)
+	{
+		switch (random() % 3)
+		{
+			case 0:
+				select.Run([&]() {
+					SelectSphere(state, randomVertex(), radius(random), selectionId(random), selectionMode(random));
+				});
+				break;
+			case 1:
+				translate.Run([&]() {
+					const Eigen::Vector3f translation(unit(random), unit(random), unit(random));
+					TranslateSelection(state, Vector3(0.01f * size * translation), 1u << selectionId(random));
+				});
+				break;
+			default:
+			{
+				const unsigned int mask = 1u << selectionId(random);
+				Eigen::Quaternionf rotation(Eigen::AngleAxisf(0.1f * unit(random),
+				                                              Eigen::Vector3f(unit(random), unit(random), 1.f).normalized()));
+				transform.Run([&]() {
+					TransformSelection(state, Vector3::Zero(), 1.f + 0.05f * unit(random), Quaternion(rotation),
+					                   GetSelectionCenter(state, mask), mask);
+				});
+				break;
+			}
+		}
+		applyDirty.Run([&]() { ApplyDirty(state, data, -1); });
+	}
+
+	if (arapIterations > 0)
+	{
+		// A fixed and a moving handle around random vertices
+		ClearSelectionMask(state, -1);
+		const Vector3 fixed = randomVertex();
+		const Vector3 handle = randomVertex();
+		SelectSphere(state, fixed, 0.1f * size, 0);
+		SelectSphere(state, handle, 0.1f * size, 1, SelectionMode::Add);
+		for (int i = 0; i < arapIterations; ++i)
+		{
+			TranslateSelection(state, Vector3(0.f, 0.f, 0.02f * size), 1u << 1);
+			(i == 0 ? arapFirst : arap).Run([&]() { Arap(state, 0b11); });
+			applyDirty.Run([&]() { ApplyDirty(state, data, -1); });
+		}
+	}
+
+	std::cout << std::left << std::setw(20) << "Phase" << std::right << std::setw(8) << "Calls" << std::setw(12)
+	          << "Total ms" << std::setw(12) << "Mean ms" << std::setw(12) << "Max ms" << std::setw(12) << "M vert/s"
+	          << std::setw(12) << "Allocs/call" << std::endl;
+	for (const Phase* phase : {&generate, &initialize, &select, &translate, &transform, &applyDirty, &arapFirst, &arap})
+		phase->Print(state->VSize);
+
+	std::cout << "Mesh memory " << GetMeshMemoryUsage(state) / (1024 * 1024) << " MB, peak resident memory "
+	          << GetPeakMemory() / (1024 * 1024) << " MB" << std::endl;
+
+	DisposeMesh(state);
+	return 0;
+}
@@ -0,0 +1,111 @@
+/**
+ * Headless test of the native vertex upload with the CPU RenderAPI, see EnableNativeUpload and CreateRenderAPI_CPU.
+ * Stages transformed vertices with ApplyDirty and uploads them with UploadMesh into a CpuVertexBuffer, as the render
+ * thread would, and checks the buffer against V. Exits with 1 if a check fails.
+ *
+ * Usage: libigl-upload-test [vertices]
+ */
+#include "Native.h"
+#include "Upload.h"
+#include "MeshGenerator.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+static void UNITY_INTERFACE_API PrintQuiet(const char*)
+{}
+
+static void UNITY_INTERFACE_API Print(const char* message)
+{
+	std::cout << message << std::endl;
+}
+
+static int Failures = 0;
+
+static void Check(bool condition, const char* name)
+{
+	std::cout << (condition ? "passed: " : "FAILED: ") << name << std::endl;
+	if (!condition)
+		++Failures;
+}
+
+/**
+ * @return True if the vertices [begin, end) of the row major buffer are those of V
+ */
+static bool IsUploaded(const std::vector<float>& buffer, const Eigen::MatrixXf& V, int begin, int end)
+{
+	for (int i = begin; i < end; ++i)
+		for (int c = 0; c < 3; ++c)
+			if (buffer[3 * i + c] != V(i, c))
+				return false;
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	const int vertices = argc > 1 ? std::max(4, std::atoi(argv[1])) : 10000;
+	Initialize(PrintQuiet, Print, Print);
+
+	GeneratedMesh mesh = GenerateGrid(vertices);
+	const UMeshDataNative data = mesh.Data();
+	MeshState* state = InitializeMesh(data, "grid");
+	state->EnsureInitialized();
+	const int VSize = state->VSize;
+
+	std::vector<float> gpu(3 * VSize, 0.f);
+	CpuVertexBuffer buffer{gpu.data(), gpu.size() * sizeof(float)};
+
+	// Without a RenderAPI, e.g. on the null graphics device, the managed upload must be used
+	SetRenderAPI(nullptr);
+	Check(EnableNativeUpload(state, &buffer) == nullptr, "no native upload without a RenderAPI");
+
+	SetRenderAPI(CreateRenderAPI_CPU());
+	VertexUploadData* upload = EnableNativeUpload(state, &buffer);
+	Check(upload != nullptr, "native upload with the CPU RenderAPI");
+	if (upload == nullptr)
+		return 1;
+
+	UploadMesh(0, upload);
+	Check(IsUploaded(gpu, *state->V, 0, VSize), "initial upload of all vertices");
+
+	// Only the dirty range is uploaded, the first vertex is not in the selection at the opposite corner
+	const float marker = -1.f;
+	gpu[0] = marker;
+	SelectSphere(state, Vector3(1.f, 1.f, 0.f), 0.2f, 0, SelectionMode::Add);
+	TranslateSelection(state, Vector3(0.f, 0.f, 0.5f), 1);
+	ApplyDirty(state, data, -1);
+	Check((state->DirtyState & DirtyFlag::VUploaded) != 0, "ApplyDirty stages V instead of writing it");
+	Check(mesh.V[3 * (VSize - 1) + 2] == 0.f, "managed vertices are not written");
+	UploadMesh(0, upload);
+	Check(IsUploaded(gpu, *state->V, 1, VSize), "upload of the dirty range");
+	Check(gpu[0] == marker, "vertices outside the dirty range are not uploaded");
+
+	// A second upload without a new ApplyDirty has nothing to do
+	gpu[3 * (VSize - 1)] = marker;
+	UploadMesh(0, upload);
+	Check(gpu[3 * (VSize - 1)] == marker, "no upload without changes");
+	gpu[3 * (VSize - 1)] = (*state->V)(VSize - 1, 0);
+
+	// A buffer that is too small fails and is retried on the next upload
+	buffer.Size = sizeof(float) * 3 * (VSize - 1);
+	TranslateSelection(state, Vector3(0.f, 0.f, 0.5f), 1);
+	ApplyDirty(state, data, -1);
+	UploadMesh(0, upload);
+	Check(!IsUploaded(gpu, *state->V, 1, VSize), "no upload into a buffer that is too small");
+	buffer.Size = gpu.size() * sizeof(float);
+	UploadMesh(0, upload);
+	Check(IsUploaded(gpu, *state->V, 1, VSize), "retry of the failed upload");
+
+	// Render events may still be queued after the upload was disabled
+	DisableNativeUpload(state);
+	gpu[3 * (VSize - 1)] = marker;
+	UploadMesh(0, upload);
+	Check(gpu[3 * (VSize - 1)] == marker, "no upload after DisableNativeUpload");
+
+	DisposeMesh(state);
+	SetRenderAPI(nullptr);
+
+	std::cout << (Failures == 0 ? "All upload tests passed" : "Upload tests failed") << std::endl;
+	return Failures == 0 ? 0 : 1;
+}
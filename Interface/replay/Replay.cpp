@@ -0,0 +1,303 @@
+/**
+ * Headless replayer for traces recorded with StartTrace, see Trace.h for the format.
+ * Re-runs every recorded call against the mesh snapshots and reports the latency percentiles
+ * per operation and per frame, for the recording and the replay.
+ * A frame of a mesh are all calls since its previous ApplyDirty, including the ApplyDirty.
+ * The calls of a mesh after an untraced call are skipped, see TraceUntraced.
+ *
+ * Usage: libigl-replay <trace> [repeat]
+ */
+#include "Native.h"
+#include "Trace.h"
+#include "Util.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+static void UNITY_INTERFACE_API Print(const char* message)
+{
+	std::cout << message << std::endl;
+}
+
+/**
+ * A mesh of the trace, the buffers are the Unity mesh data used by ApplyDirty
+ */
+struct ReplayMesh
+{
+	MeshState* State{nullptr};
+	std::vector<float> V;
+	std::vector<float> N;
+	std::vector<float> C;
+	std::vector<float> UV;
+	std::vector<int> F;
+	UMeshDataNative Data{};
+
+	/** The first untraced call, the following calls of the mesh are skipped. Empty if there was none. */
+	std::string Untraced;
+	int Skipped{0};
+
+	/** Duration of the current frame so far */
+	long long RecordedFrameNs{0};
+	long long ReplayedFrameNs{0};
+};
+
+/**
+ * Durations of the recording and the replay, one entry per call or frame
+ */
+struct Durations
+{
+	std::vector<long long> Recorded;
+	std::vector<long long> Replayed;
+};
+
+template<typename T>
+static bool Read(std::ifstream& file, T& value)
+{
+	return (bool) file.read(reinterpret_cast<char*>(&value), sizeof(T));
+}
+
+template<typename T>
+static bool Read(std::ifstream& file, std::vector<T>& values, size_t count)
+{
+	values.resize(count);
+	return (bool) file.read(reinterpret_cast<char*>(values.data()), sizeof(T) * count);
+}
+
+/**
+ * Create the mesh from its snapshot, see TraceMesh
+ */
+static bool ReadMesh(std::ifstream& file, std::map<int, ReplayMesh>& meshes)
+{
+	TraceMesh header{};
+	if (!Read(file, header))
+		return false;
+
+	ReplayMesh& mesh = meshes[header.MeshId];
+	std::vector<float> V0;
+	std::vector<unsigned int> S;
+	if (!Read(file, V0, header.VSize * 3) ||
+	    !Read(file, mesh.V, header.VSize * 3) ||
+	    !Read(file, mesh.N, header.VSize * 3) ||
+	    !Read(file, mesh.C, header.VSize * 4) ||
+	    !Read(file, mesh.UV, header.VSize * 2) ||
+	    !Read(file, mesh.F, header.FSize * 3) ||
+	    !Read(file, S, header.VSize))
+		return false;
+
+	UMeshDataNative initData{V0.data(), mesh.N.data(), mesh.C.data(), mesh.UV.data(), mesh.F.data(),
+	                         header.VSize, header.FSize};
+	MeshState* state = InitializeMesh(initData, "Replay");
+	state->EnsureInitialized();
+
+	// Restore the state at the time of the snapshot
+	TransposeFromMap(mesh.V.data(), state->V);
+	TransposeFromMap(mesh.C.data(), state->C);
+	*state->S = Eigen::Map<Eigen::Matrix<unsigned int, Eigen::Dynamic, 1>>(S.data(), header.VSize).cast<int>();
+	state->SSize = header.SSize;
+	if (header.CompactStorage)
+		SetCompactStorage(state, true);
+	state->DirtyState = header.DirtyState;
+	state->DirtySelections = header.DirtySelections;
+	state->DirtySelectionsResized = header.DirtySelectionsResized;
+
+	mesh.State = state;
+	mesh.Data = UMeshDataNative{mesh.V.data(), mesh.N.data(), mesh.C.data(), mesh.UV.data(), mesh.F.data(),
+	                            header.VSize, header.FSize};
+	return true;
+}
+
+/**
+ * Dispose the mesh, reports the calls that were skipped
+ */
+static void DisposeReplayMesh(int meshId, ReplayMesh& mesh)
+{
+	if (mesh.Skipped > 0)
+		std::cerr << "Skipped " << mesh.Skipped << " calls of mesh " << meshId << " after " << mesh.Untraced
+		          << ", which is not recorded" << std::endl;
+	DisposeMesh(mesh.State);
+}
+
+/**
+ * Replay the trace once
+ * @param calls Durations per BatchOp
+ * @param frames Durations per frame
+ * @return False if the trace is invalid
+ */
+static bool Replay(const char* path, std::map<unsigned int, Durations>& calls, Durations& frames)
+{
+	std::ifstream file(path, std::ios::binary);
+	TraceHeader header, expected;
+	if (!Read(file, header) || std::memcmp(header.Magic, expected.Magic, sizeof(header.Magic)) != 0)
+	{
+		std::cerr << "Not a trace: " << path << std::endl;
+		return false;
+	}
+	if (header.Version != expected.Version || header.CallSize != expected.CallSize)
+	{
+		std::cerr << "Trace version " << header.Version << " with call size " << header.CallSize
+		          << " is incompatible, expected version " << expected.Version << " with size "
+		          << expected.CallSize << std::endl;
+		return false;
+	}
+
+	std::map<int, ReplayMesh> meshes;
+	bool valid = true;
+	unsigned int type;
+	while (valid && Read(file, type))
+	{
+		switch (type)
+		{
+			case TraceRecord::Mesh:
+				valid = ReadMesh(file, meshes);
+				break;
+			case TraceRecord::Dispose:
+			{
+				int meshId;
+				valid = Read(file, meshId) && meshes.count(meshId) > 0;
+				if (valid)
+				{
+					DisposeReplayMesh(meshId, meshes[meshId]);
+					meshes.erase(meshId);
+				}
+				break;
+			}
+			case TraceRecord::Untraced:
+			{
+				TraceUntraced untraced{};
+				valid = Read(file, untraced) && meshes.count(untraced.MeshId) > 0;
+				if (valid && meshes[untraced.MeshId].Untraced.empty())
+					meshes[untraced.MeshId].Untraced.assign(untraced.Name, strnlen(untraced.Name, sizeof(untraced.Name)));
+				break;
+			}
+			case TraceRecord::Call:
+			{
+				TraceCall call{};
+				valid = Read(file, call) && meshes.count(call.MeshId) > 0;
+				if (!valid)
+					break;
+
+				ReplayMesh& mesh = meshes[call.MeshId];
+				if (!mesh.Untraced.empty())
+				{
+					mesh.Skipped++;
+					break;
+				}
+				BatchCommand& cmd = call.Command;
+				cmd.State = mesh.State;
+				cmd.Data = mesh.Data;
+
+				BatchResult result{};
+				const auto start = std::chrono::steady_clock::now();
+				ExecuteBatch(&cmd, 1, &result);
+				const long long replayedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+						std::chrono::steady_clock::now() - start).count();
+
+				calls[cmd.Op].Recorded.push_back(call.DurationNs);
+				calls[cmd.Op].Replayed.push_back(replayedNs);
+
+				mesh.RecordedFrameNs += call.DurationNs;
+				mesh.ReplayedFrameNs += replayedNs;
+				if (cmd.Op == BatchOp::ApplyDirty)
+				{
+					frames.Recorded.push_back(mesh.RecordedFrameNs);
+					frames.Replayed.push_back(mesh.ReplayedFrameNs);
+					mesh.RecordedFrameNs = mesh.ReplayedFrameNs = 0;
+				}
+				break;
+			}
+			default:
+				valid = false;
+				break;
+		}
+	}
+
+	if (!valid)
+		std::cerr << "Trace is truncated or corrupt, stopped at offset " << file.tellg() << std::endl;
+
+	for (auto& mesh : meshes)
+		DisposeReplayMesh(mesh.first, mesh.second);
+	return valid;
+}
+
+/**
+ * Nearest rank percentile in milliseconds, sorts the durations
+ */
+static double Percentile(std::vector<long long>& durations, double p)
+{
+	if (durations.empty())
+		return 0.;
+	std::sort(durations.begin(), durations.end());
+	const size_t rank = std::min(durations.size() - 1, (size_t) (p / 100. * (durations.size() - 1) + 0.5));
+	return durations[rank] * 1e-6;
+}
+
+static void PrintRow(const std::string& name, Durations& durations)
+{
+	std::cout << std::left << std::setw(24) << name << std::right << std::setw(8) << durations.Recorded.size();
+	for (auto* values : {&durations.Recorded, &durations.Replayed})
+		for (double p : {50., 90., 99., 100.})
+			std::cout << std::setw(10) << std::fixed << std::setprecision(3) << Percentile(*values, p);
+	std::cout << std::endl;
+}
+
+static const char* OpName(unsigned int op)
+{
+	static const char* names[] = {"SelectSphere", "GetSelectionMaskSphere", "GetSelectionCenter",
+	                              "ClearSelectionMask", "SetColorByMask", "TranslateSelection",
+	                              "TransformSelection", "Harmonic", "Arap", "ResetV", "ApplyDirty",
+	                              "TranslateAllVertices", "SetColorSingleByMask", "SetCompactStorage",
+	                              "SmoothSelection", "SmoothSelectionImplicit", "FairSelection",
+	                              "ComputeSkinningWeights", "TransformHandles", "GeodesicDistance",
+	                              "GrowSelection", "ShrinkSelection", "SelectBorder", "SelectBoundaryLoops",
+	                              "SelectConnected", "SetArapConvergence", "SetSymmetry",
+	                              "AnalyzeDeformation", "DetectSelfIntersections"};
+	return op < sizeof(names) / sizeof(names[0]) ? names[op] : "Unknown";
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		std::cerr << "Usage: " << argv[0] << " <trace> [repeat]" << std::endl;
+		return 1;
+	}
+	const int repeat = argc > 2 ? std::max(1, std::atoi(argv[2])) : 1;
+
+	Initialize(Print, Print, Print);
+
+	std::map<unsigned int, Durations> calls;
+	Durations frames;
+	for (int i = 0; i < repeat; ++i)
+	{
+		// Compare a single recording to all replays
+		std::map<unsigned int, Durations> repeatCalls;
+		Durations repeatFrames;
+		if (!Replay(argv[1], repeatCalls, repeatFrames))
+			return 1;
+
+		for (auto& op : repeatCalls)
+		{
+			auto& durations = calls[op.first];
+			if (i == 0)
+				durations.Recorded = op.second.Recorded;
+			durations.Replayed.insert(durations.Replayed.end(), op.second.Replayed.begin(), op.second.Replayed.end());
+		}
+		if (i == 0)
+			frames.Recorded = repeatFrames.Recorded;
+		frames.Replayed.insert(frames.Replayed.end(), repeatFrames.Replayed.begin(), repeatFrames.Replayed.end());
+	}
+
+	std::cout << std::left << std::setw(24) << "[ms]" << std::right << std::setw(8) << "Count"
+	          << std::setw(40) << "Recorded p50 / p90 / p99 / max"
+	          << std::setw(40) << "Replayed p50 / p90 / p99 / max" << std::endl;
+	for (auto& op : calls)
+		PrintRow(OpName(op.first), op.second);
+	PrintRow("Frame", frames);
+	return 0;
+}
@@ -0,0 +1,205 @@
+#include "Native.h"
+#include "Storage.h"
+#include "Trace.h"
+#include "Util.h"
+#include <igl/jet.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+/**
+ * Area and angles of a triangle
+ * @param [out] angles The interior angle at each corner in radians
+ * @return The area
+ */
+static float TriangleShape(const Eigen::RowVector3f& a, const Eigen::RowVector3f& b, const Eigen::RowVector3f& c,
+                           Eigen::Vector3f& angles)
+{
+	const Eigen::RowVector3f ab = b - a, bc = c - b, ca = a - c;
+	const float doubleArea = ab.cross(-ca).norm();
+	// atan2 of the sine and cosine is accurate for small and obtuse angles, unlike acos
+	angles(0) = std::atan2(doubleArea, ab.dot(-ca));
+	angles(1) = std::atan2(doubleArea, bc.dot(-ab));
+	angles(2) = std::atan2(doubleArea, ca.dot(-bc));
+	return 0.5f * doubleArea;
+}
+
+/**
+ * Write the per vertex values as a color ramp to C, blue at 0 to red at max
+ */
+template<typename Value>
+static void SetColorByValue(MeshState* state, float max, Value&& value)
+{
+	auto& native = *state->Native;
+	const float scale = max > 0.f ? 1.f / max : 0.f;
+
+#pragma omp parallel for num_threads(GetWorkerThreads())
+	for (int i = 0; i < state->VSize; ++i)
+	{
+		Color_t color(0.f, 0.f, 0.f, 1.f);
+		igl::jet(std::min(value(i) * scale, 1.f), color(0), color(1), color(2));
+		if (native.CompactStorage)
+			native.C8.row(i) = ToRGBA8(color);
+		else
+			state->C->row(i) = color;
+	}
+
+	state->DirtyState |= DirtyFlag::CDirty;
+}
+
+void AnalyzeDeformation(MeshState* state, DeformationStats& stats, float* displacement, float* areaDistortion,
+                        float* angleDistortion, unsigned int colorMode, float colorMax)
+{
+	TraceScope trace(state, BatchOp::AnalyzeDeformation, [&](BatchCommand& cmd) {
+		cmd.ColorMode = colorMode;
+		cmd.ColorMax = colorMax;
+	});
+	state->EnsureInitialized();
+
+	const auto& V = *state->V;
+	const auto& V0 = *state->Native->V0;
+	const auto& F = *state->F;
+
+	// The rest shape only depends on V0, compute it once
+	auto& restShape = state->Native->RestFaceShape;
+	if (restShape.rows() != state->FSize)
+	{
+		restShape.resize(state->FSize, 4);
+#pragma omp parallel for num_threads(GetWorkerThreads())
+		for (int f = 0; f < state->FSize; ++f)
+		{
+			Eigen::Vector3f angles;
+			restShape(f, 0) = TriangleShape(V0.row(F(f, 0)), V0.row(F(f, 1)), V0.row(F(f, 2)), angles);
+			restShape.block<1, 3>(f, 1) = angles.transpose();
+		}
+	}
+
+	// The face values are needed per vertex for the colors, keep them if they are not an output
+	Eigen::VectorXf areaScratch, angleScratch;
+	if (colorMode == DeformationColor::AreaDistortion && areaDistortion == nullptr)
+	{
+		areaScratch.resize(state->FSize);
+		areaDistortion = areaScratch.data();
+	}
+	if (colorMode == DeformationColor::AngleDistortion && angleDistortion == nullptr)
+	{
+		angleScratch.resize(state->FSize);
+		angleDistortion = angleScratch.data();
+	}
+
+	float maxDisplacement = 0.f, sumDisplacement = 0.f, sumDisplacementSqr = 0.f;
+	int maxDisplacementVertex = -1;
+	float minAreaRatio = std::numeric_limits<float>::max(), maxAreaRatio = 0.f;
+	float area = 0.f, restArea = 0.f;
+	float maxAngle = 0.f, sumAngle = 0.f;
+
+	// Vertices and faces in the same parallel region, with the reductions of each thread merged at the end
+#pragma omp parallel num_threads(GetWorkerThreads())
+	{
+		float localMax = 0.f, localSum = 0.f, localSumSqr = 0.f;
+		int localMaxVertex = -1;
+#pragma omp for nowait
+		for (int i = 0; i < state->VSize; ++i)
+		{
+			const float d = (V.row(i) - V0.row(i)).norm();
+			if (displacement != nullptr)
+				displacement[i] = d;
+			localSum += d;
+			localSumSqr += d * d;
+			if (d > localMax)
+			{
+				localMax = d;
+				localMaxVertex = i;
+			}
+		}
+
+		float localMinRatio = std::numeric_limits<float>::max(), localMaxRatio = 0.f;
+		float localArea = 0.f, localRestArea = 0.f, localMaxAngle = 0.f, localSumAngle = 0.f;
+#pragma omp for nowait
+		for (int f = 0; f < state->FSize; ++f)
+		{
+			Eigen::Vector3f angles;
+			const float a = TriangleShape(V.row(F(f, 0)), V.row(F(f, 1)), V.row(F(f, 2)), angles);
+			const float a0 = restShape(f, 0);
+			// Degenerate rest faces have no meaningful ratio
+			const float ratio = a0 > 0.f ? a / a0 : 1.f;
+			const float angle = (angles - restShape.block<1, 3>(f, 1).transpose()).cwiseAbs().maxCoeff();
+			if (areaDistortion != nullptr)
+				areaDistortion[f] = ratio;
+			if (angleDistortion != nullptr)
+				angleDistortion[f] = angle;
+
+			localMinRatio = std::min(localMinRatio, ratio);
+			localMaxRatio = std::max(localMaxRatio, ratio);
+			localArea += a;
+			localRestArea += a0;
+			localMaxAngle = std::max(localMaxAngle, angle);
+			localSumAngle += angle;
+		}
+
+#pragma omp critical
+		{
+			if (localMax > maxDisplacement || maxDisplacementVertex < 0)
+			{
+				maxDisplacement = localMax;
+				maxDisplacementVertex = localMaxVertex;
+			}
+			sumDisplacement += localSum;
+			sumDisplacementSqr += localSumSqr;
+			minAreaRatio = std::min(minAreaRatio, localMinRatio);
+			maxAreaRatio = std::max(maxAreaRatio, localMaxRatio);
+			area += localArea;
+			restArea += localRestArea;
+			maxAngle = std::max(maxAngle, localMaxAngle);
+			sumAngle += localSumAngle;
+		}
+	}
+
+	stats.MaxDisplacement = maxDisplacement;
+	stats.MeanDisplacement = state->VSize > 0 ? sumDisplacement / state->VSize : 0.f;
+	stats.RmsDisplacement = state->VSize > 0 ? std::sqrt(sumDisplacementSqr / state->VSize) : 0.f;
+	stats.MaxDisplacementVertex = maxDisplacementVertex;
+	stats.MinAreaRatio = state->FSize > 0 ? minAreaRatio : 1.f;
+	stats.MaxAreaRatio = state->FSize > 0 ? maxAreaRatio : 1.f;
+	stats.AreaRatio = restArea > 0.f ? area / restArea : 1.f;
+	stats.MaxAngleDistortion = maxAngle;
+	stats.MeanAngleDistortion = state->FSize > 0 ? sumAngle / state->FSize : 0.f;
+
+	// Face values are shown at the vertices as the mean of their faces
+	const auto& VF = state->Native->VertexFaces;
+	auto meanOfFaces = [&](int i, const float* values, bool logRatio) -> float {
+		float sum = 0.f;
+		for (const int* f = VF.Begin(i); f != VF.End(i); ++f)
+			sum += logRatio ? std::abs(std::log2(std::max(values[*f], 1e-6f))) : values[*f];
+		return VF.End(i) > VF.Begin(i) ? sum / (VF.End(i) - VF.Begin(i)) : 0.f;
+	};
+
+	switch (colorMode)
+	{
+		case DeformationColor::None:
+			break;
+		case DeformationColor::Displacement:
+			if (displacement != nullptr)
+				SetColorByValue(state, colorMax > 0.f ? colorMax : maxDisplacement,
+				                [&](int i) { return displacement[i]; });
+			else
+				SetColorByValue(state, colorMax > 0.f ? colorMax : maxDisplacement,
+				                [&](int i) { return (V.row(i) - V0.row(i)).norm(); });
+			break;
+		case DeformationColor::AreaDistortion:
+		{
+			const float max = std::max(std::abs(std::log2(std::max(minAreaRatio, 1e-6f))),
+			                           std::abs(std::log2(std::max(maxAreaRatio, 1e-6f))));
+			SetColorByValue(state, colorMax > 0.f ? colorMax : max,
+			                [&](int i) { return meanOfFaces(i, areaDistortion, true); });
+			break;
+		}
+		case DeformationColor::AngleDistortion:
+			SetColorByValue(state, colorMax > 0.f ? colorMax : maxAngle,
+			                [&](int i) { return meanOfFaces(i, angleDistortion, false); });
+			break;
+		default:
+			LOGERR("AnalyzeDeformation: Invalid color mode: " << colorMode)
+			break;
+	}
+}
@@ -0,0 +1,136 @@
+#include "Native.h"
+#include "Attributes.h"
+#include "Trace.h"
+#include "Util.h"
+#include <algorithm>
+#include <cstring>
+
+void AttributeChannel::ExtendDirty(int begin, int end)
+{
+	UnionRange(DirtyBegin, DirtyEnd, std::max(begin, 0), std::min(end, Rows()));
+}
+
+AttributeChannel* GetAttribute(MeshState* state, int id)
+{
+	auto& channels = state->Native->Attributes.Channels;
+	if (id < 0 || id >= (int) channels.size() || !channels[id].IsUsed)
+		return nullptr;
+	return &channels[id];
+}
+
+// --- Exports
+int AddAttribute(MeshState* state, const char* name, unsigned int type, int components, unsigned int domain)
+{
+	state->EnsureInitialized();
+
+	if (type > AttributeType::Byte || domain > AttributeDomain::Face || components < 1)
+	{
+		LOGERR("AddAttribute: Invalid layout of " << name)
+		return -1;
+	}
+
+	// A channel with the same name is shared, e.g. by several tools using the same weights
+	const int existing = FindAttribute(state, name);
+	if (existing >= 0)
+	{
+		const auto& channel = state->Native->Attributes.Channels[existing];
+		if (channel.Type == type && channel.Components == components && channel.Domain == domain)
+			return existing;
+		LOGERR("AddAttribute: " << name << " exists with a different layout")
+		return -1;
+	}
+
+	auto& channels = state->Native->Attributes.Channels;
+	auto it = std::find_if(channels.begin(), channels.end(), [](const AttributeChannel& c) { return !c.IsUsed; });
+	if (it == channels.end())
+		it = channels.insert(channels.end(), AttributeChannel());
+
+	*it = AttributeChannel();
+	it->Name = name;
+	it->Type = type;
+	it->Components = components;
+	it->Domain = domain;
+	it->Data.assign(it->RowBytes() * (domain == AttributeDomain::Face ? state->FSize : state->VSize), 0);
+	it->IsUsed = true;
+	return it - channels.begin();
+}
+
+void RemoveAttribute(MeshState* state, int id)
+{
+	state->EnsureInitialized();
+
+	AttributeChannel* channel = GetAttribute(state, id);
+	if (channel == nullptr)
+		return;
+
+	*channel = AttributeChannel();
+}
+
+int FindAttribute(MeshState* state, const char* name)
+{
+	state->EnsureInitialized();
+
+	const auto& channels = state->Native->Attributes.Channels;
+	for (int id = 0; id < (int) channels.size(); ++id)
+		if (channels[id].IsUsed && channels[id].Name == name)
+			return id;
+	return -1;
+}
+
+void* GetAttributeData(MeshState* state, int id)
+{
+	state->EnsureInitialized();
+
+	AttributeChannel* channel = GetAttribute(state, id);
+	return channel != nullptr ? channel->Data.data() : nullptr;
+}
+
+bool SetAttributeTarget(MeshState* state, int id, void* target)
+{
+	state->EnsureInitialized();
+
+	AttributeChannel* channel = GetAttribute(state, id);
+	if (channel == nullptr)
+		return false;
+	if (target != nullptr && state->Native->Frames != nullptr)
+	{
+		LOGERR("SetAttributeTarget: Not supported with output frames, use GetAttributeData for " << channel->Name)
+		return false;
+	}
+
+	// A new target is missing all rows
+	if (target != nullptr && target != channel->Target)
+		std::memcpy(target, channel->Data.data(), channel->Data.size());
+	channel->Target = target;
+	return true;
+}
+
+void SetAttribute(MeshState* state, int id, const void* values, int begin, int end)
+{
+	TraceScope trace(state, "SetAttribute");
+	state->EnsureInitialized();
+
+	AttributeChannel* channel = GetAttribute(state, id);
+	if (channel == nullptr || begin < 0 || end > channel->Rows() || begin >= end)
+		return;
+
+	const size_t rowBytes = channel->RowBytes();
+	std::memcpy(channel->Data.data() + rowBytes * begin, values, rowBytes * (end - begin));
+	channel->ExtendDirty(begin, end);
+}
+
+bool GetAttributeChanged(MeshState* state, int id, int& begin, int& end)
+{
+	state->EnsureInitialized();
+
+	const AttributeChannel* channel = GetAttribute(state, id);
+	if (channel == nullptr || channel->ChangedBegin >= channel->ChangedEnd)
+	{
+		begin = end = 0;
+		return false;
+	}
+
+	begin = channel->ChangedBegin;
+	end = channel->ChangedEnd;
+	return true;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "InterfaceTypes.h"
+#include <string>
+#include <vector>
+
+struct MeshState;
+
+/**
+ * A named per vertex or per face channel beyond the fixed attributes of MeshState, see AddAttribute.
+ * Stored row major in the layout of the managed buffer, so ApplyDirty copies the modified rows with one memcpy.
+ */
+struct AttributeChannel
+{
+	std::string Name;
+	/** AttributeType constant */
+	unsigned int Type{AttributeType::Float};
+	/** Values per row */
+	int Components{1};
+	/** AttributeDomain constant, the rows are the vertices or the faces */
+	unsigned int Domain{AttributeDomain::Vertex};
+	/** Rows x Components values of the Type */
+	std::vector<unsigned char> Data;
+	/** Managed buffer ApplyDirty copies the modified rows to, nullptr if the data is read directly */
+	void* Target{nullptr};
+
+	/** Rows [DirtyBegin, DirtyEnd) modified since the last ApplyDirty, extend it with ExtendDirty */
+	int DirtyBegin{0};
+	int DirtyEnd{0};
+	/** Rows [ChangedBegin, ChangedEnd) that were modified before the last ApplyDirty, see GetAttributeChanged */
+	int ChangedBegin{0};
+	int ChangedEnd{0};
+
+	/** False if the channel has been removed, its id may then be reused */
+	bool IsUsed{false};
+
+	/** @return Bytes of one row */
+	size_t RowBytes() const
+	{ return Components * (Type == AttributeType::Byte ? 1 : 4); }
+
+	/** @return Number of rows */
+	int Rows() const
+	{ return RowBytes() > 0 ? (int) (Data.size() / RowBytes()) : 0; }
+
+	/** Mark the rows [begin, end) as modified */
+	void ExtendDirty(int begin, int end);
+
+	/**
+	 * @return The data as a row major Rows x Components matrix, T must match the Type
+	 */
+	template<typename T>
+	Eigen::Map<Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>> As()
+	{ return {reinterpret_cast<T*>(Data.data()), Rows(), Components}; }
+};
+
+/**
+ * All attribute channels of a mesh, the channel with id i is at index i
+ */
+struct AttributeStore
+{
+	std::vector<AttributeChannel> Channels;
+};
+
+/**
+ * @return The channel or nullptr if the id is not a used channel
+ */
+AttributeChannel* GetAttribute(MeshState* state, int id);
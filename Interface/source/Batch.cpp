@@ -0,0 +1,163 @@
+#include "Native.h"
+#include "Util.h"
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Execute a single command of a batch, see ExecuteBatch
+ * @param index Index of the command in the batch
+ */
+static void ExecuteCommand(const BatchCommand* commands, BatchResult* results, const int index)
+{
+	const BatchCommand& cmd = commands[index];
+	BatchResult& result = results[index];
+	MeshState* state = cmd.State;
+	result.Mask = 0;
+	result.Center = Vector3::Zero();
+
+	// The mask used by the transformations, same as the C# FindBrushSelectionMask
+	auto transformMask = [&]() -> unsigned int {
+		if (cmd.MaskSource < 0)
+			return cmd.MaskId;
+		// Only results of the same mesh are guaranteed to be written already
+		if (cmd.MaskSource >= index || commands[cmd.MaskSource].State != state)
+		{
+			LOGERR("ExecuteBatch: MaskSource " << cmd.MaskSource << " must be an earlier command of the same mesh.")
+			return cmd.MaskId;
+		}
+
+		const unsigned int brushMask = results[cmd.MaskSource].Mask & cmd.MaskFilter;
+		return brushMask > 0 ? brushMask : cmd.MaskId;
+	};
+
+	switch (cmd.Op)
+	{
+		case BatchOp::SelectSphere:
+			SelectSphere(state, cmd.Position, cmd.Radius, cmd.SelectionId, cmd.SelectionMode);
+			break;
+		case BatchOp::GetSelectionMaskSphere:
+			result.Mask = GetSelectionMaskSphere(state, cmd.Position, cmd.Radius);
+			break;
+		case BatchOp::GetSelectionCenter:
+			result.Center = GetSelectionCenter(state, cmd.MaskId);
+			break;
+		case BatchOp::ClearSelectionMask:
+			ClearSelectionMask(state, cmd.MaskId);
+			break;
+		case BatchOp::SetColorByMask:
+			SetColorByMask(state, cmd.MaskId);
+			break;
+		case BatchOp::TranslateSelection:
+			result.Mask = transformMask();
+			TranslateSelection(state, cmd.Translation, result.Mask);
+			break;
+		case BatchOp::TransformSelection:
+			result.Mask = transformMask();
+			result.Center = (cmd.Flags & BatchFlag::PivotAtSelectionCenter) > 0
+			                ? GetSelectionCenter(state, result.Mask) : cmd.Pivot;
+			TransformSelection(state, cmd.Translation, cmd.Scale, cmd.Rotation, result.Center, result.Mask);
+			break;
+		case BatchOp::Harmonic:
+			Harmonic(state, cmd.MaskId, (cmd.Flags & BatchFlag::ShowDeformationField) > 0);
+			break;
+		case BatchOp::Arap:
+			Arap(state, cmd.MaskId);
+			break;
+		case BatchOp::ResetV:
+			ResetV(state);
+			break;
+		case BatchOp::ApplyDirty:
+			ApplyDirty(state, cmd.Data, cmd.MaskId);
+			break;
+		case BatchOp::TranslateAllVertices:
+			TranslateAllVertices(state, cmd.Translation);
+			break;
+		case BatchOp::SetColorSingleByMask:
+			SetColorSingleByMask(state, cmd.MaskId, cmd.SelectionId);
+			break;
+		case BatchOp::SetCompactStorage:
+			SetCompactStorage(state, (cmd.Flags & BatchFlag::CompactStorage) > 0);
+			break;
+		case BatchOp::SmoothSelection:
+			SmoothSelection(state, cmd.MaskId, cmd.Lambda, cmd.Iterations);
+			break;
+		case BatchOp::SmoothSelectionImplicit:
+			SmoothSelectionImplicit(state, cmd.MaskId, cmd.Lambda);
+			break;
+		case BatchOp::FairSelection:
+			FairSelection(state, cmd.MaskId);
+			break;
+		case BatchOp::ComputeSkinningWeights:
+			ComputeSkinningWeights(state, cmd.MaskId, (cmd.Flags & BatchFlag::BoundedWeights) > 0);
+			break;
+		case BatchOp::TransformHandles:
+			result.Mask = transformMask();
+			result.Center = (cmd.Flags & BatchFlag::PivotAtSelectionCenter) > 0
+			                ? GetSelectionCenter(state, result.Mask) : cmd.Pivot;
+			TransformHandles(state, cmd.Translation, cmd.Scale, cmd.Rotation, result.Center, result.Mask);
+			break;
+		case BatchOp::GeodesicDistance:
+			GeodesicDistance(state, cmd.MaskId, nullptr, (cmd.Flags & BatchFlag::ColorByDistance) > 0);
+			break;
+		case BatchOp::GrowSelection:
+			GrowSelection(state, cmd.SelectionId, cmd.Iterations);
+			break;
+		case BatchOp::ShrinkSelection:
+			ShrinkSelection(state, cmd.SelectionId, cmd.Iterations);
+			break;
+		case BatchOp::SelectBorder:
+			SelectBorder(state, cmd.SelectionId);
+			break;
+		case BatchOp::SelectBoundaryLoops:
+			SelectBoundaryLoops(state, cmd.SelectionId);
+			break;
+		case BatchOp::SelectConnected:
+			SelectConnected(state, cmd.SelectionId);
+			break;
+		case BatchOp::SetArapConvergence:
+			SetArapConvergence(state, cmd.Iterations, cmd.Lambda);
+			break;
+		case BatchOp::SetSymmetry:
+			SetSymmetry(state, cmd.Axis, cmd.Plane, cmd.Tolerance);
+			break;
+		case BatchOp::AnalyzeDeformation:
+		{
+			DeformationStats stats{};
+			AnalyzeDeformation(state, stats, nullptr, nullptr, nullptr, cmd.ColorMode, cmd.ColorMax);
+			break;
+		}
+		case BatchOp::DetectSelfIntersections:
+			DetectSelfIntersections(state, (cmd.Flags & BatchFlag::ColorIntersections) > 0);
+			break;
+		default:
+			LOGERR("ExecuteBatch: Invalid operation: " << cmd.Op)
+			break;
+	}
+
+	result.DirtyState = state->DirtyState;
+	result.DirtySelections = state->DirtySelections;
+	result.DirtySelectionsResized = state->DirtySelectionsResized;
+}
+
+void ExecuteBatch(const BatchCommand* commands, int count, BatchResult* results)
+{
+	// Group the commands by mesh, keeping the order within a mesh
+	std::unordered_map<MeshState*, int> meshIndex;
+	std::vector<std::vector<int>> meshCommands;
+	for (int i = 0; i < count; ++i)
+	{
+		auto it = meshIndex.emplace(commands[i].State, (int) meshCommands.size());
+		if (it.second)
+			meshCommands.emplace_back();
+		meshCommands[it.first->second].push_back(i);
+	}
+
+	// Meshes are independent, a single mesh keeps the threads for Eigen/libigl
+	const int meshCount = meshCommands.size();
+#pragma omp parallel for schedule(dynamic) if(meshCount > 1) num_threads(GetWorkerThreads())
+	for (int m = 0; m < meshCount; ++m)
+	{
+		for (const int i : meshCommands[m])
+			ExecuteCommand(commands, results, i);
+	}
+}
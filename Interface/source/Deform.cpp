@@ -1,21 +1,55 @@
 #include "Deform.h"
+#include "Scheduler.h"
+#include "Storage.h"
+#include "Trace.h"
+#include "SelectionSets.h"
+#include "Util.h"
+#include <algorithm>
+#include <cmath>
+#include <Eigen/SVD>
 #include <igl/harmonic.h>
 
 // --- Deformations
-bool UpdateBoundary(MeshState* state, unsigned int boundaryMask)
+bool UpdateBoundary(MeshState* state, const SelectionMask& boundary)
 {
-	if (state->Native->BoundaryMask == boundaryMask && (state->Native->DirtySelectionsForBoundary & boundaryMask) == 0)
+	auto* native = state->Native;
+	std::vector<int> setIds(boundary.SetIds, boundary.SetIds + boundary.SetCount);
+	std::sort(setIds.begin(), setIds.end());
+	setIds.erase(std::unique(setIds.begin(), setIds.end()), setIds.end());
+
+	const bool setsDirty = std::any_of(setIds.begin(), setIds.end(), [&](int id) -> bool {
+		const SelectionSet* set = GetSelectionSet(state, id);
+		return set != nullptr && set->DirtyForBoundary;
+	});
+	if (native->BoundaryMask == boundary.Mask && native->BoundarySetIds == setIds && !setsDirty &&
+	    (native->DirtySelectionsForBoundary & boundary.Mask) == 0)
 		return false;
 
-	igl::colon<int>(0, state->VSize, state->Native->Boundary);
-	state->Native->Boundary.conservativeResize(
-			std::stable_partition(state->Native->Boundary.data(), state->Native->Boundary.data() + state->VSize,
-			                      [&](int i) -> bool { return (*state->S)(i) & boundaryMask; })
-			- state->Native->Boundary.data());
+	if (setIds.empty())
+	{
+		igl::colon<int>(0, state->VSize, native->Boundary);
+		VisitS(state, [&](const auto& S) {
+			native->Boundary.conservativeResize(
+					std::stable_partition(native->Boundary.data(), native->Boundary.data() + state->VSize,
+					                      [&](int i) -> bool { return S(i) & boundary.Mask; })
+					- native->Boundary.data());
+		});
+	}
+	else
+	{
+		std::vector<int> indices;
+		GatherSelected(state, boundary, indices);
+		native->Boundary = Eigen::Map<Eigen::VectorXi>(indices.data(), indices.size());
+
+		for (const int id : setIds)
+			if (SelectionSet* set = GetSelectionSet(state, id))
+				set->DirtyForBoundary = false;
+	}
 
-	state->Native->BoundaryMask = boundaryMask;
-	state->Native->DirtySelectionsForBoundary &= ~boundaryMask;
-	state->Native->DirtyBoundaryConditions = true;
+	native->BoundaryMask = boundary.Mask;
+	native->BoundarySetIds = setIds;
+	native->DirtySelectionsForBoundary &= ~boundary.Mask;
+	native->DirtyBoundaryConditions = true;
 	return true;
 }
 
@@ -30,10 +64,13 @@ bool UpdateBoundaryConditions(MeshState* state)
 	return true;
 }
 
-void Harmonic(MeshState* state, unsigned int boundaryMask, bool showDeformationField)
+/**
+ * Harmonic with the boundary given as a SelectionMask, see Harmonic
+ */
+static void HarmonicImpl(MeshState* state, const SelectionMask& boundary, bool showDeformationField)
 {
 	// Create boundary conditions
-	bool boundaryChanged = UpdateBoundary(state, boundaryMask);
+	bool boundaryChanged = UpdateBoundary(state, boundary);
 	bool solveHarmonic = UpdateBoundaryConditions(state) || boundaryChanged;
 
 	// Detect changes to the parameters as well
@@ -41,6 +78,7 @@ void Harmonic(MeshState* state, unsigned int boundaryMask, bool showDeformationF
 	state->Native->harmonicShowDeformationField = showDeformationField;
 
 	if (!solveHarmonic && !showDeformationFieldChanged) return;
+	SolverScope scope(state);
 
 	// Do Harmonic and apply it
 	if (showDeformationField)
@@ -57,36 +95,168 @@ void Harmonic(MeshState* state, unsigned int boundaryMask, bool showDeformationF
 		              *state->V);
 
 	state->DirtyState |= DirtyFlag::VDirtyExclBoundary;
+	state->Native->ExtendDirtyV(0, state->VSize);
 }
 
-void Arap(MeshState* state, unsigned int boundaryMask)
+/**
+ * @return Diagonal of the bounding box of V0, the scale of the Arap residual
+ */
+static float GetArapScale(MeshState* state)
 {
+	const auto& V0 = *state->Native->V0;
+	return std::max((V0.colwise().maxCoeff() - V0.colwise().minCoeff()).norm(), 1e-12f);
+}
 
-	bool recomputeArapData = UpdateBoundary(state, boundaryMask);
+/**
+ * Arap with the boundary given as a SelectionMask, see Arap
+ */
+static void ArapImpl(MeshState* state, const SelectionMask& boundary)
+{
+	auto* native = state->Native;
+	bool recomputeArapData = UpdateBoundary(state, boundary);
 	bool solveArap = UpdateBoundaryConditions(state) || recomputeArapData;
+	native->ArapIterations = 0;
 
-	if (state->Native->ArapData == nullptr)
+	if (native->ArapData == nullptr)
 	{
 		// Initialize
-		state->Native->ArapData = new igl::ARAPData<float>();
-		state->Native->ArapData->max_iter = 100;
+		native->ArapData = new igl::ARAPData<float>();
 		recomputeArapData = true;
 		solveArap = true;
 	}
 
 	if (recomputeArapData)
 	{
+		SolverScope scope(state, true);
 		LOG("Arap precompute...")
-		igl::arap_precomputation(*state->Native->V0, *state->F, 3, state->Native->Boundary,
-		                         *state->Native->ArapData);
+		igl::arap_precomputation(*native->V0, *state->F, 3, native->Boundary, *native->ArapData);
 		LOG("Arap precompute done.")
 	}
 
 	if (!solveArap) return;
-    LOG("Arap solve...")
+	SolverScope scope(state);
+	LOG("Arap solve...")
+
+	if (native->ArapTolerance <= 0.f)
+	{
+		// No convergence check, let libigl run all iterations without copying V after each one
+		native->ArapData->max_iter = native->ArapMaxIterations;
+		igl::arap_solve(native->BoundaryConditions, *native->ArapData, *state->V);
+		native->ArapIterations = native->ArapMaxIterations;
+		native->ArapResidual = 0.f;
+	}
+	else
+	{
+		// The solve starts from the current V, so after a small change of the handles it is close to converged.
+		// Run one local-global iteration at a time to stop once the vertices no longer move.
+		const float scale = GetArapScale(state);
+		const float tolerance = native->ArapTolerance * scale;
+		native->ArapData->max_iter = 1;
+		Eigen::MatrixXf previous;
+		float residual = 0.f;
+		while (native->ArapIterations < native->ArapMaxIterations)
+		{
+			previous = *state->V;
+			igl::arap_solve(native->BoundaryConditions, *native->ArapData, *state->V);
+			++native->ArapIterations;
 
-	igl::arap_solve(state->Native->BoundaryConditions, *state->Native->ArapData, *state->V);
-	LOG("Arap solve done.")
+			residual = (*state->V - previous).rowwise().squaredNorm().maxCoeff();
+			if (residual <= tolerance * tolerance)
+				break;
+		}
+		native->ArapResidual = std::sqrt(residual) / scale;
+	}
+	LOG("Arap solve done after " << native->ArapIterations << " iterations.")
 
 	state->DirtyState |= DirtyFlag::VDirtyExclBoundary;
+	state->Native->ExtendDirtyV(0, state->VSize);
+}
+
+void Harmonic(MeshState* state, unsigned int boundaryMask, bool showDeformationField)
+{
+	TraceScope trace(state, BatchOp::Harmonic, [&](BatchCommand& cmd) {
+		cmd.MaskId = boundaryMask;
+		cmd.Flags = showDeformationField ? BatchFlag::ShowDeformationField : BatchFlag::None;
+	});
+	state->EnsureInitialized();
+
+	HarmonicImpl(state, SelectionMask{boundaryMask, nullptr, 0}, showDeformationField);
+}
+
+void HarmonicSets(MeshState* state, SelectionMask boundary, bool showDeformationField)
+{
+	TraceScope trace(state, "HarmonicSets");
+	state->EnsureInitialized();
+
+	HarmonicImpl(state, boundary, showDeformationField);
+}
+
+void Arap(MeshState* state, unsigned int boundaryMask)
+{
+	TraceScope trace(state, BatchOp::Arap, [&](BatchCommand& cmd) {
+		cmd.MaskId = boundaryMask;
+	});
+	state->EnsureInitialized();
+
+	ArapImpl(state, SelectionMask{boundaryMask, nullptr, 0});
+}
+
+void ArapSets(MeshState* state, SelectionMask boundary)
+{
+	TraceScope trace(state, "ArapSets");
+	state->EnsureInitialized();
+
+	ArapImpl(state, boundary);
+}
+
+void SetArapConvergence(MeshState* state, int maxIterations, float tolerance)
+{
+	TraceScope trace(state, BatchOp::SetArapConvergence, [&](BatchCommand& cmd) {
+		cmd.Iterations = maxIterations;
+		cmd.Lambda = tolerance;
+	});
+	state->EnsureInitialized();
+
+	state->Native->ArapMaxIterations = std::max(1, maxIterations);
+	state->Native->ArapTolerance = std::max(0.f, tolerance);
+}
+
+int GetArapStats(MeshState* state, float& residual)
+{
+	state->EnsureInitialized();
+
+	residual = state->Native->ArapResidual;
+	return state->Native->ArapIterations;
+}
+
+float GetArapEnergy(MeshState* state)
+{
+	state->EnsureInitialized();
+	const auto& L = state->Native->Laplacian;
+	const auto& V0 = *state->Native->V0;
+	const auto& V = *state->V;
+
+	// Spokes energy: for each vertex the edges to its neighbors, weighted by the cotangents,
+	// compared to the rest edges under the rotation that fits them best
+	double energy = 0.0;
+#pragma omp parallel for num_threads(GetWorkerThreads()) reduction(+ : energy)
+	for (int i = 0; i < state->VSize; ++i)
+	{
+		Eigen::Matrix3f covariance = Eigen::Matrix3f::Zero();
+		for (Eigen::SparseMatrix<float>::InnerIterator it(L, i); it; ++it)
+			if (it.row() != i)
+				covariance += it.value() * (V0.row(i) - V0.row(it.row())).transpose() * (V.row(i) - V.row(it.row()));
+
+		const Eigen::JacobiSVD<Eigen::Matrix3f> svd(covariance, Eigen::ComputeFullU | Eigen::ComputeFullV);
+		Eigen::Matrix3f U = svd.matrixU();
+		if ((svd.matrixV() * U.transpose()).determinant() < 0.f)
+			U.col(2) *= -1.f;
+		const Eigen::Matrix3f R = svd.matrixV() * U.transpose();
+
+		for (Eigen::SparseMatrix<float>::InnerIterator it(L, i); it; ++it)
+			if (it.row() != i)
+				energy += it.value() * ((V.row(i) - V.row(it.row())).transpose() -
+				                        R * (V0.row(i) - V0.row(it.row())).transpose()).squaredNorm();
+	}
+	return (float) energy;
 }
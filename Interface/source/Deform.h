@@ -3,10 +3,10 @@
 
 /**
  * Recalculates the boundary <code>state->Native->Boundary</code> {@link MeshStateNative.Boundary} if the relevant selections have changed
- * @param boundaryMask The current mask of selections part of the boundary
+ * @param boundary The current selections and selection sets part of the boundary
  * @return True if boundary has changed
  */
-bool UpdateBoundary(MeshState* state, unsigned int boundaryMask);
+bool UpdateBoundary(MeshState* state, const SelectionMask& boundary);
 
 /**
  * Recalculates the boundary conditions <code>state->Native->BoundaryConditions</code> {@link MeshStateNative.BoundaryConditions} for Harmonic and Arap
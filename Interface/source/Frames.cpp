@@ -0,0 +1,121 @@
+#include "Native.h"
+#include "Frames.h"
+#include "Util.h"
+
+/** The attributes of the Unity mesh data that are copied to a frame */
+static const unsigned int FrameAttributes =
+		DirtyFlag::VDirty | DirtyFlag::NDirty | DirtyFlag::CDirty | DirtyFlag::UVDirty | DirtyFlag::FDirty;
+
+// --- OutputFrames
+UMeshDataNative OutputFrames::Frame::GetNative()
+{
+	return {V.data(), N.data(), C.data(), UV.data(), F.data(), (int) V.rows(), (int) F.rows()};
+}
+
+OutputFrames::OutputFrames(int VSize, int FSize)
+{
+	for (auto& frame : Frames)
+	{
+		frame.V.resize(VSize, 3);
+		frame.N.resize(VSize, 3);
+		frame.C.resize(VSize, 4);
+		frame.UV.resize(VSize, 2);
+		frame.F.resize(FSize, 3);
+		frame.Stale = FrameAttributes;
+		frame.StaleVBegin = 0;
+		frame.StaleVEnd = VSize;
+	}
+}
+
+void OutputFrames::Publish(const MeshState* state, unsigned int written, int VBegin, int VEnd)
+{
+	Frame& back = Frames[Back];
+	back.Stale = 0;
+	back.StaleVBegin = back.StaleVEnd = 0;
+
+	// The main thread may acquire the published frame meanwhile, then its dirty flags must not be merged
+	unsigned int ready = Ready.load(std::memory_order_acquire);
+	do
+	{
+		back.DirtyState = state->DirtyState;
+		back.DirtySelections = state->DirtySelections;
+		back.DirtySelectionsResized = state->DirtySelectionsResized;
+		if ((ready & Fresh) > 0)
+		{
+			const Frame& dropped = Frames[ready & IndexMask];
+			back.DirtyState |= dropped.DirtyState;
+			back.DirtySelections |= dropped.DirtySelections;
+			back.DirtySelectionsResized |= dropped.DirtySelectionsResized;
+		}
+	} while (!Ready.compare_exchange_weak(ready, Back | Fresh, std::memory_order_acq_rel, std::memory_order_acquire));
+
+	// The other frames are missing what has been written
+	written &= FrameAttributes;
+	for (int i = 0; i < Count; ++i)
+	{
+		if (i == Back)
+			continue;
+		Frames[i].Stale |= written;
+		if ((written & DirtyFlag::VDirty) > 0)
+			UnionRange(Frames[i].StaleVBegin, Frames[i].StaleVEnd, VBegin, VEnd);
+	}
+
+	Back = ready & IndexMask;
+}
+
+int OutputFrames::Acquire()
+{
+	// Only the worker thread sets Fresh, so it cannot be cleared between the load and the exchange
+	if ((Ready.load(std::memory_order_acquire) & Fresh) == 0)
+		return -1;
+
+	Front = Ready.exchange(Front, std::memory_order_acq_rel) & IndexMask;
+	return Front;
+}
+
+// --- Exports
+void EnableOutputFrames(MeshState* state)
+{
+	state->EnsureInitialized();
+
+	DisableOutputFrames(state);
+	state->Native->Frames = new OutputFrames(state->VSize, state->FSize);
+
+	// The targets are written in ApplyDirty on the worker thread, not in the frames
+	for (auto& channel : state->Native->Attributes.Channels)
+		if (channel.Target != nullptr)
+		{
+			LOGWARN("EnableOutputFrames: Removed the target of attribute " << channel.Name)
+			channel.Target = nullptr;
+		}
+}
+
+void DisableOutputFrames(MeshState* state)
+{
+	delete state->Native->Frames;
+	state->Native->Frames = nullptr;
+}
+
+UMeshDataNative GetOutputFrame(MeshState* state, int frame)
+{
+	auto* frames = state->Native->Frames;
+	if (frames == nullptr || frame < 0 || frame >= OutputFrames::Count)
+	{
+		LOGERR("GetOutputFrame: Invalid frame " << frame << " or output frames are not enabled.")
+		return {};
+	}
+	return frames->Frames[frame].GetNative();
+}
+
+int AcquireOutputFrame(MeshState* state, unsigned int& dirtyState)
+{
+	dirtyState = DirtyFlag::None;
+	auto* frames = state->Native->Frames;
+	if (frames == nullptr)
+		return -1;
+
+	const int frame = frames->Acquire();
+	if (frame >= 0)
+		dirtyState = frames->Frames[frame].DirtyState;
+	return frame;
+}
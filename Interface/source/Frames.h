@@ -0,0 +1,85 @@
+#pragma once
+#include "InterfaceTypes.h"
+#include <atomic>
+
+struct MeshState;
+
+/**
+ * Triple buffered output attributes of a mesh, so the worker thread computes the next frame whilst the main thread
+ * uploads the previous one to the Unity mesh.
+ * The worker thread writes the back frame in ApplyDirty and publishes it with Publish().
+ * The main thread takes the latest published frame with Acquire(), it may read it until the next Acquire().
+ * The frames are exchanged with a single atomic, so neither thread ever waits for the other.
+ * A frame that is not acquired before the next one is published is dropped, its dirty flags are merged into the next.
+ */
+struct OutputFrames
+{
+	static const int Count = 3;
+
+	/**
+	 * Row major copy of the attributes of the Unity mesh data, with the dirty flags of the frame
+	 */
+	struct Frame
+	{
+		Eigen::Matrix<float, Eigen::Dynamic, 3, Eigen::RowMajor> V;
+		Eigen::Matrix<float, Eigen::Dynamic, 3, Eigen::RowMajor> N;
+		Eigen::Matrix<float, Eigen::Dynamic, 4, Eigen::RowMajor> C;
+		Eigen::Matrix<float, Eigen::Dynamic, 2, Eigen::RowMajor> UV;
+		Eigen::Matrix<int, Eigen::Dynamic, 3, Eigen::RowMajor> F;
+
+		/** MeshState dirty flags of the frame, including those of dropped frames */
+		unsigned int DirtyState{0};
+		unsigned int DirtySelections{0};
+		unsigned int DirtySelectionsResized{0};
+
+		/**
+		 * Attributes (DirtyFlag) modified since this frame was last written, they are copied the next time it is written.
+		 * Only accessed by the worker thread.
+		 */
+		unsigned int Stale{0};
+		/** Range of vertices [StaleVBegin, StaleVEnd) modified since this frame was last written, if V is stale */
+		int StaleVBegin{0};
+		int StaleVEnd{0};
+
+		/** @return Pointers to the attributes, as for the Unity mesh data */
+		UMeshDataNative GetNative();
+	};
+
+	Frame Frames[Count];
+
+	/**
+	 * Allocates the frames, all attributes are stale so they are fully copied when first written
+	 */
+	OutputFrames(int VSize, int FSize);
+
+	/**
+	 * @return The frame to write to, owned by the worker thread until Publish()
+	 */
+	Frame& GetBack()
+	{ return Frames[Back]; }
+
+	/**
+	 * Publish the back frame for the next Acquire() and take a new back frame. Called on the worker thread.
+	 * @param written Attributes (DirtyFlag) written this frame, they become stale in the other frames
+	 * @param VBegin Range of vertices [VBegin, VEnd) written this frame, if V is in <code>written</code>
+	 */
+	void Publish(const MeshState* state, unsigned int written, int VBegin, int VEnd);
+
+	/**
+	 * Take the latest published frame, the previously acquired frame is released. Called on the main thread.
+	 * @return Index of the frame in Frames, or -1 if no frame has been published since the last Acquire()
+	 */
+	int Acquire();
+
+private:
+	/** Set in Ready together with the index when the frame has been published but not yet acquired */
+	static const unsigned int Fresh = 4;
+	static const unsigned int IndexMask = 3;
+
+	/** Frame written by the worker thread */
+	int Back{0};
+	/** Index of the published frame, or'ed with Fresh if it has not been acquired */
+	std::atomic<unsigned int> Ready{1};
+	/** Frame read by the main thread */
+	int Front{2};
+};
@@ -0,0 +1,73 @@
+#include "Native.h"
+#include "Scheduler.h"
+#include "Storage.h"
+#include "Trace.h"
+#include <igl/jet.h>
+
+/**
+ * Write the distances as a color ramp to C, blue at the sources to red at the largest distance
+ */
+static void SetColorByDistance(MeshState* state, const Eigen::VectorXf& D)
+{
+	Eigen::MatrixXf rgb;
+	igl::jet(D, true, rgb);
+
+	auto& native = *state->Native;
+	for (int i = 0; i < state->VSize; ++i)
+	{
+		const Color_t color(rgb(i, 0), rgb(i, 1), rgb(i, 2), 1.f);
+		if (native.CompactStorage)
+			native.C8.row(i) = ToRGBA8(color);
+		else
+			state->C->row(i) = color;
+	}
+
+	state->DirtyState |= DirtyFlag::CDirty;
+}
+
+float GeodesicDistance(MeshState* state, unsigned int sourceMask, float* distances, bool colorByDistance)
+{
+	TraceScope trace(state, BatchOp::GeodesicDistance, [&](BatchCommand& cmd) {
+		cmd.MaskId = sourceMask;
+		cmd.Flags = colorByDistance ? BatchFlag::ColorByDistance : BatchFlag::None;
+	});
+	state->EnsureInitialized();
+
+	std::vector<int> sources;
+	VisitS(state, [&](const auto& S) {
+		for (int i = 0; i < state->VSize; ++i)
+			if ((S(i) & sourceMask) > 0)
+				sources.push_back(i);
+	});
+	if (sources.empty())
+		return -1.f;
+
+	auto*& data = state->Native->HeatGeodesics;
+	if (data == nullptr)
+	{
+		// Prefactor the heat and Poisson systems once, in double as the heat step is badly conditioned
+		SolverScope scope(state, true);
+		data = new igl::HeatGeodesicsData<double>();
+		LOG("Heat geodesics precompute...")
+		const Eigen::MatrixXd V0 = state->Native->V0->cast<double>();
+		if (!igl::heat_geodesics_precompute(V0, *state->F, *data))
+		{
+			LOGERR("GeodesicDistance: Precomputation failed.")
+			delete data;
+			data = nullptr;
+			return -1.f;
+		}
+		LOG("Heat geodesics precompute done.")
+	}
+
+	// Two back-substitutions: heat diffusion from the sources then the Poisson solve
+	Eigen::VectorXd D;
+	igl::heat_geodesics_solve(*data, Eigen::Map<Eigen::VectorXi>(sources.data(), sources.size()), D);
+	const Eigen::VectorXf Df = D.cast<float>();
+
+	if (distances != nullptr)
+		Eigen::Map<Eigen::VectorXf>(distances, state->VSize) = Df;
+	if (colorByDistance)
+		SetColorByDistance(state, Df);
+	return Df.maxCoeff();
+}
@@ -1,16 +1,138 @@
 #include "Native.h"
 #include "Util.h"
+#include "Upload.h"
+#include "Frames.h"
+#include "Storage.h"
+#include "Trace.h"
 #include <igl/readOFF.h>
 #include <igl/per_vertex_normals.h>
+#include <array>
+#include <cstring>
+#include <vector>
+
+/**
+ * Count the vertices of each selection in <code>countMask</code> and the vertices in any selection,
+ * in one pass over S with a histogram per thread
+ */
+template<typename Derived>
+static void CountSelected(const Eigen::MatrixBase<Derived>& S, unsigned int countMask,
+                          std::array<unsigned int, 32>& counts, unsigned int& countAll)
+{
+	counts.fill(0);
+	countAll = 0;
+	const int VSize = S.size();
+#pragma omp parallel num_threads(GetWorkerThreads())
+	{
+		std::array<unsigned int, 32> local{};
+		unsigned int localAll = 0;
+#pragma omp for nowait
+		for (int i = 0; i < VSize; ++i)
+		{
+			const auto s = static_cast<unsigned int>(S(i));
+			localAll += s > 0;
+			for (unsigned int selectionId = 0, m = s & countMask; m > 0; ++selectionId, m >>= 1)
+				local[selectionId] += m & 1u;
+		}
+#pragma omp critical
+		{
+			for (unsigned int selectionId = 0; selectionId < counts.size(); ++selectionId)
+				counts[selectionId] += local[selectionId];
+			countAll += localAll;
+		}
+	}
+}
+
+/**
+ * Rows of one attribute to copy to the Unity mesh data, see CopyBlockToMap
+ */
+struct CopyBlock
+{
+	/** Which attribute, the DirtyFlag constant */
+	unsigned int Attribute;
+	int Begin;
+	int End;
+	/** AttributesDirty: Id of the attribute channel */
+	int Channel;
+};
+
+/** Rows per CopyBlock, so the rows read and written fit into the L2 cache */
+static const int CopyBlockRows = 4096;
+
+/**
+ * Split the rows [begin, end) of the attribute into blocks
+ */
+static void AddCopyBlocks(std::vector<CopyBlock>& blocks, unsigned int attribute, int begin, int end,
+                          int channel = -1)
+{
+	for (int b = begin; b < end; b += CopyBlockRows)
+		blocks.push_back({attribute, b, std::min(b + CopyBlockRows, end), channel});
+}
+
+/**
+ * Transpose the rows of the block to the Unity mesh data, compact storage is converted to floats
+ */
+static void CopyBlockToMap(MeshState* state, const UMeshDataNative& data, const CopyBlock& block)
+{
+	const auto* native = state->Native;
+	const int count = block.End - block.Begin;
+	switch (block.Attribute)
+	{
+		case DirtyFlag::VDirty:
+			TransposeRowsToMap(state->V, data.VPtr, block.Begin, block.End);
+			break;
+		case DirtyFlag::NDirty:
+			TransposeRowsToMap(state->N, data.NPtr, block.Begin, block.End);
+			break;
+		case DirtyFlag::CDirty:
+			if (native->CompactStorage)
+				Eigen::Map<Eigen::Matrix<float, Eigen::Dynamic, 4, Eigen::RowMajor>>(data.CPtr + 4 * block.Begin, count, 4) =
+						native->C8.middleRows(block.Begin, count).cast<float>() * (1.f / 255.f);
+			else
+				TransposeRowsToMap(state->C, data.CPtr, block.Begin, block.End);
+			break;
+		case DirtyFlag::UVDirty:
+			if (native->CompactStorage)
+				Eigen::Map<Eigen::Matrix<float, Eigen::Dynamic, 2, Eigen::RowMajor>>(data.UVPtr + 2 * block.Begin, count, 2) =
+						native->UV16.middleRows(block.Begin, count).cast<float>();
+			else
+				TransposeRowsToMap(state->UV, data.UVPtr, block.Begin, block.End);
+			break;
+		case DirtyFlag::FDirty:
+			TransposeRowsToMap(state->F, data.FPtr, block.Begin, block.End);
+			break;
+		case DirtyFlag::AttributesDirty:
+		{
+			// Same row major layout, no conversion
+			const auto& channel = native->Attributes.Channels[block.Channel];
+			const size_t rowBytes = channel.RowBytes();
+			std::memcpy(static_cast<unsigned char*>(channel.Target) + rowBytes * block.Begin,
+			            channel.Data.data() + rowBytes * block.Begin, rowBytes * count);
+			break;
+		}
+		default:
+			break;
+	}
+}
 
 void ApplyDirty(MeshState* state, const UMeshDataNative data, const unsigned int visibleSelectionMask)
 {
+	TraceScope trace(state, BatchOp::ApplyDirty, [&](BatchCommand& cmd) {
+		cmd.MaskId = visibleSelectionMask;
+		cmd.Data.VSize = data.VSize;
+		cmd.Data.FSize = data.FSize;
+	});
+	state->EnsureInitialized();
+
 	auto& dirty = state->DirtyState;
 
 	if (state->DirtySelections > 0)
 	{
-		// Update selection sizes
-		state->SSizesAll = state->S->unaryExpr([&](int a) -> int { return a > 0; }).sum();
+		// Update selection sizes, all dirty selections in use are counted in one pass
+		const unsigned int usedMask = state->SSize >= 32 ? (unsigned int) -1 : (1u << state->SSize) - 1;
+		std::array<unsigned int, 32> counts;
+		VisitS(state, [&](const auto& S) {
+			CountSelected(S, state->DirtySelections & usedMask, counts, state->SSizesAll);
+		});
 
 		for (unsigned int selectionId = 0; selectionId < state->SSize; ++selectionId)
 		{
@@ -18,12 +140,10 @@ void ApplyDirty(MeshState* state, const UMeshDataNative data, const unsigned int
 			if ((maskId & state->DirtySelections) == 0)
 				continue;
 
-			auto before = state->SSizes[selectionId];
-			state->SSizes[selectionId] = state->S->unaryExpr([&](int a) -> int { return (a & maskId) > 0; }).sum();
-
 			// Set flag if size has changed
-			if (before != state->SSizes[selectionId])
-				state->DirtySelectionsResized |= 1 << selectionId;
+			if (state->SSizes[selectionId] != counts[selectionId])
+				state->DirtySelectionsResized |= maskId;
+			state->SSizes[selectionId] = counts[selectionId];
 		}
 		state->Native->DirtySelectionsForBoundary |= state->DirtySelectionsResized;
 
@@ -39,16 +159,82 @@ void ApplyDirty(MeshState* state, const UMeshDataNative data, const unsigned int
 	else if((dirty & DirtyFlag::VDirtyExclBoundary) > 0)
 		dirty |= DirtyFlag::VDirty;
 
+	// Attribute channels are copied with the other attributes, only the rows modified since the last ApplyDirty
+	std::vector<CopyBlock> blocks;
+	auto& channels = state->Native->Attributes.Channels;
+	for (int id = 0; id < (int) channels.size(); ++id)
+	{
+		auto& channel = channels[id];
+		channel.ChangedBegin = channel.DirtyBegin;
+		channel.ChangedEnd = channel.DirtyEnd;
+		channel.DirtyBegin = channel.DirtyEnd = 0;
+		if (!channel.IsUsed || channel.ChangedBegin >= channel.ChangedEnd)
+			continue;
+
+		dirty |= DirtyFlag::AttributesDirty;
+		if (channel.Target != nullptr)
+			AddCopyBlocks(blocks, DirtyFlag::AttributesDirty, channel.ChangedBegin, channel.ChangedEnd, id);
+	}
+
+	// Write to the back output frame instead, it is also missing what was written to the other frames
+	OutputFrames* frames = state->Native->Frames;
+	UMeshDataNative target = data;
+	unsigned int copy = dirty;
+	int staleVBegin = 0, staleVEnd = 0;
+	if (frames != nullptr)
+	{
+		if (dirty == DirtyFlag::None && state->DirtySelections == 0)
+			return;
+
+		auto& back = frames->GetBack();
+		target = back.GetNative();
+		copy |= back.Stale;
+		staleVBegin = back.StaleVBegin;
+		staleVEnd = back.StaleVEnd;
+	}
+
+	// The attributes are independent, copy all of them at once in blocks
+	int VBegin = 0, VEnd = 0;
 	if ((dirty & DirtyFlag::VDirty) > 0)
-		TransposeToMap(state->V, data.VPtr);
-	if ((dirty & DirtyFlag::NDirty) > 0)
-		TransposeToMap(state->N, data.NPtr);
-	if ((dirty & DirtyFlag::CDirty) > 0)
-		TransposeToMap(state->C, data.CPtr);
-	if ((dirty & DirtyFlag::UVDirty) > 0)
-		TransposeToMap(state->UV, data.UVPtr);
-	if ((dirty & DirtyFlag::FDirty) > 0)
-		TransposeToMap(state->F, data.FPtr);
+	{
+		// Only copy the modified vertices, if known
+		VEnd = state->VSize;
+		if (state->Native->DirtyVBegin < state->Native->DirtyVEnd)
+		{
+			VBegin = state->Native->DirtyVBegin;
+			VEnd = state->Native->DirtyVEnd;
+		}
+		state->Native->DirtyVBegin = state->Native->DirtyVEnd = 0;
+
+		if (state->Native->Upload)
+		{
+			state->Native->Upload->Stage(*state->V, VBegin, VEnd);
+			dirty |= DirtyFlag::VUploaded;
+			copy &= ~DirtyFlag::VDirty;
+		}
+	}
+	if ((copy & DirtyFlag::VDirty) > 0)
+	{
+		int begin = VBegin, end = VEnd;
+		UnionRange(begin, end, staleVBegin, staleVEnd);
+		AddCopyBlocks(blocks, DirtyFlag::VDirty, begin, end);
+	}
+	if ((copy & DirtyFlag::NDirty) > 0)
+		AddCopyBlocks(blocks, DirtyFlag::NDirty, 0, state->VSize);
+	if ((copy & DirtyFlag::CDirty) > 0)
+		AddCopyBlocks(blocks, DirtyFlag::CDirty, 0, state->VSize);
+	if ((copy & DirtyFlag::UVDirty) > 0)
+		AddCopyBlocks(blocks, DirtyFlag::UVDirty, 0, state->VSize);
+	if ((copy & DirtyFlag::FDirty) > 0)
+		AddCopyBlocks(blocks, DirtyFlag::FDirty, 0, state->FSize);
+
+	const int blockCount = blocks.size();
+#pragma omp parallel for schedule(dynamic) num_threads(GetWorkerThreads()) if(blockCount > 1)
+	for (int b = 0; b < blockCount; ++b)
+		CopyBlockToMap(state, target, blocks[b]);
+
+	if (frames != nullptr)
+		frames->Publish(state, copy & dirty, VBegin, VEnd);
 }
 
 void ReadOFF(const char* path, const bool setCenter, const bool normalizeScale, const float scale,
@@ -91,8 +91,19 @@ struct DirtyFlag
 	 */
 	static const unsigned int VDirtyExclBoundary = 256;
 
+	/**
+	 * Set by ApplyDirty when V has been staged for the native GPU upload instead of being written to the VPtr,
+	 * see EnableNativeUpload. The managed mesh vertices must then not be set.
+	 */
+	static const unsigned int VUploaded = 512;
+
+	/**
+	 * Set by ApplyDirty when an attribute channel has been modified, see GetAttributeChanged
+	 */
+	static const unsigned int AttributesDirty = 1024;
+
 	static const unsigned int All =
-			(unsigned int) -1 - DontComputeNormals - DontComputeBounds - DontComputeColorsBySelection;
+			(unsigned int) -1 - DontComputeNormals - DontComputeBounds - DontComputeColorsBySelection - VUploaded;
 };
 
 /**
@@ -120,3 +131,220 @@ struct SelectionMode
 	static const unsigned int Subtract = 1;
 	static const unsigned int Toggle = 2;
 };
+
+/**
+ * Selects vertices from both the 32 bit selections in S and the selection sets, see AddSelectionSet.
+ * Pass this by value, the SetIds must stay valid for the duration of the call.
+ */
+struct SelectionMask
+{
+	/** Bitmask of the selections stored in S, as for the functions taking a maskId */
+	unsigned int Mask;
+	/** Ids of selection sets, may be null if SetCount is 0 */
+	const int* SetIds;
+	int SetCount;
+};
+
+/**
+ * Value type of an attribute channel, see AddAttribute
+ */
+struct AttributeType
+{
+	static const unsigned int Float = 0;
+	static const unsigned int Int = 1;
+	static const unsigned int Byte = 2;
+};
+
+/**
+ * Whether an attribute channel has one row per vertex or per face
+ */
+struct AttributeDomain
+{
+	static const unsigned int Vertex = 0;
+	static const unsigned int Face = 1;
+};
+
+/**
+ * Which quantity AnalyzeDeformation writes as a color ramp to C
+ */
+struct DeformationColor
+{
+	static const unsigned int None = 0;
+	/** Distance of each vertex from V0 */
+	static const unsigned int Displacement = 1;
+	/** Mean |log2| of the area ratio of the faces of each vertex, 1 is twice or half the rest area */
+	static const unsigned int AreaDistortion = 2;
+	/** Mean angle distortion of the faces of each vertex in radians */
+	static const unsigned int AngleDistortion = 3;
+};
+
+/**
+ * Summary of how far V has moved from V0, see AnalyzeDeformation
+ */
+struct DeformationStats
+{
+	float MaxDisplacement;
+	float MeanDisplacement;
+	float RmsDisplacement;
+	/** The vertex with the MaxDisplacement, -1 if no vertex has moved */
+	int MaxDisplacementVertex;
+
+	/** Smallest and largest ratio of the area of a face to its rest area */
+	float MinAreaRatio;
+	float MaxAreaRatio;
+	/** Total area divided by the total rest area */
+	float AreaRatio;
+
+	/** Largest and mean change of a face's angles from the rest angles, in radians, the largest of the 3 per face */
+	float MaxAngleDistortion;
+	float MeanAngleDistortion;
+};
+
+struct MeshState;
+
+/**
+ * Operations that can be batched with ExecuteBatch. Each corresponds to the exported function of the same name.
+ */
+struct BatchOp
+{
+	static const unsigned int SelectSphere = 0;
+	static const unsigned int GetSelectionMaskSphere = 1;
+	static const unsigned int GetSelectionCenter = 2;
+	static const unsigned int ClearSelectionMask = 3;
+	static const unsigned int SetColorByMask = 4;
+	static const unsigned int TranslateSelection = 5;
+	static const unsigned int TransformSelection = 6;
+	static const unsigned int Harmonic = 7;
+	static const unsigned int Arap = 8;
+	static const unsigned int ResetV = 9;
+	static const unsigned int ApplyDirty = 10;
+	static const unsigned int TranslateAllVertices = 11;
+	static const unsigned int SetColorSingleByMask = 12;
+	static const unsigned int SetCompactStorage = 13;
+	static const unsigned int SmoothSelection = 14;
+	static const unsigned int SmoothSelectionImplicit = 15;
+	static const unsigned int FairSelection = 16;
+	static const unsigned int ComputeSkinningWeights = 17;
+	static const unsigned int TransformHandles = 18;
+	static const unsigned int GeodesicDistance = 19;
+	static const unsigned int GrowSelection = 20;
+	static const unsigned int ShrinkSelection = 21;
+	static const unsigned int SelectBorder = 22;
+	static const unsigned int SelectBoundaryLoops = 23;
+	static const unsigned int SelectConnected = 24;
+	static const unsigned int SetArapConvergence = 25;
+	static const unsigned int SetSymmetry = 26;
+	static const unsigned int AnalyzeDeformation = 27;
+	static const unsigned int DetectSelfIntersections = 28;
+};
+
+/**
+ * Options for a BatchCommand as a bitmask
+ */
+struct BatchFlag
+{
+	static const unsigned int None = 0;
+	/**
+	 * TransformSelection: Use the center of the selections as the pivot, see GetSelectionCenter
+	 */
+	static const unsigned int PivotAtSelectionCenter = 1;
+	/**
+	 * Harmonic: Show the deformation field, see Harmonic
+	 */
+	static const unsigned int ShowDeformationField = 2;
+	/**
+	 * SetCompactStorage: Enable the compact storage, otherwise it is disabled
+	 */
+	static const unsigned int CompactStorage = 4;
+	/**
+	 * ComputeSkinningWeights: Compute bounded biharmonic weights, otherwise biharmonic weights
+	 */
+	static const unsigned int BoundedWeights = 8;
+	/**
+	 * GeodesicDistance: Write the distance as a color ramp to C
+	 */
+	static const unsigned int ColorByDistance = 16;
+	/**
+	 * DetectSelfIntersections: Color the vertices of the intersecting faces
+	 */
+	static const unsigned int ColorIntersections = 32;
+};
+
+/**
+ * One operation in a flat array of commands for ExecuteBatch.
+ * Only the members used by the BatchOp need to be set, they match the parameters of the exported function.
+ */
+struct BatchCommand
+{
+	/** The mesh to operate on */
+	MeshState* State;
+	/** ApplyDirty: Pointers to the Unity Mesh Data */
+	UMeshDataNative Data;
+
+	/** Which operation, use BatchOp constants */
+	unsigned int Op;
+	/** Use BatchFlag constants */
+	unsigned int Flags;
+	/**
+	 * Which selections to operate on as a bitmask.
+	 * Harmonic/Arap: boundaryMask, ApplyDirty: visibleSelectionMask, ComputeSkinningWeights: handleMask,
+	 * GeodesicDistance: sourceMask
+	 */
+	unsigned int MaskId;
+	/**
+	 * TranslateSelection/TransformSelection/TransformHandles: Index of an earlier GetSelectionMaskSphere command of the same mesh, or -1.
+	 * If the selections inside that sphere, filtered by MaskFilter, are not empty they replace MaskId.
+	 */
+	int MaskSource;
+	unsigned int MaskFilter;
+
+	/**
+	 * SelectSphere/GrowSelection/ShrinkSelection/SelectBorder/SelectBoundaryLoops/SelectConnected:
+	 * Which selection to modify. SetColorSingleByMask: colorId
+	 */
+	int SelectionId;
+	/** SelectSphere: Use SelectionMode constants */
+	unsigned int SelectionMode;
+	/** SelectSphere/GetSelectionMaskSphere: The sphere */
+	Vector3 Position;
+	float Radius;
+
+	/** TranslateSelection/TransformSelection/TransformHandles/TranslateAllVertices */
+	Vector3 Translation;
+	float Scale;
+	Quaternion Rotation;
+	Vector3 Pivot;
+
+	/** SmoothSelection/SmoothSelectionImplicit: Step size. SetArapConvergence: tolerance */
+	float Lambda;
+	/** SmoothSelection: Number of smoothing steps. GrowSelection/ShrinkSelection: rings. SetArapConvergence: maxIterations */
+	int Iterations;
+
+	/** SetSymmetry: Normal of the plane, 0, 1 or 2 for x, y or z, -1 to disable symmetry */
+	int Axis;
+	/** SetSymmetry: Position of the plane along the axis in local space */
+	float Plane;
+	/** SetSymmetry: Maximum distance of a mirrored vertex to the reflection, relative to the bounding box diagonal */
+	float Tolerance;
+
+	/** AnalyzeDeformation: Use DeformationColor constants */
+	unsigned int ColorMode;
+	/** AnalyzeDeformation: Value shown red, 0 to use the largest value of the call */
+	float ColorMax;
+};
+
+/**
+ * Output of one BatchCommand, written to the same index as the command.
+ */
+struct BatchResult
+{
+	/** GetSelectionMaskSphere: The selections inside the sphere. TranslateSelection/TransformSelection/TransformHandles: The mask used */
+	unsigned int Mask;
+	/** GetSelectionCenter: The mean vertex. TransformSelection/TransformHandles: The pivot used */
+	Vector3 Center;
+
+	/** The dirty state of the mesh after executing the command, see MeshState */
+	unsigned int DirtyState;
+	unsigned int DirtySelections;
+	unsigned int DirtySelectionsResized;
+};
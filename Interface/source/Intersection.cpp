@@ -0,0 +1,383 @@
+#include "Native.h"
+#include "Intersection.h"
+#include "Storage.h"
+#include "Trace.h"
+#include "Util.h"
+#include <algorithm>
+
+// --- FaceBvh
+/**
+ * @return The bounding box of face f
+ */
+static Eigen::AlignedBox3f FaceBox(const VerticesRowMajor& V, const FacesRowMajor& F, int f)
+{
+	Eigen::AlignedBox3f box(V.row(F(f, 0)).transpose());
+	box.extend(V.row(F(f, 1)).transpose());
+	box.extend(V.row(F(f, 2)).transpose());
+	return box;
+}
+
+void FaceBvh::Build(const VerticesRowMajor& V, const FacesRowMajor& F)
+{
+	const int FSize = F.rows();
+	Nodes.clear();
+	Nodes.reserve(2 * FSize / LeafSize + 1);
+	Faces.resize(FSize);
+	FaceBoxes.resize(FSize);
+	LeafOfFace.resize(FSize);
+	for (int f = 0; f < FSize; ++f)
+		Faces[f] = f;
+
+	std::vector<Eigen::Vector3f> centroids(FSize);
+	for (int f = 0; f < FSize; ++f)
+		centroids[f] = (V.row(F(f, 0)) + V.row(F(f, 1)) + V.row(F(f, 2))).transpose() / 3.f;
+
+	// Split the range of the node at the median centroid, the children are added after the parent
+	Nodes.emplace_back();
+	Nodes[0].Count = FSize;
+	for (int n = 0; n < (int) Nodes.size(); ++n)
+	{
+		const int first = Nodes[n].First, count = Nodes[n].Count;
+		if (count <= LeafSize)
+		{
+			Nodes[n].Box.setEmpty();
+			for (int k = first; k < first + count; ++k)
+			{
+				FaceBoxes[k] = FaceBox(V, F, Faces[k]);
+				Nodes[n].Box.extend(FaceBoxes[k]);
+				LeafOfFace[Faces[k]] = n;
+			}
+			continue;
+		}
+
+		Eigen::AlignedBox3f centroidBox;
+		for (int k = first; k < first + count; ++k)
+			centroidBox.extend(centroids[Faces[k]]);
+		int axis;
+		centroidBox.sizes().maxCoeff(&axis);
+
+		const int half = count / 2;
+		std::nth_element(Faces.begin() + first, Faces.begin() + first + half, Faces.begin() + first + count,
+		                 [&](int a, int b) -> bool { return centroids[a](axis) < centroids[b](axis); });
+
+		Node left, right;
+		left.Parent = right.Parent = n;
+		left.First = first;
+		left.Count = half;
+		right.First = first + half;
+		right.Count = count - half;
+		Nodes[n].Left = Nodes.size();
+		Nodes[n].Right = Nodes.size() + 1;
+		Nodes.push_back(left);
+		Nodes.push_back(right);
+	}
+
+	// Inner boxes bottom-up
+	for (int n = (int) Nodes.size() - 1; n >= 0; --n)
+		if (Nodes[n].Left >= 0)
+			Nodes[n].Box = Nodes[Nodes[n].Left].Box.merged(Nodes[Nodes[n].Right].Box);
+}
+
+void FaceBvh::Refit(const VerticesRowMajor& V, const FacesRowMajor& F, const std::vector<int>& faces)
+{
+	// Mark the leaves and their ancestors, stop at an ancestor that is already marked
+	std::vector<char> isDirty(Nodes.size(), false);
+	for (const int f : faces)
+		for (int n = LeafOfFace[f]; n >= 0 && !isDirty[n]; n = Nodes[n].Parent)
+			isDirty[n] = true;
+
+	for (int n = (int) Nodes.size() - 1; n >= 0; --n)
+	{
+		if (!isDirty[n])
+			continue;
+
+		Node& node = Nodes[n];
+		if (node.Left >= 0)
+			node.Box = Nodes[node.Left].Box.merged(Nodes[node.Right].Box);
+		else
+		{
+			node.Box.setEmpty();
+			for (int k = node.First; k < node.First + node.Count; ++k)
+			{
+				FaceBoxes[k] = FaceBox(V, F, Faces[k]);
+				node.Box.extend(FaceBoxes[k]);
+			}
+		}
+	}
+}
+
+// --- Triangle-triangle test
+/**
+ * @return True if the segment pq intersects the triangle abc, a segment in the plane of the triangle is ignored
+ */
+static bool SegmentIntersectsTriangle(const Eigen::Vector3f& p, const Eigen::Vector3f& q,
+                                      const Eigen::Vector3f& a, const Eigen::Vector3f& b, const Eigen::Vector3f& c)
+{
+	// Möller-Trumbore with the segment parameter restricted to [0, 1]
+	const Eigen::Vector3f dir = q - p;
+	const Eigen::Vector3f e1 = b - a, e2 = c - a;
+	const Eigen::Vector3f h = dir.cross(e2);
+	const float det = e1.dot(h);
+	if (std::abs(det) < 1e-12f)
+		return false;
+
+	const float invDet = 1.f / det;
+	const Eigen::Vector3f s = p - a;
+	const float u = invDet * s.dot(h);
+	if (u < 0.f || u > 1.f)
+		return false;
+
+	const Eigen::Vector3f qv = s.cross(e1);
+	const float v = invDet * dir.dot(qv);
+	if (v < 0.f || u + v > 1.f)
+		return false;
+
+	const float t = invDet * e2.dot(qv);
+	return t >= 0.f && t <= 1.f;
+}
+
+/**
+ * @return True if the faces f and g intersect, i.e. an edge of one passes through the other
+ */
+static bool FacesIntersect(const VerticesRowMajor& V, const FacesRowMajor& F, int f, int g)
+{
+	Eigen::Vector3f tf[3], tg[3];
+	for (int k = 0; k < 3; ++k)
+	{
+		tf[k] = V.row(F(f, k)).transpose();
+		tg[k] = V.row(F(g, k)).transpose();
+	}
+
+	// Reject if one triangle is strictly on one side of the plane of the other
+	auto isOnOneSide = [](const Eigen::Vector3f* a, const Eigen::Vector3f* b) -> bool {
+		const Eigen::Vector3f normal = (a[1] - a[0]).cross(a[2] - a[0]);
+		const float d0 = normal.dot(b[0] - a[0]), d1 = normal.dot(b[1] - a[0]), d2 = normal.dot(b[2] - a[0]);
+		return (d0 > 0.f && d1 > 0.f && d2 > 0.f) || (d0 < 0.f && d1 < 0.f && d2 < 0.f);
+	};
+	if (isOnOneSide(tf, tg) || isOnOneSide(tg, tf))
+		return false;
+
+	for (int k = 0; k < 3; ++k)
+	{
+		if (SegmentIntersectsTriangle(tf[k], tf[(k + 1) % 3], tg[0], tg[1], tg[2]) ||
+		    SegmentIntersectsTriangle(tg[k], tg[(k + 1) % 3], tf[0], tf[1], tf[2]))
+			return true;
+	}
+	return false;
+}
+
+/**
+ * @return True if the faces share a vertex, they then touch and are not tested
+ */
+static bool FacesAreAdjacent(const FacesRowMajor& F, int f, int g)
+{
+	for (int i = 0; i < 3; ++i)
+		for (int j = 0; j < 3; ++j)
+			if (F(f, i) == F(g, j))
+				return true;
+	return false;
+}
+
+// --- Detection
+/**
+ * Create the detection data and build the BVH
+ */
+static SelfIntersectionData* CreateSelfIntersectionData(MeshState* state)
+{
+	auto* data = new SelfIntersectionData();
+	data->F = *state->F;
+	data->VChecked = *state->V;
+	data->Bvh.Build(data->VChecked, data->F);
+	return data;
+}
+
+/**
+ * Only the modified range of vertices is compared, so nothing is done if no vertex was modified.
+ * @return The faces with a vertex that moved since the last detection, sorted, updates VChecked
+ */
+static std::vector<int> FindMovedFaces(MeshState* state, SelfIntersectionData* data)
+{
+	const int begin = data->MovedBegin, end = data->MovedEnd;
+	data->MovedBegin = data->MovedEnd = 0;
+	std::vector<int> faces;
+	if (begin >= end)
+		return faces;
+
+	const auto& V = *state->V;
+	std::vector<char> isVMoved(end - begin, false);
+#pragma omp parallel for num_threads(GetWorkerThreads())
+	for (int i = begin; i < end; ++i)
+	{
+		if (V.row(i) == data->VChecked.row(i))
+			continue;
+
+		data->VChecked.row(i) = V.row(i);
+		isVMoved[i - begin] = true;
+	}
+
+	const auto& VF = state->Native->VertexFaces;
+	for (int i = begin; i < end; ++i)
+		if (isVMoved[i - begin])
+			faces.insert(faces.end(), VF.Begin(i), VF.End(i));
+	std::sort(faces.begin(), faces.end());
+	faces.erase(std::unique(faces.begin(), faces.end()), faces.end());
+	return faces;
+}
+
+/**
+ * Color the vertices of the intersecting faces and restore the colors of the others that were colored.
+ * The colors are set on every call, as they may have been overwritten since the last detection,
+ * CDirty is only set if a color changed.
+ * @param isEnabled If false only restore the colors
+ */
+static void ColorIntersections(MeshState* state, SelfIntersectionData* data, bool isEnabled)
+{
+	std::vector<int> vertices;
+	if (isEnabled)
+	{
+		const auto& F = data->F;
+		for (const auto& pair : data->Pairs)
+			for (int k = 0; k < 3; ++k)
+			{
+				vertices.push_back(F(pair.first, k));
+				vertices.push_back(F(pair.second, k));
+			}
+		std::sort(vertices.begin(), vertices.end());
+		vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+	}
+	if (vertices.empty() && data->ColoredVertices.empty())
+		return;
+
+	auto& native = *state->Native;
+	auto getColor = [&](int i) -> Color_t {
+		return native.CompactStorage ? Color_t(native.C8.row(i).cast<float>() / 255.f) : Color_t(state->C->row(i));
+	};
+	bool isChanged = false;
+	auto setColor = [&](int i, const Color_t& color) {
+		if (native.CompactStorage)
+		{
+			const auto color8 = ToRGBA8(color);
+			isChanged |= native.C8.row(i) != color8;
+			native.C8.row(i) = color8;
+		}
+		else
+		{
+			isChanged |= state->C->row(i) != color;
+			state->C->row(i) = color;
+		}
+	};
+
+	// Merge the sorted lists, keeping the saved color of vertices that stay colored
+	std::vector<Eigen::RowVector4f, Eigen::aligned_allocator<Eigen::RowVector4f>> saved;
+	saved.reserve(vertices.size());
+	size_t k = 0;
+	for (const int i : vertices)
+	{
+		for (; k < data->ColoredVertices.size() && data->ColoredVertices[k] < i; ++k)
+			setColor(data->ColoredVertices[k], data->SavedColors[k]);
+
+		if (k < data->ColoredVertices.size() && data->ColoredVertices[k] == i)
+			saved.push_back(data->SavedColors[k++]);
+		else
+			saved.push_back(getColor(i));
+		setColor(i, Color::White);
+	}
+	for (; k < data->ColoredVertices.size(); ++k)
+		setColor(data->ColoredVertices[k], data->SavedColors[k]);
+
+	data->ColoredVertices.swap(vertices);
+	data->SavedColors.swap(saved);
+	if (isChanged)
+		state->DirtyState |= DirtyFlag::CDirty;
+}
+
+int DetectSelfIntersections(MeshState* state, bool colorFaces)
+{
+	TraceScope trace(state, BatchOp::DetectSelfIntersections, [&](BatchCommand& cmd) {
+		cmd.Flags = colorFaces ? BatchFlag::ColorIntersections : BatchFlag::None;
+	});
+	state->EnsureInitialized();
+
+	auto*& data = state->Native->SelfIntersection;
+	std::vector<int> moved;
+	if (data == nullptr)
+	{
+		data = CreateSelfIntersectionData(state);
+		moved.resize(state->FSize);
+		for (int f = 0; f < state->FSize; ++f)
+			moved[f] = f;
+	}
+	else
+	{
+		moved = FindMovedFaces(state, data);
+		data->Bvh.Refit(data->VChecked, data->F, moved);
+	}
+
+	if (!moved.empty())
+	{
+		std::vector<char> isMoved(state->FSize, false);
+		for (const int f : moved)
+			isMoved[f] = true;
+
+		// Pairs of unmoved faces remain valid
+		auto& pairs = data->Pairs;
+		pairs.erase(std::remove_if(pairs.begin(), pairs.end(), [&](const std::pair<int, int>& pair) -> bool {
+			return isMoved[pair.first] || isMoved[pair.second];
+		}), pairs.end());
+
+		// Leaves with moved faces, each queries the BVH once for all its faces
+		auto& bvh = data->Bvh;
+		std::vector<int> leaves;
+		for (const int f : moved)
+			leaves.push_back(bvh.LeafOfFace[f]);
+		std::sort(leaves.begin(), leaves.end());
+		leaves.erase(std::unique(leaves.begin(), leaves.end()), leaves.end());
+
+		// A pair of two moved faces is only tested from the smaller face
+		const auto& V = data->VChecked;
+		const auto& F = data->F;
+		const int leafCount = leaves.size();
+#pragma omp parallel num_threads(GetWorkerThreads())
+		{
+			std::vector<std::pair<int, int>> found;
+#pragma omp for schedule(dynamic, 16) nowait
+			for (int l = 0; l < leafCount; ++l)
+			{
+				const auto& leaf = bvh.Nodes[leaves[l]];
+				bvh.Query(leaf.Box, [&](int g, const Eigen::AlignedBox3f& gBox) {
+					for (int k = leaf.First; k < leaf.First + leaf.Count; ++k)
+					{
+						const int f = bvh.Faces[k];
+						if (!isMoved[f] || g == f || (isMoved[g] && g < f) || !bvh.FaceBoxes[k].intersects(gBox) ||
+						    FacesAreAdjacent(F, f, g) || !FacesIntersect(V, F, f, g))
+							continue;
+						found.emplace_back(std::min(f, g), std::max(f, g));
+					}
+				});
+			}
+#pragma omp critical
+			pairs.insert(pairs.end(), found.begin(), found.end());
+		}
+		std::sort(pairs.begin(), pairs.end());
+	}
+
+	ColorIntersections(state, data, colorFaces);
+	return data->Pairs.size();
+}
+
+int GetSelfIntersections(MeshState* state, int* pairs, int capacity)
+{
+	state->EnsureInitialized();
+
+	const auto* data = state->Native->SelfIntersection;
+	if (data == nullptr)
+		return 0;
+
+	const int count = std::min(capacity, (int) data->Pairs.size());
+	for (int k = 0; k < count; ++k)
+	{
+		pairs[2 * k] = data->Pairs[k].first;
+		pairs[2 * k + 1] = data->Pairs[k].second;
+	}
+	return data->Pairs.size();
+}
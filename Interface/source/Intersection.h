@@ -0,0 +1,112 @@
+#pragma once
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <utility>
+#include <vector>
+
+/** Row major vertices and faces, so the corners of a face are read from few cache lines */
+using VerticesRowMajor = Eigen::Matrix<float, Eigen::Dynamic, 3, Eigen::RowMajor>;
+using FacesRowMajor = Eigen::Matrix<int, Eigen::Dynamic, 3, Eigen::RowMajor>;
+
+/**
+ * Bounding volume hierarchy over the faces of a mesh.
+ * Built once, when vertices move only the boxes containing their faces are refitted, the tree is kept.
+ */
+struct FaceBvh
+{
+	struct Node
+	{
+		Eigen::AlignedBox3f Box;
+		/** Children of an inner node, -1 for a leaf */
+		int Left{-1};
+		int Right{-1};
+		int Parent{-1};
+		/** Faces of a leaf, the range [First, First + Count) in Faces */
+		int First{0};
+		int Count{0};
+	};
+
+	/** Maximum number of faces in a leaf */
+	static const int LeafSize = 4;
+
+	/** The root is the first node, children always come after their parent */
+	std::vector<Node> Nodes;
+	/** Face indices ordered by leaf */
+	std::vector<int> Faces;
+	/** Bounding box of each face in Faces, same order, so a leaf is tested without reading V */
+	std::vector<Eigen::AlignedBox3f> FaceBoxes;
+	/** Leaf node containing each face */
+	std::vector<int> LeafOfFace;
+
+	/**
+	 * Build the tree top-down, splitting at the median face centroid along the longest axis
+	 */
+	void Build(const VerticesRowMajor& V, const FacesRowMajor& F);
+
+	/**
+	 * Recalculate the boxes of the leaves containing the faces and their ancestors
+	 * @param faces Faces with moved vertices
+	 */
+	void Refit(const VerticesRowMajor& V, const FacesRowMajor& F, const std::vector<int>& faces);
+
+	/**
+	 * Call <code>fn(face, faceBox)</code> for each face whose box overlaps the box
+	 */
+	template<typename Fn>
+	void Query(const Eigen::AlignedBox3f& box, Fn&& fn) const
+	{
+		int stack[64];
+		int size = 0;
+		stack[size++] = 0;
+		while (size > 0)
+		{
+			const Node& node = Nodes[stack[--size]];
+			if (!node.Box.intersects(box))
+				continue;
+
+			if (node.Left < 0)
+			{
+				for (int k = node.First; k < node.First + node.Count; ++k)
+					if (FaceBoxes[k].intersects(box))
+						fn(Faces[k], FaceBoxes[k]);
+			}
+			else
+			{
+				stack[size++] = node.Left;
+				stack[size++] = node.Right;
+			}
+		}
+	}
+};
+
+/**
+ * State of the incremental self-intersection detection, see DetectSelfIntersections
+ */
+struct SelfIntersectionData
+{
+	FaceBvh Bvh;
+	/** V at the last detection, used to find the moved vertices and for the tests */
+	VerticesRowMajor VChecked;
+	/** Range of vertices [MovedBegin, MovedEnd) modified since the last detection, extended by ExtendDirtyV */
+	int MovedBegin{0};
+	int MovedEnd{0};
+	/** Copy of F */
+	FacesRowMajor F;
+
+	/** Intersecting face pairs (f, g) with f < g, sorted */
+	std::vector<std::pair<int, int>> Pairs;
+
+	/** Vertices colored as intersecting, sorted, with their previous colors in the same order */
+	std::vector<int> ColoredVertices;
+	std::vector<Eigen::RowVector4f, Eigen::aligned_allocator<Eigen::RowVector4f>> SavedColors;
+
+	/**
+	 * Forget the colored vertices after all colors were overwritten, e.g. by SetColorByMask.
+	 * The next detection colors them again and saves the new colors.
+	 */
+	void ResetColors()
+	{
+		ColoredVertices.clear();
+		SavedColors.clear();
+	}
+};
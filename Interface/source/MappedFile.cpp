@@ -0,0 +1,65 @@
+#include "MappedFile.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const char* path, bool writable)
+{
+#ifdef _WIN32
+	File = CreateFileA(path, writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ, FILE_SHARE_READ, nullptr,
+	                   OPEN_EXISTING, writable ? FILE_FLAG_RANDOM_ACCESS : FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	LARGE_INTEGER size;
+	if (File == INVALID_HANDLE_VALUE || !GetFileSizeEx(File, &size) || size.QuadPart == 0)
+		return;
+	Mapping = CreateFileMappingA(File, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr);
+	if (Mapping == nullptr)
+		return;
+	Data = static_cast<char*>(MapViewOfFile(Mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0));
+	if (Data != nullptr)
+		Size = size.QuadPart;
+#else
+	File = open(path, writable ? O_RDWR : O_RDONLY);
+	struct stat info{};
+	if (File < 0 || fstat(File, &info) != 0 || info.st_size == 0)
+		return;
+	void* data = mmap(nullptr, info.st_size, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+	                  writable ? MAP_SHARED : MAP_PRIVATE, File, 0);
+	if (data == MAP_FAILED)
+		return;
+	madvise(data, info.st_size, writable ? MADV_RANDOM : MADV_WILLNEED);
+	Data = static_cast<char*>(data);
+	Size = info.st_size;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef _WIN32
+	if (Data != nullptr)
+		UnmapViewOfFile(Data);
+	if (Mapping != nullptr)
+		CloseHandle(Mapping);
+	if (File != INVALID_HANDLE_VALUE)
+		CloseHandle(File);
+#else
+	if (Data != nullptr)
+		munmap(Data, Size);
+	if (File >= 0)
+		close(File);
+#endif
+}
+
+bool MappedFile::Flush()
+{
+	if (Data == nullptr)
+		return false;
+#ifdef _WIN32
+	return FlushViewOfFile(Data, 0) && FlushFileBuffers(File);
+#else
+	return msync(Data, Size, MS_SYNC) == 0;
+#endif
+}
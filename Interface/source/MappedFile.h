@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+
+// _WIN32 instead of UNITY_WIN, so this does not depend on the Unity platform defines
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+/**
+ * Memory mapping of a whole file, unmapped on destruction. Data is nullptr if the file could not be mapped.
+ * A read-only file is read ahead, as it is expected to be read once from start to end.
+ * A writable mapping is shared, so writes go to the file, and is accessed randomly.
+ */
+class MappedFile
+{
+public:
+	explicit MappedFile(const char* path, bool writable = false);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	/**
+	 * Write the modified pages of a writable mapping to the file
+	 * @return True if successful
+	 */
+	bool Flush();
+
+	char* Data{nullptr};
+	size_t Size{0};
+
+private:
+#ifdef _WIN32
+	HANDLE File{INVALID_HANDLE_VALUE};
+	HANDLE Mapping{nullptr};
+#else
+	int File{-1};
+#endif
+};
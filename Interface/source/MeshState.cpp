@@ -1,7 +1,11 @@
 #include "MeshState.h"
+#include "Native.h"
+#include "Topology.h"
+#include "Reorder.h"
 #include "Util.h"
+#include <igl/cotmatrix.h>
 
-MeshState::MeshState(const UMeshDataNative udata)
+MeshState::MeshState(const UMeshDataNative udata, bool reorder)
 {
 	VSize = udata.VSize;
 	FSize = udata.FSize;
@@ -14,13 +18,6 @@ MeshState::MeshState(const UMeshDataNative udata)
 
 	S = new Eigen::VectorXi(VSize);
 
-	// Copy over data
-	TransposeFromMap(udata.VPtr, V);
-	TransposeFromMap(udata.NPtr, N);
-	TransposeFromMap(udata.CPtr, C);
-	TransposeFromMap(udata.UVPtr, UV);
-	TransposeFromMap(udata.FPtr, F);
-
 	// Selection
 	S->setZero();
 	DirtySelections = (unsigned int) -1;
@@ -29,11 +26,79 @@ MeshState::MeshState(const UMeshDataNative udata)
 	SSizes = new unsigned int[32];
 	std::fill(SSizes, SSizes + 32, 0);
 
-	Native = new MeshStateNative(V);
+	// Colors are reset in the deferred initialization
+	DirtyState |= DirtyFlag::CDirty;
+
+	Native = new MeshStateNative(VSize);
+	if (reorder)
+	{
+		// The reordered mesh is written to the Unity mesh in the first ApplyDirty, see ReorderMesh.
+		// Set here, the dirty state must not be modified by the deferred initialization.
+		DirtyState |= DirtyFlag::VDirty | DirtyFlag::NDirty | DirtyFlag::UVDirty | DirtyFlag::FDirty;
+		Native->ExtendDirtyV(0, VSize);
+	}
+	Native->InitTask = std::async(std::launch::async, &MeshState::InitializeDeferred, this, udata, reorder);
+}
+
+void MeshState::InitializeDeferred(const UMeshDataNative udata, bool reorder)
+{
+	// Copy over data, attributes are independent so copy them in parallel
+	// Note: C is not copied as we reset the colors anyway
+#pragma omp parallel sections num_threads(GetWorkerThreads())
+	{
+#pragma omp section
+		{
+			TransposeFromMap(udata.VPtr, V);
+			*Native->V0 = *V;
+		}
+#pragma omp section
+		TransposeFromMap(udata.NPtr, N);
+#pragma omp section
+		TransposeFromMap(udata.UVPtr, UV);
+#pragma omp section
+		TransposeFromMap(udata.FPtr, F);
+	}
+
+	// Reset colors, equivalent to SetColorByMask(0)
+	C->rowwise() = Color::Gray;
+
+	if (reorder)
+		ReorderMesh(this);
+
+#pragma omp parallel sections num_threads(GetWorkerThreads())
+	{
+#pragma omp section
+		BuildVertexVertices(*F, VSize, Native->VertexVertices);
+#pragma omp section
+		BuildVertexFaces(*F, VSize, Native->VertexFaces);
+#pragma omp section
+		igl::cotmatrix(*Native->V0, *F, Native->Laplacian);
+	}
+
+	Native->IsInitialized.store(true, std::memory_order_release);
+}
+
+void MeshState::EnsureInitialized()
+{
+	if (Native->IsInitialized.load(std::memory_order_acquire))
+		return;
+
+	std::lock_guard<std::mutex> lock(Native->InitMutex);
+	if (Native->InitTask.valid())
+		Native->InitTask.get();
+}
+
+bool MeshState::IsInitialized() const
+{
+	return Native->IsInitialized.load(std::memory_order_acquire);
 }
 
 MeshState::~MeshState()
 {
+	EnsureInitialized();
+	DisableNativeUpload(this);
+	DisableOutputFrames(this);
+
 	delete V;
 	delete N;
 	delete C;
@@ -85,13 +85,33 @@ struct MeshState
 	MeshStateNative* Native;
 
 	/**
-	 * Initialise the shared state from a Unity mesh
-	 * @param udata All data required to create the state
+	 * Initialise the shared state from a Unity mesh.
+	 * Only allocates memory, copying the data is deferred to a worker thread, see InitializeDeferred.
+	 * @param udata All data required to create the state, must stay valid until initialization has finished
+	 * @param reorder Reorder the vertices and faces for memory locality, see ReorderMesh
 	 */
-	explicit MeshState(UMeshDataNative udata);
+	explicit MeshState(UMeshDataNative udata, bool reorder = false);
 
 	/**
 	 * This is where all C++ allocated memory for a mesh is deleted.
+	 * Waits for the deferred initialization to finish first.
 	 */
 	~MeshState();
+
+	/**
+	 * Blocks until the deferred initialization has finished. Cheap once the mesh is initialized.
+	 * Call this before accessing any mesh data, i.e. at the start of every exported function.
+	 */
+	void EnsureInitialized();
+
+	/**
+	 * @return True if the deferred initialization has finished, does not block.
+	 */
+	bool IsInitialized() const;
+
+	/**
+	 * The expensive part of the initialization, run on a worker thread.
+	 * Copies the attributes, V0, resets the colors and precomputes the topology in MeshStateNative.
+	 */
+	void InitializeDeferred(UMeshDataNative udata, bool reorder);
 };
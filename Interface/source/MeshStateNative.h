@@ -1,6 +1,19 @@
 #pragma once
 
+#include "Attributes.h"
+#include "Intersection.h"
+#include "SelectionSets.h"
+#include "Topology.h"
+#include "Util.h"
 #include<igl/arap.h>
+#include <igl/heat_geodesics.h>
+#include <Eigen/Sparse>
+#include <atomic>
+#include <future>
+#include <mutex>
+
+struct VertexUploadData;
+struct OutputFrames;
 
 /**
  * Contains all variables that are only used in C++ for a specific mesh.
@@ -8,6 +21,29 @@
  */
 struct MeshStateNative
 {
+	// --- Deferred Initialization
+	/**
+	 * The deferred part of the MeshState constructor, running on a worker thread.
+	 * @see MeshState::EnsureInitialized
+	 */
+	std::future<void> InitTask;
+	/** Guards InitTask so several threads may wait for it at the same time */
+	std::mutex InitMutex;
+	/** Set once the deferred initialization has finished, can be queried without blocking */
+	std::atomic<bool> IsInitialized{false};
+
+	// --- Topology, computed in the deferred initialization
+	/** Neighbors of each vertex, sorted */
+	CsrAdjacency VertexVertices;
+	/** Faces of each vertex, sorted */
+	CsrAdjacency VertexFaces;
+	/** Cotangent Laplacian of V0 with dimensions VSize x VSize */
+	Eigen::SparseMatrix<float> Laplacian;
+	/** Index in the Unity mesh of each vertex if the mesh was reordered when loaded, otherwise empty, see ReorderMesh */
+	Eigen::VectorXi VertexOrder;
+	/** Index in the Unity mesh of each face if the mesh was reordered when loaded, otherwise empty */
+	Eigen::VectorXi FaceOrder;
+
 	// --- Harmonic & ARAP
 	/**
 	 * Vertices part of the boundary. Has a variable length.
@@ -25,6 +61,8 @@ struct MeshStateNative
 	 * @note Evaluated in a lazy manner.
 	 */
 	unsigned int BoundaryMask{0};
+	/** The selection sets currently used for the Boundary, sorted */
+	std::vector<int> BoundarySetIds;
 	/**
 	 * Selections that have changed since the last time the Boundary was calculated.
 	 * Used for lazy recalculation of Boundary.
@@ -36,6 +74,47 @@ struct MeshStateNative
 	 */
 	bool DirtyBoundaryConditions{true};
 
+	/**
+	 * Range of vertices [DirtyVBegin, DirtyVEnd) modified since the last ApplyDirty, extend it with ExtendDirtyV.
+	 * If VDirty is set and the range is empty all vertices are considered modified.
+	 */
+	int DirtyVBegin{0};
+	int DirtyVEnd{0};
+
+	/**
+	 * Double buffered positions for the native GPU upload, nullptr if the managed upload is used.
+	 * @see EnableNativeUpload
+	 */
+	VertexUploadData* Upload{nullptr};
+
+	/**
+	 * Triple buffered output of ApplyDirty, nullptr if ApplyDirty writes to the Unity mesh data.
+	 * @see EnableOutputFrames
+	 */
+	OutputFrames* Frames{nullptr};
+
+	// --- Compact Storage, see SetCompactStorage
+	/**
+	 * If true the colors, UVs and selections are stored in C8, UV16 and S8/S16 instead of the MeshState matrices,
+	 * which are then empty. They are converted to floats only in ApplyDirty.
+	 */
+	bool CompactStorage{false};
+	/** RGBA8 colors with dimensions VSize x 4, row major so one vertex is one 32 bit word */
+	Eigen::Matrix<unsigned char, Eigen::Dynamic, 4, Eigen::RowMajor> C8;
+	/** Half precision UV0 with dimensions VSize x 2 */
+	Eigen::Matrix<Eigen::half, Eigen::Dynamic, 2, Eigen::RowMajor> UV16;
+	/** Packed selection vectors, only the one matching SWidth is used. Access these via VisitS. */
+	Eigen::Matrix<unsigned char, Eigen::Dynamic, 1> S8;
+	Eigen::Matrix<unsigned short, Eigen::Dynamic, 1> S16;
+	/** Bits per vertex in the selection vector, 8 (S8), 16 (S16) or 32 (MeshState::S) */
+	int SWidth{32};
+
+	/** Selections beyond the 32 in S, see AddSelectionSet */
+	SelectionSetStore SelectionSets;
+
+	/** Named channels beyond the attributes of MeshState, see AddAttribute */
+	AttributeStore Attributes;
+
 	/** Initial V, before deformations. Used for deformations and resetting V */
 	Eigen::MatrixXf* V0;
 
@@ -44,13 +123,123 @@ struct MeshStateNative
 
 	/** Pre-computations for Arap */
 	igl::ARAPData<float>* ArapData{nullptr};
+	/** Maximum local-global iterations of an Arap call, see SetArapConvergence */
+	int ArapMaxIterations{100};
+	/** Arap stops when no vertex moved further than this relative to the bounding box diagonal in an iteration */
+	float ArapTolerance{0.f};
+	/** Iterations and relative residual of the last Arap call, see GetArapStats */
+	int ArapIterations{0};
+	float ArapResidual{0.f};
+
+	// --- Analysis
+	/** Area and the 3 angles of each face of V0, computed by the first AnalyzeDeformation */
+	Eigen::Matrix<float, Eigen::Dynamic, 4, Eigen::RowMajor> RestFaceShape;
 
-	explicit MeshStateNative(Eigen::MatrixXf* V) : V0(new Eigen::MatrixXf(*V))
+	// --- Symmetry, see SetSymmetry
+	/** Normal of the symmetry plane, 0, 1 or 2 for x, y or z, -1 if symmetry is disabled */
+	int SymmetryAxis{-1};
+	/** Position of the symmetry plane along the SymmetryAxis */
+	float SymmetryPlane{0.f};
+	/** Tolerance the Mirror was computed with, relative to the bounding box diagonal */
+	float SymmetryTolerance{0.f};
+	/** Side of the plane of the last brush, +1 or -1, edits are mirrored to the other side */
+	float SymmetrySide{1.f};
+	/** Index of the mirror of each vertex in V0, itself on the plane, -1 if it has none */
+	Eigen::VectorXi Mirror;
+
+	// --- Solver scheduling, see Scheduler.h
+	/** Weight of the mesh when sharing the worker threads between solvers, see SetSolverPriority */
+	std::atomic<float> SolverPriority{1.f};
+	/** Threads of the last solver of the mesh, see GetSolverThreads */
+	std::atomic<int> SolverThreads{0};
+
+	// --- Smoothing, see Smooth.cpp
+	/**
+	 * The cotangent Laplacian restricted to the selected vertices, recalculated when the selected vertices change.
+	 * Rows are row major so the products are multithreaded by Eigen.
+	 */
+	struct SmoothData
+	{
+		/** The selected vertices, these are modified, all others are fixed */
+		Eigen::VectorXi Interior;
+		/** Rows of the Laplacian of the Interior, with dimensions Interior.size() x VSize */
+		Eigen::SparseMatrix<float, Eigen::RowMajor> L;
+		/** Negated diagonal of L, the sum of the cotangent weights */
+		Eigen::VectorXf D;
+		/** Submatrix of L of the Interior rows and columns */
+		Eigen::SparseMatrix<float> LII;
+
+		/** Factorization of <code>D - lambda * L_II</code> for the implicit smoothing */
+		Eigen::SimplicialLDLT<Eigen::SparseMatrix<float>> Implicit;
+		float ImplicitLambda{0.f};
+		bool HasImplicit{false};
+		/**
+		 * Rows of the bilaplacian <code>L D^-1 L</code> of the Interior, with dimensions Interior.size() x VSize.
+		 * In double precision as the bilaplacian is badly conditioned.
+		 */
+		Eigen::SparseMatrix<double, Eigen::RowMajor> K;
+		/** Submatrix of K of the Interior rows and columns */
+		Eigen::SparseMatrix<double> KII;
+		/** Factorization of <code>K_II</code> for fairing */
+		Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> Fair;
+		bool HasFair{false};
+	};
+	SmoothData* Smooth{nullptr};
+
+	// --- Skinning, see Skinning.cpp
+	/**
+	 * Precomputed linear blend skinning of the handles, so a deformation is a single sparse matrix product.
+	 * The rest pose is V when the weights were computed.
+	 */
+	struct SkinningData
+	{
+		/** Selection id of each handle */
+		std::vector<int> Handles;
+		/** V when the weights were computed */
+		Eigen::MatrixXf VRest;
+		/**
+		 * Linear blend skinning matrix with dimensions VSize x 4 * Handles.size().
+		 * Row i contains <code>w_ih * [v_i, 1]</code> in the columns of handle h, with the sparse weights w.
+		 */
+		Eigen::SparseMatrix<float, Eigen::RowMajor> M;
+		/**
+		 * Affine transformation of each handle from the rest pose minus the identity, transposed and stacked,
+		 * with dimensions 4 * Handles.size() x 3. So the deformed vertices are <code>VRest + M * T</code>.
+		 */
+		Eigen::MatrixXf T;
+	};
+	SkinningData* Skinning{nullptr};
+
+	/** Prefactored heat method systems of V0, see GeodesicDistance */
+	igl::HeatGeodesicsData<double>* HeatGeodesics{nullptr};
+
+	/** Incremental self-intersection detection, see DetectSelfIntersections */
+	SelfIntersectionData* SelfIntersection{nullptr};
+
+	/**
+	 * @param VSize Number of vertices, V0 is allocated but only filled in the deferred initialization
+	 */
+	explicit MeshStateNative(int VSize) : V0(new Eigen::MatrixXf(VSize, 3))
 	{}
 
+	/**
+	 * Mark the vertices [begin, end) as modified, use this together with DirtyFlag::VDirty
+	 */
+	void ExtendDirtyV(int begin, int end)
+	{
+		UnionRange(DirtyVBegin, DirtyVEnd, begin, end);
+		// ApplyDirty resets the dirty range, the detection keeps its own until it runs
+		if (SelfIntersection != nullptr)
+			UnionRange(SelfIntersection->MovedBegin, SelfIntersection->MovedEnd, begin, end);
+	}
+
 	virtual ~MeshStateNative()
 	{
 		delete V0;
 		delete ArapData;
+		delete Smooth;
+		delete Skinning;
+		delete SelfIntersection;
+		delete HeatGeodesics;
 	}
 };
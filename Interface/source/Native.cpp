@@ -1,4 +1,6 @@
 #include "Native.h"
+#include "Upload.h"
+#include "Trace.h"
 #include <igl/readOBJ.h>
 #include <igl/jet.h>
 
@@ -21,31 +23,35 @@ void Initialize(const StringCallback debugCallback, StringCallback debugWarningC
 	LOG("Initialized Native.")
 }
 
-MeshState* InitializeMesh(const UMeshDataNative data, const char* name)
+MeshState* InitializeMesh(const UMeshDataNative data, const char* name, bool reorder)
 {
 	// LOG("InitializeMesh(): " << name)
-	auto* state = new MeshState(data);
-
-	// Reset color immediately
-	SetColorByMask(state, 0);
-	state->DirtyState |= DirtyFlag::CDirty;
+	// Copying the data and resetting the colors is deferred to a worker thread
+	return new MeshState(data, reorder);
+}
 
-	return state;
+bool IsMeshInitialized(MeshState* state)
+{
+	return state->IsInitialized();
 }
 
 void DisposeMesh(MeshState* state)
 {
+	TraceDispose(state);
 	delete state;
 }
 
 void UNITY_INTERFACE_API UnityPluginLoad(IUnityInterfaces* unityInterfaces)
 {
 	s_IUnityInterfaces = unityInterfaces;
+	InitializeGraphics(unityInterfaces);
 	LOG("UnityPluginLoad()")
 }
 
 void UNITY_INTERFACE_API UnityPluginUnload()
 {
+	StopTrace();
+	DisposeGraphics();
 	s_IUnityInterfaces = nullptr;
 
 	LOG("UnityPluginUnload()")
@@ -1,5 +1,6 @@
 #pragma once
 #include <PluginAPI/IUnityInterface.h>
+#include <PluginAPI/IUnityGraphics.h>
 #include <RenderAPI/RenderAPI.h>
 #include <string>
 #include "MeshState.h"
@@ -10,6 +11,8 @@
 /** Access to the Unity interfaces, currently not used. */
 extern IUnityInterfaces* s_IUnityInterfaces;
 
+struct StreamingMesh;
+
 extern "C"
 {
 // --- Native.cpp
@@ -23,12 +26,22 @@ UNITY_INTERFACE_EXPORT void
 Initialize(StringCallback debugCallback, StringCallback debugWarningCallback, StringCallback debugErrorCallback);
 
 /**
- * Called when a new mesh is loaded. Initialize global variables, do pre-calculations for a mesh
- * @param data The Unity MeshData
+ * Called when a new mesh is loaded. Initialize global variables, do pre-calculations for a mesh.
+ * Only allocates the state, copying the data and pre-calculations are deferred to a worker thread
+ * and are finished lazily when the state is first used.
+ * @param data The Unity MeshData, pointers must stay valid until the mesh is initialized
  * @param name Name of the mesh
+ * @param reorder Sort the vertices and faces so vertices close in space are close in memory, see ReorderMesh.
+ * The reordered mesh is written to the data in the first ApplyDirty, including the faces, see GetMeshOrder.
+ * The Unity mesh must not have other vertex attributes than the ones in the data.
  * @return A pointer to the C++ state for this mesh
  */
-UNITY_INTERFACE_EXPORT MeshState* InitializeMesh(const UMeshDataNative data, const char* name);
+UNITY_INTERFACE_EXPORT MeshState* InitializeMesh(const UMeshDataNative data, const char* name, bool reorder = false);
+
+/**
+ * @return True if the deferred initialization of the mesh has finished, i.e. using the state will not block.
+ */
+UNITY_INTERFACE_EXPORT bool IsMeshInitialized(MeshState* state);
 
 /**
  * Disposes all C++ state tied to a mesh properly
@@ -85,6 +98,39 @@ ReadOFF(const char* path, const bool setCenter, const bool normalizeScale, const
         int& VSize, void*& NPtr, int& NSize, void*& FPtr, int& FSize, bool calculateNormalsIfEmpty = false);
 
 
+// --- Session.cpp
+/**
+ * Save the modelling session of a mesh: V, V0, all selections and selection sets, colors and the deformation boundary.
+ * @param path File to write the session to. It is written to <code>path.tmp</code> first and only replaced once the
+ * session is complete, so a failed save keeps the previous session.
+ * @param includeCaches Also save the topology, the ARAP factorization and the skinning weights, so they are not
+ * recomputed after loading. Other caches, e.g. of the smoothing and geodesics, are always recomputed lazily.
+ * @return True if the session was written
+ * @see Session.h for the file format
+ */
+UNITY_INTERFACE_EXPORT bool SaveSession(MeshState* state, const char* path, bool includeCaches = true);
+
+/**
+ * Load a session saved with SaveSession into a mesh with the same number of vertices and faces.
+ * The file is memory-mapped and copied into the mesh, the saved caches are used as is.
+ * Call ApplyDirty afterwards to update the Unity mesh.
+ * The whole file is validated before the mesh is modified, e.g. the sizes of the matrices and the vertex indices.
+ * @return False if the file is not a session of this mesh or is invalid, the mesh is unchanged then
+ */
+UNITY_INTERFACE_EXPORT bool LoadSession(MeshState* state, const char* path);
+
+
+// --- Reorder.cpp
+/**
+ * Get the permutation applied to a mesh initialized with <code>reorder</code>, see InitializeMesh.
+ * Vertex i of the MeshState was vertex vertexOrder[i] of the Unity mesh, the same for the faces.
+ * @param [out] vertexOrder Array of VSize, may be nullptr
+ * @param [out] faceOrder Array of FSize, may be nullptr
+ * @return False if the mesh was not reordered, the arrays are not written then
+ */
+UNITY_INTERFACE_EXPORT bool GetMeshOrder(MeshState* state, int* vertexOrder, int* faceOrder);
+
+
 // --- ModifyMesh.cpp
 /**
  * Debug function to simply translate all vertices by the value.
@@ -123,12 +169,178 @@ Harmonic(MeshState* state, unsigned int boundaryMask = -1, bool showDeformationF
  */
 UNITY_INTERFACE_EXPORT void Arap(MeshState* state, unsigned int boundaryMask = -1);
 
+/**
+ * Harmonic with the boundary given by selections and selection sets.
+ * @param boundary Which selections and selection sets to use as the boundary
+ * @see Harmonic
+ */
+UNITY_INTERFACE_EXPORT void HarmonicSets(MeshState* state, SelectionMask boundary, bool showDeformationField = true);
+
+/**
+ * Arap with the boundary given by selections and selection sets.
+ * @param boundary Which selections and selection sets to use as the boundary
+ * @see Arap
+ */
+UNITY_INTERFACE_EXPORT void ArapSets(MeshState* state, SelectionMask boundary);
+
+/**
+ * Set when Arap stops iterating. Arap starts from the current V, so after a small drag of the handles
+ * it converges in a few iterations instead of running all of them.
+ * @param maxIterations Maximum local-global iterations per Arap call
+ * @param tolerance Stop when no vertex moved further than tolerance times the bounding box diagonal in an iteration,
+ * 0 to always run maxIterations
+ */
+UNITY_INTERFACE_EXPORT void SetArapConvergence(MeshState* state, int maxIterations = 100, float tolerance = 0.f);
+
+/**
+ * @return The local-global iterations of the last Arap call, 0 if it did not solve as the boundary conditions were unchanged
+ * @param residual The largest displacement of a vertex in the last iteration relative to the bounding box diagonal,
+ * 0 when no tolerance is set as the iterations are then not checked
+ */
+UNITY_INTERFACE_EXPORT int GetArapStats(MeshState* state, float& residual);
+
+/**
+ * @return The ARAP energy of V with respect to V0, the cotangent weighted squared difference of the edges to each vertex
+ * and the best rotation of its rest edges. Computed on demand with an SVD per vertex.
+ */
+UNITY_INTERFACE_EXPORT float GetArapEnergy(MeshState* state);
+
 /**
  * Reset the vertices to their initial position V0 (set when loading the mesh).
  */
 UNITY_INTERFACE_EXPORT void ResetV(MeshState* state);
 
 
+// --- Smooth.cpp
+/**
+ * Explicit Laplacian smoothing of the selected vertices, the other vertices are fixed.
+ * Each step moves a vertex towards the cotangent weighted mean of its neighbors.
+ * The restricted Laplacian is cached until the selected vertices change, so repeated calls are cheap.
+ * @param maskId Which selections to smooth
+ * @param lambda Step size, in [0, 1] for a stable result
+ * @param iterations Number of steps
+ */
+UNITY_INTERFACE_EXPORT void SmoothSelection(MeshState* state, unsigned int maskId, float lambda = 0.5f, int iterations = 1);
+
+/**
+ * Implicit Laplacian smoothing (backward Euler) of the selected vertices, stable for any <code>lambda</code>.
+ * The factorization is cached while the selected vertices and <code>lambda</code> stay the same.
+ * @param maskId Which selections to smooth
+ * @param lambda Step size, larger values smooth more, nothing is done if it is not positive
+ */
+UNITY_INTERFACE_EXPORT void SmoothSelectionImplicit(MeshState* state, unsigned int maskId, float lambda = 1.f);
+
+/**
+ * Bilaplacian fairing of the selected vertices, the selection border is fixed.
+ * Replaces the selected region with the smoothest surface that connects to the rest of the mesh.
+ * @param maskId Which selections to fair, must not contain a whole connected component
+ */
+UNITY_INTERFACE_EXPORT void FairSelection(MeshState* state, unsigned int maskId);
+
+
+// --- Analysis.cpp
+/**
+ * Measure how far the mesh has moved from V0, in one parallel pass over the vertices and faces.
+ * Cheap enough to call every frame during a deformation, e.g. after Arap.
+ * @param [out] stats Summary of the displacement and the distortion of the faces
+ * @param [out] displacement Distance of each vertex from V0, array of VSize, may be nullptr
+ * @param [out] areaDistortion Ratio of the area of each face to its rest area, array of FSize, may be nullptr
+ * @param [out] angleDistortion Largest change of an angle of each face in radians, array of FSize, may be nullptr
+ * @param colorMode Which quantity to write as a color ramp to C, use DeformationColor constants.
+ * Call SetColorByMask to show the selections again.
+ * @param colorMax Value shown red, values above are clamped. If 0 the largest value of this call is used.
+ */
+UNITY_INTERFACE_EXPORT void AnalyzeDeformation(MeshState* state, DeformationStats& stats, float* displacement = nullptr,
+                                               float* areaDistortion = nullptr, float* angleDistortion = nullptr,
+                                               unsigned int colorMode = DeformationColor::None, float colorMax = 0.f);
+
+
+// --- Skinning.cpp
+/**
+ * Precompute a linear blend skinning deformation with one handle per selection, see TransformHandles.
+ * The weights are computed once and cached sparsely, the current vertices become the rest pose.
+ * Vertices not influenced by any handle, e.g. in a component without a handle, keep their rest position.
+ * @param handleMask Which selections are handles, if none contain vertices the skinning is removed
+ * @param bounded Compute bounded biharmonic weights (igl::bbw), slower but without negative weights.
+ * Otherwise biharmonic weights (igl::harmonic).
+ */
+UNITY_INTERFACE_EXPORT void ComputeSkinningWeights(MeshState* state, unsigned int handleMask, bool bounded = false);
+
+/**
+ * Transform handles and deform the mesh with linear blend skinning, a single sparse matrix product.
+ * The transformation is applied after the current one of each handle, as TransformSelection does for the vertices.
+ * @param maskId Which handles to transform, selections that are not handles are ignored
+ * @see ComputeSkinningWeights
+ */
+UNITY_INTERFACE_EXPORT void TransformHandles(MeshState* state, Vector3 translation, float scale, Quaternion rotation,
+                                             Vector3 pivot, unsigned int maskId = -1);
+
+
+// --- Geodesic.cpp
+/**
+ * Geodesic distance from the selected vertices to all vertices with the heat method.
+ * The heat and Poisson systems of V0 are factorized on the first call, then each query is two back-substitutions.
+ * @remarks From libigl Tutorial 716, https://libigl.github.io/tutorial/#heat-method-for-fast-geodesic-distance
+ * @param sourceMask Which selections are the sources, distance zero
+ * @param distances Optional output of VSize distances, may be nullptr
+ * @param colorByDistance Write the distance as a color ramp to C, see igl::jet
+ * @return The largest distance, or -1 if no vertex is selected
+ */
+UNITY_INTERFACE_EXPORT float GeodesicDistance(MeshState* state, unsigned int sourceMask, float* distances = nullptr,
+                                              bool colorByDistance = false);
+
+
+// --- Intersection.cpp
+/**
+ * Detect intersecting faces of the mesh, faces sharing a vertex are not tested.
+ * The first call builds a BVH over the faces and tests all of them. Later calls refit the BVH and only test the
+ * faces with moved vertices, so this can run every frame while editing.
+ * @param colorFaces Color the vertices of intersecting faces white, their previous color is restored once they no
+ * longer intersect
+ * @return Number of intersecting face pairs
+ */
+UNITY_INTERFACE_EXPORT int DetectSelfIntersections(MeshState* state, bool colorFaces = true);
+
+/**
+ * Get the intersecting face pairs of the last DetectSelfIntersections.
+ * @param pairs Array of <code>2 * capacity</code> face indices, filled with pairs (f, g) where f < g
+ * @return Number of pairs, may be larger than the capacity
+ */
+UNITY_INTERFACE_EXPORT int GetSelfIntersections(MeshState* state, int* pairs, int capacity);
+
+
+// --- Topology.cpp
+// Selection operations walking the cached vertex adjacency. The work is proportional to the selection and the
+// vertices reached, apart from gathering the selected vertices. selectionId may also be a selection set.
+/**
+ * Add the neighbors of the selection, ring by ring.
+ * @param rings Number of rings to add
+ */
+UNITY_INTERFACE_EXPORT void GrowSelection(MeshState* state, int selectionId, int rings = 1);
+
+/**
+ * Remove the border of the selection ring by ring, see SelectBorder.
+ * @param rings Number of rings to remove
+ */
+UNITY_INTERFACE_EXPORT void ShrinkSelection(MeshState* state, int selectionId, int rings = 1);
+
+/**
+ * Keep only the border of the selection, the selected vertices with an unselected neighbor
+ * or on the boundary of the mesh.
+ */
+UNITY_INTERFACE_EXPORT void SelectBorder(MeshState* state, int selectionId);
+
+/**
+ * Add the whole boundary loops of the mesh that contain a selected vertex, e.g. to select a hole.
+ */
+UNITY_INTERFACE_EXPORT void SelectBoundaryLoops(MeshState* state, int selectionId);
+
+/**
+ * Add all vertices connected to the selection, i.e. select the connected components.
+ */
+UNITY_INTERFACE_EXPORT void SelectConnected(MeshState* state, int selectionId);
+
+
 // --- Selection.cpp
 /**
  * Modify the selection inside a sphere.
@@ -171,8 +383,305 @@ UNITY_INTERFACE_EXPORT void SetColorSingleByMask(MeshState* state, unsigned int
  */
 UNITY_INTERFACE_EXPORT void SetColorByMask(MeshState* state, unsigned int maskId = -1);
 
-// --- sample/CustomUploadMesh.cpp
-// UNITY_INTERFACE_EXPORT UnityRenderingEventAndData GetUploadMeshPtr();
-// UNITY_INTERFACE_EXPORT void UploadMesh(int eventId, void* data);
+
+// --- Symmetry.cpp
+/**
+ * Enable symmetric editing across a plane orthogonal to an axis. The mirror of each vertex is found once
+ * in the rest positions V0, then SelectSphere also selects the mirrored sphere and TranslateSelection/TransformSelection
+ * move the mirrors of the selected vertices by the mirrored transformation, in the same pass.
+ * Edits are applied as given on the side of the last brush of SelectSphere or GetSelectionMaskSphere.
+ * Symmetry is disabled when a session is loaded, as V0 changes.
+ * @param axis Normal of the plane, 0, 1 or 2 for x, y or z, -1 to disable symmetry
+ * @param plane Position of the plane along the axis in local space
+ * @param tolerance Maximum distance of a mirrored vertex to the reflection, relative to the bounding box diagonal
+ * @return Number of vertices with a mirror, the others are edited without symmetry
+ */
+UNITY_INTERFACE_EXPORT int SetSymmetry(MeshState* state, int axis, float plane = 0.f, float tolerance = 1e-3f);
+
+// --- SelectionSets.cpp
+/**
+ * Add an empty selection set, for when more than the 32 selections in S are required.
+ * Selection sets store the selected vertices sparsely, so operations on them are proportional to their size.
+ * Use the id with SelectSphere or in a SelectionMask.
+ * @param name Name of the set, need not be unique
+ * @return Id of the selection set, at least 32
+ */
+UNITY_INTERFACE_EXPORT int AddSelectionSet(MeshState* state, const char* name);
+
+/**
+ * Remove a selection set, its id may be reused by AddSelectionSet.
+ */
+UNITY_INTERFACE_EXPORT void RemoveSelectionSet(MeshState* state, int id);
+
+/**
+ * @return Id of the first selection set with the name, or -1 if there is none
+ */
+UNITY_INTERFACE_EXPORT int FindSelectionSet(MeshState* state, const char* name);
+
+/**
+ * @return Number of vertices in any of the selections in the mask
+ */
+UNITY_INTERFACE_EXPORT unsigned int GetSelectionSize(MeshState* state, SelectionMask mask);
+
+/**
+ * Find the selection sets partially inside a sphere, the equivalent of GetSelectionMaskSphere.
+ * @param [out] setIds Array of size <code>capacity</code> for the ids of the sets
+ * @return Number of sets inside the sphere, may be larger than <code>capacity</code>
+ */
+UNITY_INTERFACE_EXPORT int
+GetSelectionSetsSphere(MeshState* state, Vector3 position, float radius, int* setIds, int capacity);
+
+/**
+ * @return The mean vertex of the selections in the mask
+ */
+UNITY_INTERFACE_EXPORT Vector3 GetSelectionSetsCenter(MeshState* state, SelectionMask mask);
+
+/**
+ * Deselect all vertices of the selections in the mask.
+ */
+UNITY_INTERFACE_EXPORT void ClearSelectionSets(MeshState* state, SelectionMask mask);
+
+/**
+ * Transform the vertices of the selections in the mask in place, see TransformSelection.
+ */
+UNITY_INTERFACE_EXPORT void TransformSelectionSets(MeshState* state, Vector3 translation, float scale,
+                                                   Quaternion rotation, Vector3 pivot, SelectionMask mask);
+
+/**
+ * Set the color of the vertices in the selection sets, using Color::GetColorById of the set id.
+ * Vertices colored by the previous call that are no longer in any of the sets are reset to gray,
+ * other vertices are not modified.
+ */
+UNITY_INTERFACE_EXPORT void SetColorBySelectionSets(MeshState* state, const int* setIds, int setCount);
+
+// --- Attributes.cpp
+/**
+ * Add a named channel of per vertex or per face values, e.g. weights, curvature or a second UV set.
+ * The values are stored row major as in the managed buffers and are zero initialized.
+ * Channels are not saved in sessions.
+ * @param type Value type, use AttributeType constants
+ * @param components Values per vertex or face
+ * @param domain Whether there is one row per vertex or per face, use AttributeDomain constants
+ * @return Id of the channel, the existing one if there is a channel with the name and layout, -1 if the layout differs
+ */
+UNITY_INTERFACE_EXPORT int AddAttribute(MeshState* state, const char* name, unsigned int type = AttributeType::Float,
+                                        int components = 1, unsigned int domain = AttributeDomain::Vertex);
+
+/**
+ * Remove a channel, its id may be reused by AddAttribute.
+ */
+UNITY_INTERFACE_EXPORT void RemoveAttribute(MeshState* state, int id);
+
+/**
+ * @return Id of the channel with the name, or -1 if there is none
+ */
+UNITY_INTERFACE_EXPORT int FindAttribute(MeshState* state, const char* name);
+
+/**
+ * Get the values of a channel, rows x components of its type, to read them without copying.
+ * @return Pointer valid until the channel is removed, nullptr if the id is invalid
+ */
+UNITY_INTERFACE_EXPORT void* GetAttributeData(MeshState* state, int id);
+
+/**
+ * Set a managed buffer of the same layout that ApplyDirty writes the modified rows of the channel to,
+ * together with the mesh data. The whole channel is copied to a new target once.
+ * Not supported with output frames, the target would be written by the worker thread whilst the main thread reads it.
+ * Read the channel with GetAttributeData and GetAttributeChanged instead.
+ * @param target Buffer of rows x components values, must stay valid until it is replaced, nullptr to remove it
+ * @return False if the id is invalid or output frames are enabled, see EnableOutputFrames
+ */
+UNITY_INTERFACE_EXPORT bool SetAttributeTarget(MeshState* state, int id, void* target);
+
+/**
+ * Set the rows [begin, end) of a channel and mark them as modified.
+ * @param values Array of (end - begin) x components values of the type of the channel
+ * @note The values are not recorded in a trace, the replay skips the calls of the mesh after this, see StartTrace
+ */
+UNITY_INTERFACE_EXPORT void SetAttribute(MeshState* state, int id, const void* values, int begin, int end);
+
+/**
+ * Get the rows of a channel that were modified before the last ApplyDirty.
+ * ApplyDirty sets DirtyFlag::AttributesDirty if any channel was modified.
+ * @param [out] begin, end The modified rows [begin, end)
+ * @return False if the channel was not modified
+ */
+UNITY_INTERFACE_EXPORT bool GetAttributeChanged(MeshState* state, int id, int& begin, int& end);
+
+
+// --- Storage.cpp
+/**
+ * Switch between the default float storage and the compact storage mode of the colors, UVs and selections.
+ * Compact mode stores RGBA8 colors, half precision UVs and the selections in 8, 16 or 32 bits per vertex,
+ * depending on SSize. They are only converted to floats in ApplyDirty.
+ * @see MeshStateNative::CompactStorage
+ */
+UNITY_INTERFACE_EXPORT void SetCompactStorage(MeshState* state, bool compact);
+
+/**
+ * @return Bytes used by the vertex and face attributes of the mesh, including V0
+ */
+UNITY_INTERFACE_EXPORT unsigned long long GetMeshMemoryUsage(MeshState* state);
+
+// --- Batch.cpp
+/**
+ * Execute a flat array of commands for several meshes with one call, to amortize the interop overhead.
+ * Commands of the same mesh are executed in order, different meshes are executed in parallel.
+ * @param commands Array of <code>count</code> commands, may be for any number of meshes
+ * @param [out] results Array of <code>count</code> results, one per command in the same order
+ */
+UNITY_INTERFACE_EXPORT void ExecuteBatch(const BatchCommand* commands, int count, BatchResult* results);
+
+
+// --- Scheduler.cpp
+/**
+ * Set the weight of the mesh when the worker threads are shared between the solvers of meshes deforming at the same
+ * time, e.g. Harmonic and Arap. A solver gets the share priority x VSize of the weights of all running solvers.
+ * Precomputations of meshes with a priority below 1 run on one thread at a lower OS thread priority.
+ * @param priority 1 for the mesh the user interacts with (default), lower for background meshes
+ */
+UNITY_INTERFACE_EXPORT void SetSolverPriority(MeshState* state, float priority);
+
+/**
+ * @return The threads used by the last solver or precomputation of the mesh, 0 if none ran yet
+ */
+UNITY_INTERFACE_EXPORT int GetSolverThreads(MeshState* state);
+
+
+// --- Trace.cpp
+/**
+ * Start recording all exported calls that operate on a mesh with their arguments and duration to a binary trace.
+ * A snapshot of each mesh is written when it is first used, so the trace can be replayed without Unity
+ * with the <code>libigl-replay</code> executable. Stops the current trace.
+ * @param path File to write the trace to, is overwritten
+ * @return True if the file could be opened
+ * @see Trace.h for the file format
+ * @note Selection sets are not part of the snapshot and the functions modifying them are not recorded,
+ * the replay skips the calls of a mesh after such a call
+ */
+UNITY_INTERFACE_EXPORT bool StartTrace(const char* path);
+
+/**
+ * Stop recording and close the trace file. Called automatically in UnityPluginUnload.
+ */
+UNITY_INTERFACE_EXPORT void StopTrace();
+
+// --- Upload.cpp
+/**
+ * @return The UploadMesh function pointer, pass this to C# <code>CommandBuffer.IssuePluginEventAndData</code>
+ */
+UNITY_INTERFACE_EXPORT UnityRenderingEventAndData GetUploadMeshPtr();
+
+/**
+ * Render thread callback that copies the vertices staged in ApplyDirty directly into the GPU vertex buffer.
+ * Only the vertex range modified since the last upload is copied, if the graphics API allows it.
+ * @param eventId Unused
+ * @param data The VertexUploadData* returned by EnableNativeUpload
+ */
+UNITY_INTERFACE_EXPORT void UNITY_INTERFACE_API UploadMesh(int eventId, void* data);
+
+/**
+ * Upload the vertex positions directly to the GPU vertex buffer instead of via the managed mesh.
+ * ApplyDirty then stages V for UploadMesh and sets DirtyFlag::VUploaded instead of writing to the VPtr.
+ * Must not be called while a worker thread is using the state.
+ * @param gfxVertexBufferPtr Native handle of the positions vertex buffer, from <code>Mesh.GetNativeVertexBufferPtr(0)</code>
+ * @return The data to pass to UploadMesh, or nullptr if no RenderAPI is available for the current graphics device
+ * @note The managed mesh vertices are not updated, so normals and bounds are not recalculated by Unity
+ */
+UNITY_INTERFACE_EXPORT VertexUploadData* EnableNativeUpload(MeshState* state, void* gfxVertexBufferPtr);
+
+/**
+ * Switch back to uploading the vertices via the managed mesh. Called automatically when the mesh is disposed.
+ */
+UNITY_INTERFACE_EXPORT void DisableNativeUpload(MeshState* state);
+
+
+// --- Frames.cpp
+/**
+ * Triple buffer the output of ApplyDirty, so the next frame can be computed whilst the previous one is uploaded.
+ * ApplyDirty then writes into a native frame and publishes it instead of writing to the Unity mesh data pointers.
+ * Take the latest frame on the main thread with AcquireOutputFrame.
+ * Must not be called while a worker thread is using the state.
+ * Removes the targets of the attribute channels, see SetAttributeTarget.
+ * @note Allocates three copies of the Unity mesh data
+ */
+UNITY_INTERFACE_EXPORT void EnableOutputFrames(MeshState* state);
+
+/**
+ * Switch back to writing the Unity mesh data in ApplyDirty. Called automatically when the mesh is disposed.
+ * Must not be called while a worker thread is using the state.
+ */
+UNITY_INTERFACE_EXPORT void DisableOutputFrames(MeshState* state);
+
+/**
+ * @param frame Index of the frame, in [0, 3)
+ * @return Pointers to the attributes of a frame, these are valid until DisableOutputFrames
+ */
+UNITY_INTERFACE_EXPORT UMeshDataNative GetOutputFrame(MeshState* state, int frame);
+
+/**
+ * Take the frame last published by ApplyDirty, the previously acquired frame is released.
+ * The frame may be read on the main thread until the next call, whilst ApplyDirty is running.
+ * @param dirtyState The DirtyState of the frame, including that of frames published but never acquired
+ * @return Index of the frame, or -1 if no frame has been published since the last call
+ */
+UNITY_INTERFACE_EXPORT int AcquireOutputFrame(MeshState* state, unsigned int& dirtyState);
+
+
+// --- Streaming.cpp
+/**
+ * Write the mesh as a streaming mesh that can be opened with OpenStreamingMesh, for meshes that are too large for
+ * the memory budget of the target device. The vertices are reordered into spatially coherent chunks.
+ * Only V, F and the 32 selections of S are saved.
+ * @param chunkVertices Number of vertices per chunk, the unit of paging
+ * @return True if the file has been written
+ */
+UNITY_INTERFACE_EXPORT bool SaveStreamingMesh(MeshState* state, const char* path, int chunkVertices = 65536);
+
+/**
+ * Open a streaming mesh written with SaveStreamingMesh, the file is memory-mapped and modified in place.
+ * No chunk is resident until UpdateStreaming is called.
+ * @param memoryBudget Bytes for the resident chunks, including their Unity mesh data
+ * @param VSize, FSize Size of the Unity mesh data to allocate for StreamingApplyDirty, this is fixed
+ * @return The streaming mesh, or nullptr if the file is invalid
+ */
+UNITY_INTERFACE_EXPORT StreamingMesh* OpenStreamingMesh(const char* path, unsigned long long memoryBudget,
+                                                        int& VSize, int& FSize);
+
+/**
+ * Write the modified resident chunks back to the file and close it
+ */
+UNITY_INTERFACE_EXPORT void CloseStreamingMesh(StreamingMesh* mesh);
+
+/**
+ * Page in the chunks intersecting the brush sphere, then those intersecting the view sphere, as many as fit into the
+ * memory budget. The least recently used chunks are evicted, modified ones are written back to the file.
+ * @return Number of chunks that have been loaded
+ */
+UNITY_INTERFACE_EXPORT int UpdateStreaming(StreamingMesh* mesh, Vector3 brush, float brushRadius, Vector3 view,
+                                           float viewRadius);
+
+/**
+ * Select the resident vertices inside a sphere, the equivalent of SelectSphere
+ */
+UNITY_INTERFACE_EXPORT void StreamingSelectSphere(StreamingMesh* mesh, Vector3 position, float radius,
+                                                  int selectionId = 0, unsigned int selectionMode = SelectionMode::Add);
+
+/**
+ * Translate the resident vertices of a selection, the equivalent of TranslateSelection.
+ * @note Selected vertices in chunks that are not resident are not moved, use UpdateStreaming with the selection
+ * inside the brush sphere.
+ */
+UNITY_INTERFACE_EXPORT void StreamingTranslateSelection(StreamingMesh* mesh, Vector3 translation, int selectionId);
+
+/**
+ * Write the modified resident chunks to the Unity mesh data, the equivalent of ApplyDirty.
+ * Each resident chunk has a fixed range of vertices and faces, faces to chunks that are not resident are degenerate.
+ * The colors show the visible selections. The normals are not written.
+ * @param data Unity mesh data with the size returned by OpenStreamingMesh
+ * @return The DirtyFlag of the attributes that have been written
+ */
+UNITY_INTERFACE_EXPORT unsigned int StreamingApplyDirty(StreamingMesh* mesh, const UMeshDataNative data,
+                                                        unsigned int visibleSelectionMask);
 
 } // extern "C"
\ No newline at end of file
@@ -0,0 +1,102 @@
+#include "Reorder.h"
+#include "Native.h"
+#include "Util.h"
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * Spread the lower 21 bits of x so there are two zero bits between each bit
+ */
+static uint64_t SplitBy3(uint64_t x)
+{
+	x &= 0x1fffff;
+	x = (x | x << 32) & 0x1f00000000ffffull;
+	x = (x | x << 16) & 0x1f0000ff0000ffull;
+	x = (x | x << 8) & 0x100f00f00f00f00full;
+	x = (x | x << 4) & 0x10c30c30c30c30c3ull;
+	x = (x | x << 2) & 0x1249249249249249ull;
+	return x;
+}
+
+/**
+ * Reorder the rows of M, row i becomes the row order(i)
+ */
+template<typename Matrix>
+static void GatherRows(Matrix& M, const Eigen::VectorXi& order)
+{
+	Matrix result(M.rows(), M.cols());
+#pragma omp parallel for num_threads(GetWorkerThreads())
+	for (int i = 0; i < order.size(); ++i)
+		result.row(i) = M.row(order(i));
+	M.swap(result);
+}
+
+void ReorderMesh(MeshState* state)
+{
+	auto* native = state->Native;
+	const auto& V = *state->V;
+	auto& F = *state->F;
+
+	// Quantize the positions to 21 bits per axis in the bounding box and interleave them
+	const Eigen::RowVector3f min = V.colwise().minCoeff();
+	const Eigen::RowVector3f extent = V.colwise().maxCoeff() - min;
+	const Eigen::RowVector3f scale = (float) 0x1fffff * extent.cwiseMax(1e-12f).cwiseInverse();
+
+	std::vector<std::pair<uint64_t, int>> codes(state->VSize);
+#pragma omp parallel for num_threads(GetWorkerThreads())
+	for (int i = 0; i < state->VSize; ++i)
+	{
+		const Eigen::RowVector3f q = (V.row(i) - min).cwiseProduct(scale);
+		codes[i] = std::make_pair(SplitBy3((uint64_t) q(0)) | SplitBy3((uint64_t) q(1)) << 1 |
+		                          SplitBy3((uint64_t) q(2)) << 2, i);
+	}
+	std::sort(codes.begin(), codes.end());
+
+	auto& vertexOrder = native->VertexOrder;
+	vertexOrder.resize(state->VSize);
+	Eigen::VectorXi newIndex(state->VSize);
+	for (int i = 0; i < state->VSize; ++i)
+	{
+		vertexOrder(i) = codes[i].second;
+		newIndex(codes[i].second) = i;
+	}
+
+	GatherRows(*state->V, vertexOrder);
+	GatherRows(*state->N, vertexOrder);
+	GatherRows(*state->UV, vertexOrder);
+	*native->V0 = *state->V;
+
+	// Counting sort of the faces by their smallest new vertex index, stable so the order within a vertex is kept
+	for (int f = 0; f < state->FSize; ++f)
+		for (int k = 0; k < 3; ++k)
+			F(f, k) = newIndex(F(f, k));
+
+	std::vector<int> offsets(state->VSize + 1, 0);
+	for (int f = 0; f < state->FSize; ++f)
+		++offsets[F.row(f).minCoeff() + 1];
+	for (int i = 0; i < state->VSize; ++i)
+		offsets[i + 1] += offsets[i];
+
+	auto& faceOrder = native->FaceOrder;
+	faceOrder.resize(state->FSize);
+	for (int f = 0; f < state->FSize; ++f)
+		faceOrder(offsets[F.row(f).minCoeff()]++) = f;
+	GatherRows(F, faceOrder);
+}
+
+// --- Exports
+bool GetMeshOrder(MeshState* state, int* vertexOrder, int* faceOrder)
+{
+	state->EnsureInitialized();
+	const auto* native = state->Native;
+	if (native->VertexOrder.size() == 0)
+		return false;
+
+	if (vertexOrder != nullptr)
+		std::copy(native->VertexOrder.data(), native->VertexOrder.data() + state->VSize, vertexOrder);
+	if (faceOrder != nullptr)
+		std::copy(native->FaceOrder.data(), native->FaceOrder.data() + state->FSize, faceOrder);
+	return true;
+}
@@ -0,0 +1,100 @@
+#include "Native.h"
+#include "Scheduler.h"
+#include "Util.h"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+thread_local int s_SolverThreads = 0;
+
+/** Guards s_RunningWeight */
+static std::mutex s_SchedulerMutex;
+/** Sum of the weights of the running solvers */
+static float s_RunningWeight = 0.f;
+
+/**
+ * Lower or restore the OS priority of the calling thread, the precomputation then only runs when cores are idle
+ */
+static void LowerThreadPriority(bool lower)
+{
+#if defined(_WIN32)
+	SetThreadPriority(GetCurrentThread(), lower ? THREAD_PRIORITY_BELOW_NORMAL : THREAD_PRIORITY_NORMAL);
+#elif defined(__linux__)
+	// Unprivileged threads cannot lower their nice value again, but may switch between these policies
+	sched_param param{};
+	pthread_setschedparam(pthread_self(), lower ? SCHED_BATCH : SCHED_OTHER, &param);
+#endif
+}
+
+// --- SolverScope
+SolverScope::SolverScope(MeshState* state, bool precompute) : PreviousThreads(s_SolverThreads)
+{
+	const float priority = state->Native->SolverPriority.load(std::memory_order_relaxed);
+	Weight = std::max(priority, 1e-3f) * std::max(state->VSize, 1);
+
+	const int total = Eigen::nbThreads();
+	{
+		std::lock_guard<std::mutex> lock(s_SchedulerMutex);
+		Threads = std::max(1, (int) std::lround(total * Weight / (s_RunningWeight + Weight)));
+		s_RunningWeight += Weight;
+	}
+
+	if (precompute && priority < 1.f)
+	{
+		Threads = 1;
+		LoweredPriority = true;
+		LowerThreadPriority(true);
+	}
+
+	s_SolverThreads = Threads;
+	state->Native->SolverThreads = Threads;
+#ifdef _OPENMP
+	// Also applies to the OpenMP loops of libigl called on this thread
+	PreviousOmpThreads = omp_get_max_threads();
+	omp_set_num_threads(Threads);
+#else
+	PreviousOmpThreads = 1;
+#endif
+}
+
+SolverScope::~SolverScope()
+{
+	{
+		std::lock_guard<std::mutex> lock(s_SchedulerMutex);
+		s_RunningWeight = std::max(0.f, s_RunningWeight - Weight);
+	}
+
+	s_SolverThreads = PreviousThreads;
+#ifdef _OPENMP
+	omp_set_num_threads(PreviousOmpThreads);
+#endif
+	if (LoweredPriority)
+		LowerThreadPriority(false);
+}
+
+// --- Exports
+void SetSolverPriority(MeshState* state, float priority)
+{
+	state->Native->SolverPriority.store(std::max(0.f, priority), std::memory_order_relaxed);
+}
+
+int GetSolverThreads(MeshState* state)
+{
+	return state->Native->SolverThreads;
+}
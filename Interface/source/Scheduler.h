@@ -0,0 +1,35 @@
+#pragma once
+#include "MeshState.h"
+
+/**
+ * Shares the worker threads between the solvers of meshes running at the same time on different threads.
+ * Construct it around a solve, GetWorkerThreads then returns the budget of the mesh on this thread.<p/>
+ * The budget is the share of the worker threads by the weight priority x VSize among the running solvers,
+ * so the mesh the user interacts with gets most threads, see SetSolverPriority.
+ * The budget is fixed when the scope is created, solvers that are already running keep theirs.
+ * Precomputations of background meshes (priority below 1) run on a single thread at a lower OS thread priority.
+ */
+class SolverScope
+{
+public:
+	/**
+	 * @param precompute Whether this is a precomputation, e.g. the Arap factorization
+	 */
+	explicit SolverScope(MeshState* state, bool precompute = false);
+
+	~SolverScope();
+
+	SolverScope(const SolverScope&) = delete;
+	SolverScope& operator=(const SolverScope&) = delete;
+
+	/** Threads of this solver */
+	int Threads;
+
+private:
+	float Weight;
+	/** Budget of an enclosing scope on this thread, 0 if there is none */
+	int PreviousThreads;
+	/** OpenMP threads of this thread before the scope */
+	int PreviousOmpThreads;
+	bool LoweredPriority{false};
+};
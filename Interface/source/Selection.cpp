@@ -1,116 +1,189 @@
 #include "Native.h"
 #include "Util.h"
+#include "Storage.h"
+#include "Trace.h"
+#include "SelectionSets.h"
+#include "SelectionKernels.h"
+#include "Symmetry.h"
+#include <array>
 
 void SelectSphere(MeshState* state, Vector3 position, float radius, int selectionId, unsigned int selectionMode)
 {
-	const Eigen::RowVector3f posEigen = position.AsEigenRow();
-	const unsigned int maskId = 1 << selectionId;
-	const float radiusSqr = radius * radius;
-
-	using BinaryExpr = const std::function<int(int, int)>;
-	BinaryExpr AddSelection = [&](int a, int s) -> int { return a << selectionId | s; };
-	BinaryExpr SubtractSelection = [&](int a, int s) -> int { return ~(a << selectionId) & s; };
-	BinaryExpr ToggleSelection = [&](int a, int s) -> int { return a << selectionId ^ s; };
-
-	BinaryExpr* Apply;
-	if (selectionMode == SelectionMode::Add)
-		Apply = &AddSelection;
-	else if (selectionMode == SelectionMode::Subtract)
-		Apply = &SubtractSelection;
-	else if (selectionMode == SelectionMode::Toggle)
-		Apply = &ToggleSelection;
+	TraceScope trace(state, BatchOp::SelectSphere, [&](BatchCommand& cmd) {
+		cmd.Position = position;
+		cmd.Radius = radius;
+		cmd.SelectionId = selectionId;
+		cmd.SelectionMode = selectionMode;
+	});
+	state->EnsureInitialized();
+
+	SetSymmetrySide(state, position);
+
+	auto select = [&](const auto& primitive) {
+		if (selectionId >= SelectionSetStore::FirstId)
+		{
+			if (GetSelectionSet(state, selectionId) == nullptr)
+			{
+				LOGERR("Invalid selection set: " << selectionId)
+				return;
+			}
+
+			const auto& V = *state->V;
+			std::vector<int> inside;
+			for (int i = 0; i < state->VSize; ++i)
+				if (primitive.Contains(V(i, 0), V(i, 1), V(i, 2)))
+					inside.push_back(i);
+			ModifySelectionSet(state, selectionId, inside, selectionMode);
+			return;
+		}
+
+		EnsureSWidth(state, selectionId + 1);
+		if (!SelectInside(state, primitive, selectionId, selectionMode))
+		{
+			LOGERR("Invalid selection mode: " << selectionMode);
+			return;
+		}
+
+		// LOG("Selected: " << state->SSize[selectionId] << " vertices, total selected: " << state->SSizeAll);
+
+		state->DirtySelections |= 1u << selectionId;
+	};
+
+	const SpherePrimitive sphere(position, radius);
+	if (state->Native->SymmetryAxis < 0)
+		select(sphere);
 	else
 	{
-		LOGERR("Invalid selection mode: " << selectionMode);
-		return;
+		// Select the mirrored sphere in the same pass
+		const Vector3 mirrored(GetMirrorTransform(state) * position.AsEigen());
+		select(UnionPrimitive<SpherePrimitive, SpherePrimitive>(sphere, SpherePrimitive(mirrored, radius)));
 	}
-
-	*state->S = ((state->V->rowwise() - posEigen).array().square().matrix().rowwise().sum().array() < radiusSqr)
-			.cast<int>().matrix() // to VectorXi
-					// element = 0 or 1, if it is inside the sphere or not
-			.binaryExpr(*state->S, *Apply);
-
-	// LOG("Selected: " << state->SSize[selectionId] << " vertices, total selected: " << state->SSizeAll);
-
-	state->DirtySelections |= maskId;
 }
 
 unsigned int GetSelectionMaskSphere(MeshState* state, Vector3 position, float radius)
 {
-	const Eigen::RowVector3f posEigen = position.AsEigenRow();
-	const float radiusSqr = radius * radius;
-	unsigned int mask = 0;
+	TraceScope trace(state, BatchOp::GetSelectionMaskSphere, [&](BatchCommand& cmd) {
+		cmd.Position = position;
+		cmd.Radius = radius;
+	});
+	state->EnsureInitialized();
+	SetSymmetrySide(state, position);
 
-	mask = ((state->V->rowwise() - posEigen).array().square().matrix().rowwise().sum().array() < radiusSqr)
-			 .cast<int>().matrix() // to VectorXi
-			 .cwiseProduct(*state->S)
-			// element = 0 or its mask if it is inside the sphere or not
-			// We use a reduction to aggregate the mask
-			// Sidenote: The lambda defines how to aggregate two integers and must be associative
-			.redux([](const int a, const int b) -> int {
-				auto c = a | b;
-				return c;
-			});
+	unsigned int mask = 0;
+	VisitS(state, [&](const auto& S) { mask = GetMaskInside(*state->V, SpherePrimitive(position, radius), S); });
 
 	return mask;
 }
 
 Vector3 GetSelectionCenter(MeshState* state, unsigned int maskId)
 {
+	TraceScope trace(state, BatchOp::GetSelectionCenter, [&](BatchCommand& cmd) {
+		cmd.MaskId = maskId;
+	});
+	state->EnsureInitialized();
+
 	using namespace Eigen;
 	VectorXi rowMask;
 	MatrixXf VSlice;
 	igl::colon<int>(0, state->VSize, rowMask);
-	rowMask.conservativeResize(
-			std::stable_partition(rowMask.data(), rowMask.data() + state->VSize,
-			                      [&](int i) -> bool { return (*state->S)(i) & maskId; })
-			- rowMask.data());
+	VisitS(state, [&](const auto& S) {
+		rowMask.conservativeResize(
+				std::stable_partition(rowMask.data(), rowMask.data() + state->VSize,
+				                      [&](int i) -> bool { return S(i) & maskId; })
+				- rowMask.data());
+	});
 
 	if(rowMask.rows() == 0)
-		return Vector3::Zero();
+		return ::Vector3::Zero();
 
 	igl::slice(*state->V, rowMask, igl::colon<int>(0, 2), VSlice);
 
 	Vector3f center = VSlice.colwise().mean();
-	return (Vector3)center;
+	return (::Vector3)center;
 }
 
 void ClearSelectionMask(MeshState* state, unsigned int maskId)
 {
-	*state->S = state->S->unaryExpr([&](int s) -> int { return ~maskId & s; });
+	TraceScope trace(state, BatchOp::ClearSelectionMask, [&](BatchCommand& cmd) {
+		cmd.MaskId = maskId;
+	});
+	state->EnsureInitialized();
+
+	VisitS(state, [&](auto& S) {
+		using Scalar = typename std::decay<decltype(S)>::type::Scalar;
+		S = S.unaryExpr([&](Scalar s) -> Scalar { return ~maskId & s; });
+	});
 	state->DirtySelections |= maskId;
 }
 
-void SetColorSingleByMask(MeshState* state, unsigned int maskId, int colorId)
+/**
+ * Set the color of every vertex based on its selections, writes to C or C8 depending on the storage mode.
+ * @param colorOf Function returning the Color_t for the selection bitmask of a vertex
+ */
+template<typename ColorFn>
+static void SetColorBySelection(MeshState* state, ColorFn colorOf)
 {
-	const auto& color = Color::GetColorById(colorId);
-
-	const auto mask = state->S->unaryExpr([&](int a) -> int { return (a & maskId) > 0; }).cast<float>().eval();
-	*state->C = mask * color + (1.f - mask.array()).matrix() * Color::Gray;
-
+	VisitS(state, [&](const auto& S) {
+		if (state->Native->CompactStorage)
+		{
+			auto& C8 = state->Native->C8;
+#pragma omp parallel for num_threads(GetWorkerThreads())
+			for (int i = 0; i < state->VSize; ++i)
+				C8.row(i) = ToRGBA8(colorOf(S(i)));
+		}
+		else
+		{
+			auto& C = *state->C;
+#pragma omp parallel for num_threads(GetWorkerThreads())
+			for (int i = 0; i < state->VSize; ++i)
+				C.row(i) = colorOf(S(i));
+		}
+	});
+
+	// The saved colors of the intersecting vertices and the colors of the selection sets are outdated
+	if (state->Native->SelfIntersection != nullptr)
+		state->Native->SelfIntersection->ResetColors();
+	state->Native->SelectionSets.ColoredVertices.clear();
 	state->DirtyState |= DirtyFlag::CDirty;
 }
 
-void SetColorByMask(MeshState* state, unsigned int maskId)
+void SetColorSingleByMask(MeshState* state, unsigned int maskId, int colorId)
 {
-	state->C->setZero();
-
-	for (unsigned int selectionId = 0; selectionId < state->SSize; ++selectionId)
-	{
-		const unsigned int m = 1u << selectionId;
-		if ((m & maskId) == 0) // Skip selections that are not visible
-			continue;
-
-		// Normalize color by the maskId so we can multiply the mask by the color
-		const Eigen::MatrixXf mask = state->S->unaryExpr([&](int a) -> int { return a & m; }).cast<float>();
+	TraceScope trace(state, BatchOp::SetColorSingleByMask, [&](BatchCommand& cmd) {
+		cmd.MaskId = maskId;
+		cmd.SelectionId = colorId;
+	});
+	state->EnsureInitialized();
 
-		const Color_t color = Color::GetColorById(selectionId).array() / (float) m;
-		*state->C += mask * color;
-	}
+	const auto& color = Color::GetColorById(colorId);
 
-	// Deselected Color
-	const Eigen::MatrixXf deselectedMask = state->S->unaryExpr([&](int a) -> int { return (a & maskId) == 0; }).cast<float>();
-	*state->C += deselectedMask * Color::Gray;
+	SetColorBySelection(state, [&](unsigned int s) -> const Color_t& {
+		return (s & maskId) > 0 ? color : Color::Gray;
+	});
+}
 
-	state->DirtyState |= DirtyFlag::CDirty;
+void SetColorByMask(MeshState* state, unsigned int maskId)
+{
+	TraceScope trace(state, BatchOp::SetColorByMask, [&](BatchCommand& cmd) {
+		cmd.MaskId = maskId;
+	});
+	state->EnsureInitialized();
+
+	// Only selections that are in use can be shown
+	const unsigned int visibleMask = state->SSize >= 32 ? maskId : maskId & ((1u << state->SSize) - 1);
+	std::array<Color_t, 32> colors;
+	for (unsigned int selectionId = 0; selectionId < colors.size(); ++selectionId)
+		colors[selectionId] = Color::GetColorById(selectionId);
+
+	// A vertex has the sum of the colors of its visible selections, or the deselected color
+	SetColorBySelection(state, [&](unsigned int s) -> Color_t {
+		if ((s & maskId) == 0)
+			return Color::Gray;
+
+		Color_t color = Color_t::Zero();
+		for (unsigned int selectionId = 0, m = s & visibleMask; m > 0; ++selectionId, m >>= 1)
+			if ((m & 1u) > 0)
+				color += colors[selectionId];
+		return color;
+	});
 }
@@ -0,0 +1,165 @@
+#pragma once
+#include "Storage.h"
+
+// --- Primitives
+/**
+ * A sphere for the selection kernels. A primitive has <code>bool Contains(float x, float y, float z) const</code>
+ * which must be cheap and branchless, so the kernels are vectorized.
+ */
+struct SpherePrimitive
+{
+	float X, Y, Z;
+	float RadiusSqr;
+
+	SpherePrimitive(const Vector3& center, float radius)
+			: X(center.x), Y(center.y), Z(center.z), RadiusSqr(radius * radius)
+	{}
+
+	bool Contains(float x, float y, float z) const
+	{
+		const float dx = x - X, dy = y - Y, dz = z - Z;
+		return dx * dx + dy * dy + dz * dz < RadiusSqr;
+	}
+
+	/**
+	 * @return True if the sphere may contain points of the axis aligned box, used to skip whole chunks
+	 */
+	bool IntersectsBox(const float* min, const float* max) const
+	{
+		const float dx = std::max(std::max(min[0] - X, X - max[0]), 0.f);
+		const float dy = std::max(std::max(min[1] - Y, Y - max[1]), 0.f);
+		const float dz = std::max(std::max(min[2] - Z, Z - max[2]), 0.f);
+		return dx * dx + dy * dy + dz * dz < RadiusSqr;
+	}
+};
+
+/**
+ * Union of two primitives, e.g. a sphere and its mirror image, so both are selected in one pass
+ */
+template<typename A, typename B>
+struct UnionPrimitive
+{
+	A First;
+	B Second;
+
+	UnionPrimitive(const A& first, const B& second) : First(first), Second(second)
+	{}
+
+	bool Contains(float x, float y, float z) const
+	{ return First.Contains(x, y, z) | Second.Contains(x, y, z); }
+};
+
+// --- Kernels
+/**
+ * Modify the selection bits of one vertex for a SelectionMode
+ * @param inside The bit of the selection if the vertex is inside the primitive, otherwise 0
+ */
+template<unsigned int Mode>
+struct SelectionOp;
+
+template<>
+struct SelectionOp<SelectionMode::Add>
+{
+	template<typename Scalar>
+	static Scalar Apply(Scalar s, Scalar inside)
+	{ return static_cast<Scalar>(s | inside); }
+};
+
+template<>
+struct SelectionOp<SelectionMode::Subtract>
+{
+	template<typename Scalar>
+	static Scalar Apply(Scalar s, Scalar inside)
+	{ return s & static_cast<Scalar>(~inside); }
+};
+
+template<>
+struct SelectionOp<SelectionMode::Toggle>
+{
+	template<typename Scalar>
+	static Scalar Apply(Scalar s, Scalar inside)
+	{ return static_cast<Scalar>(s ^ inside); }
+};
+
+/**
+ * Select the vertices inside the primitive, compiled for each mode, primitive and selection width.
+ * Reads the columns of V directly so the loop is vectorized.
+ * @param S The selection vector, see VisitS
+ */
+template<unsigned int Mode, typename Primitive, typename SVector>
+void SelectInside(const Eigen::MatrixXf& V, const Primitive& primitive, int selectionId, SVector& S)
+{
+	using Scalar = typename SVector::Scalar;
+	const Scalar bit = static_cast<Scalar>(1u << selectionId);
+	const float* X = V.col(0).data();
+	const float* Y = V.col(1).data();
+	const float* Z = V.col(2).data();
+	Scalar* s = S.data();
+	const int VSize = V.rows();
+
+#pragma omp parallel for num_threads(GetWorkerThreads()) schedule(static)
+	for (int i = 0; i < VSize; ++i)
+	{
+		const auto inside = static_cast<Scalar>(-static_cast<int>(primitive.Contains(X[i], Y[i], Z[i])) & bit);
+		s[i] = SelectionOp<Mode>::Apply(s[i], inside);
+	}
+}
+
+/**
+ * @return The union of the selections of the vertices inside the primitive
+ */
+template<typename Primitive, typename SVector>
+unsigned int GetMaskInside(const Eigen::MatrixXf& V, const Primitive& primitive, const SVector& S)
+{
+	const float* X = V.col(0).data();
+	const float* Y = V.col(1).data();
+	const float* Z = V.col(2).data();
+	const auto* s = S.data();
+	const int VSize = V.rows();
+
+	unsigned int mask = 0;
+#pragma omp parallel for num_threads(GetWorkerThreads()) schedule(static) reduction(|:mask)
+	for (int i = 0; i < VSize; ++i)
+		mask |= static_cast<unsigned int>(s[i]) & -static_cast<unsigned int>(primitive.Contains(X[i], Y[i], Z[i]));
+	return mask;
+}
+
+/**
+ * Select the vertices inside the primitive, dispatches once to the kernel of the mode.
+ * @param S The selection vector, of any width
+ * @return False if the mode is invalid
+ */
+template<typename Primitive, typename SVector>
+bool SelectInside(const Eigen::MatrixXf& V, const Primitive& primitive, int selectionId, unsigned int selectionMode,
+                  SVector& S)
+{
+	switch (selectionMode)
+	{
+		case SelectionMode::Add:
+			SelectInside<SelectionMode::Add>(V, primitive, selectionId, S);
+			return true;
+		case SelectionMode::Subtract:
+			SelectInside<SelectionMode::Subtract>(V, primitive, selectionId, S);
+			return true;
+		case SelectionMode::Toggle:
+			SelectInside<SelectionMode::Toggle>(V, primitive, selectionId, S);
+			return true;
+		default:
+			return false;
+	}
+}
+
+/**
+ * Select the vertices inside the primitive in S, dispatches once to the kernel of the mode and selection width.
+ * The selection must be one of the 32 in S.
+ * @return False if the mode is invalid
+ */
+template<typename Primitive>
+bool SelectInside(MeshState* state, const Primitive& primitive, int selectionId, unsigned int selectionMode)
+{
+	bool valid = true;
+	VisitS(state, [&](auto& S) {
+		valid = SelectInside(*state->V, primitive, selectionId, selectionMode, S);
+	});
+	return valid;
+}
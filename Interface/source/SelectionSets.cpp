@@ -0,0 +1,320 @@
+#include "Native.h"
+#include "SelectionSets.h"
+#include "Storage.h"
+#include "Trace.h"
+#include <algorithm>
+#include <iterator>
+
+SelectionSet* GetSelectionSet(MeshState* state, int id)
+{
+	auto& sets = state->Native->SelectionSets.Sets;
+	const int index = id - SelectionSetStore::FirstId;
+	if (index < 0 || index >= (int) sets.size() || !sets[index].IsUsed)
+		return nullptr;
+	return &sets[index];
+}
+
+/**
+ * Recalculate the summary bit of the selection set <code>id</code> for vertices that have been removed from it.
+ * The bit is shared with every 64th set, so it stays set if the vertex is in one of those.
+ */
+static void RefreshSummary(SelectionSetStore& store, const std::vector<int>& removed, int id)
+{
+	const uint64_t bit = SelectionSetStore::SummaryBit(id);
+	for (const int i : removed)
+	{
+		bool isInOther = false;
+		for (int other = (id - SelectionSetStore::FirstId) % 64; other < (int) store.Sets.size() && !isInOther; other += 64)
+		{
+			const auto& set = store.Sets[other];
+			isInOther = set.IsUsed && std::binary_search(set.Indices.begin(), set.Indices.end(), i);
+		}
+
+		if (!isInOther)
+			store.Summary[i] &= ~bit;
+	}
+}
+
+void ModifySelectionSet(MeshState* state, int id, const std::vector<int>& indices, unsigned int selectionMode)
+{
+	auto& store = state->Native->SelectionSets;
+	SelectionSet* set = GetSelectionSet(state, id);
+
+	std::vector<int> result;
+	result.reserve(set->Indices.size() + indices.size());
+	if (selectionMode == SelectionMode::Add)
+		std::set_union(set->Indices.begin(), set->Indices.end(), indices.begin(), indices.end(),
+		               std::back_inserter(result));
+	else if (selectionMode == SelectionMode::Subtract)
+		std::set_difference(set->Indices.begin(), set->Indices.end(), indices.begin(), indices.end(),
+		                    std::back_inserter(result));
+	else if (selectionMode == SelectionMode::Toggle)
+		std::set_symmetric_difference(set->Indices.begin(), set->Indices.end(), indices.begin(), indices.end(),
+		                              std::back_inserter(result));
+	else
+	{
+		LOGERR("Invalid selection mode: " << selectionMode);
+		return;
+	}
+
+	// Update the summary of the added and removed vertices only
+	const uint64_t bit = SelectionSetStore::SummaryBit(id);
+	std::vector<int> removed;
+	std::set_difference(set->Indices.begin(), set->Indices.end(), result.begin(), result.end(),
+	                    std::back_inserter(removed));
+	for (const int i : indices)
+		if (selectionMode != SelectionMode::Subtract)
+			store.Summary[i] |= bit;
+
+	set->Indices.swap(result);
+	set->DirtyForBoundary = true;
+	RefreshSummary(store, removed, id);
+}
+
+void GatherSelected(MeshState* state, const SelectionMask& mask, std::vector<int>& indices)
+{
+	indices.clear();
+	if (mask.Mask > 0)
+	{
+		VisitS(state, [&](const auto& S) {
+			for (int i = 0; i < state->VSize; ++i)
+				if ((S(i) & mask.Mask) > 0)
+					indices.push_back(i);
+		});
+	}
+
+	int setsGathered = 0;
+	for (int k = 0; k < mask.SetCount; ++k)
+	{
+		const SelectionSet* set = GetSelectionSet(state, mask.SetIds[k]);
+		if (set == nullptr)
+		{
+			LOGWARN("Invalid selection set: " << mask.SetIds[k])
+			continue;
+		}
+
+		indices.insert(indices.end(), set->Indices.begin(), set->Indices.end());
+		setsGathered++;
+	}
+
+	// Each source is sorted, only merge if there is more than one
+	if (setsGathered + (mask.Mask > 0) > 1)
+	{
+		std::sort(indices.begin(), indices.end());
+		indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+	}
+}
+
+// --- Exports
+int AddSelectionSet(MeshState* state, const char* name)
+{
+	TraceScope trace(state, "AddSelectionSet");
+	state->EnsureInitialized();
+
+	auto& store = state->Native->SelectionSets;
+	if (store.Summary.empty())
+		store.Summary.resize(state->VSize, 0);
+
+	// Reuse the id of a removed set
+	auto it = std::find_if(store.Sets.begin(), store.Sets.end(), [](const SelectionSet& set) { return !set.IsUsed; });
+	if (it == store.Sets.end())
+		it = store.Sets.emplace(store.Sets.end());
+
+	it->Name = name;
+	it->Indices.clear();
+	it->IsUsed = true;
+	it->DirtyForBoundary = true;
+	return SelectionSetStore::FirstId + (int) (it - store.Sets.begin());
+}
+
+void RemoveSelectionSet(MeshState* state, int id)
+{
+	TraceScope trace(state, "RemoveSelectionSet");
+	state->EnsureInitialized();
+
+	SelectionSet* set = GetSelectionSet(state, id);
+	if (set == nullptr)
+		return;
+
+	std::vector<int> removed;
+	removed.swap(set->Indices);
+	set->IsUsed = false;
+	set->Name.clear();
+	RefreshSummary(state->Native->SelectionSets, removed, id);
+}
+
+int FindSelectionSet(MeshState* state, const char* name)
+{
+	state->EnsureInitialized();
+
+	const auto& sets = state->Native->SelectionSets.Sets;
+	for (int i = 0; i < (int) sets.size(); ++i)
+		if (sets[i].IsUsed && sets[i].Name == name)
+			return SelectionSetStore::FirstId + i;
+	return -1;
+}
+
+unsigned int GetSelectionSize(MeshState* state, SelectionMask mask)
+{
+	state->EnsureInitialized();
+
+	if (mask.Mask == 0 && mask.SetCount == 1)
+	{
+		const SelectionSet* set = GetSelectionSet(state, mask.SetIds[0]);
+		return set ? set->Indices.size() : 0;
+	}
+
+	std::vector<int> indices;
+	GatherSelected(state, mask, indices);
+	return indices.size();
+}
+
+int GetSelectionSetsSphere(MeshState* state, Vector3 position, float radius, int* setIds, int capacity)
+{
+	state->EnsureInitialized();
+
+	const auto& store = state->Native->SelectionSets;
+	if (store.Summary.empty())
+		return 0;
+
+	// Candidate sets from the summary of the vertices inside the sphere
+	const Eigen::RowVector3f posEigen = position.AsEigenRow();
+	const float radiusSqr = radius * radius;
+	const auto& V = *state->V;
+	uint64_t candidates = 0;
+	for (int i = 0; i < state->VSize; ++i)
+		if (store.Summary[i] != 0 && (V.row(i) - posEigen).squaredNorm() < radiusSqr)
+			candidates |= store.Summary[i];
+
+	// Check each candidate set, only its selected vertices
+	int count = 0;
+	for (int k = 0; k < (int) store.Sets.size() && candidates != 0; ++k)
+	{
+		const auto& set = store.Sets[k];
+		const int id = SelectionSetStore::FirstId + k;
+		if (!set.IsUsed || (candidates & SelectionSetStore::SummaryBit(id)) == 0)
+			continue;
+
+		const bool isInside = std::any_of(set.Indices.begin(), set.Indices.end(), [&](int i) -> bool {
+			return (V.row(i) - posEigen).squaredNorm() < radiusSqr;
+		});
+		if (!isInside)
+			continue;
+
+		if (count < capacity)
+			setIds[count] = id;
+		count++;
+	}
+	return count;
+}
+
+Vector3 GetSelectionSetsCenter(MeshState* state, SelectionMask mask)
+{
+	state->EnsureInitialized();
+
+	std::vector<int> indices;
+	GatherSelected(state, mask, indices);
+	if (indices.empty())
+		return Vector3::Zero();
+
+	Eigen::RowVector3f sum = Eigen::RowVector3f::Zero();
+	for (const int i : indices)
+		sum += state->V->row(i);
+	return Vector3(Eigen::Vector3f(sum / indices.size()));
+}
+
+void ClearSelectionSets(MeshState* state, SelectionMask mask)
+{
+	TraceScope trace(state, "ClearSelectionSets");
+	state->EnsureInitialized();
+
+	if (mask.Mask > 0)
+		ClearSelectionMask(state, mask.Mask);
+
+	for (int k = 0; k < mask.SetCount; ++k)
+	{
+		SelectionSet* set = GetSelectionSet(state, mask.SetIds[k]);
+		if (set == nullptr)
+			continue;
+
+		std::vector<int> removed;
+		removed.swap(set->Indices);
+		set->DirtyForBoundary = true;
+		RefreshSummary(state->Native->SelectionSets, removed, mask.SetIds[k]);
+	}
+}
+
+void TransformSelectionSets(MeshState* state, Vector3 translation, float scale, Quaternion rotation, Vector3 pivot,
+                            SelectionMask mask)
+{
+	TraceScope trace(state, "TransformSelectionSets");
+	state->EnsureInitialized();
+
+	using namespace Eigen;
+	Transform<float, 3, Affine> transform =
+			Translation3f(translation.AsEigen()) *
+			Translation3f(pivot.AsEigen()) * Scaling(scale) * rotation.AsEigen() * Translation3f(-pivot.AsEigen());
+
+	std::vector<int> indices;
+	GatherSelected(state, mask, indices);
+	if (indices.empty())
+		return;
+
+	auto& V = *state->V;
+	for (const int i : indices)
+	{
+		Vector3f v = V.row(i);
+		V.row(i) = transform * v;
+	}
+
+	state->DirtyState |= DirtyFlag::VDirty;
+	state->Native->ExtendDirtyV(indices.front(), indices.back() + 1);
+}
+
+void SetColorBySelectionSets(MeshState* state, const int* setIds, int setCount)
+{
+	TraceScope trace(state, "SetColorBySelectionSets");
+	state->EnsureInitialized();
+	auto* native = state->Native;
+
+	auto setColor = [&](const std::vector<int>& indices, const Color_t& color) {
+		if (native->CompactStorage)
+		{
+			const auto color8 = ToRGBA8(color);
+			for (const int i : indices)
+				native->C8.row(i) = color8;
+		}
+		else
+		{
+			for (const int i : indices)
+				state->C->row(i) = color;
+		}
+	};
+
+	std::vector<int> colored;
+	for (int k = 0; k < setCount; ++k)
+	{
+		const SelectionSet* set = GetSelectionSet(state, setIds[k]);
+		if (set != nullptr)
+			colored.insert(colored.end(), set->Indices.begin(), set->Indices.end());
+	}
+	std::sort(colored.begin(), colored.end());
+	colored.erase(std::unique(colored.begin(), colored.end()), colored.end());
+
+	// Vertices removed from the sets since the last call lose the color of their set
+	auto& previous = native->SelectionSets.ColoredVertices;
+	std::vector<int> released;
+	std::set_difference(previous.begin(), previous.end(), colored.begin(), colored.end(), std::back_inserter(released));
+	setColor(released, Color::Gray);
+
+	for (int k = 0; k < setCount; ++k)
+	{
+		const SelectionSet* set = GetSelectionSet(state, setIds[k]);
+		if (set != nullptr)
+			setColor(set->Indices, Color::GetColorById(setIds[k]));
+	}
+
+	if (!released.empty() || !colored.empty())
+		state->DirtyState |= DirtyFlag::CDirty;
+	previous.swap(colored);
+}
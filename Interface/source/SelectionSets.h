@@ -0,0 +1,66 @@
+#pragma once
+#include "InterfaceTypes.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct MeshState;
+
+/**
+ * A named selection beyond the 32 selections stored in S, see AddSelectionSet.
+ * Stored sparsely so operations on it are proportional to the number of selected vertices.
+ */
+struct SelectionSet
+{
+	std::string Name;
+	/** Selected vertices, sorted and unique */
+	std::vector<int> Indices;
+	/** False if the set has been removed, its id may then be reused */
+	bool IsUsed{false};
+	/** The set has changed since the boundary was last calculated, see UpdateBoundary */
+	bool DirtyForBoundary{true};
+};
+
+/**
+ * All selection sets of a mesh with a compact per vertex summary of the membership.
+ */
+struct SelectionSetStore
+{
+	/** Id of the first selection set, ids below are the bits of S */
+	static const int FirstId = 32;
+
+	/** Selection set with id <code>FirstId + i</code> is at index i */
+	std::vector<SelectionSet> Sets;
+	/**
+	 * Per vertex summary, the bit <code>id % 64</code> is set if the vertex may be in the selection set <code>id</code>.
+	 * So a vertex with a zero summary is in no selection set. Empty until the first set is added.
+	 */
+	std::vector<uint64_t> Summary;
+	/**
+	 * Vertices colored by the last SetColorBySelectionSets, sorted. They are reset to gray by the next call if they are
+	 * no longer in any of its sets. Cleared when all colors are overwritten, e.g. by SetColorByMask.
+	 */
+	std::vector<int> ColoredVertices;
+
+	/** @return The bit of the selection set in the Summary */
+	static uint64_t SummaryBit(int id)
+	{ return uint64_t(1) << (id % 64); }
+};
+
+/**
+ * @return The selection set or nullptr if the id is not a used selection set
+ */
+SelectionSet* GetSelectionSet(MeshState* state, int id);
+
+/**
+ * Modify the selection set with the sorted indices of vertices, as for SelectionMode.
+ * Updates the Summary and marks the set as dirty.
+ * @param indices Sorted and unique vertex indices
+ */
+void ModifySelectionSet(MeshState* state, int id, const std::vector<int>& indices, unsigned int selectionMode);
+
+/**
+ * Get all vertices in the mask, sorted and unique.
+ * Proportional to the number of selected vertices, unless <code>mask.Mask</code> is not zero then S is also scanned.
+ */
+void GatherSelected(MeshState* state, const SelectionMask& mask, std::vector<int>& indices);
@@ -0,0 +1,899 @@
+#include "Native.h"
+#include "Session.h"
+#include "MappedFile.h"
+#include "Storage.h"
+#include "Trace.h"
+#include "Util.h"
+#include <igl/cotmatrix.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <string>
+
+// --- File access
+/**
+ * Writes the chunks of a session, see SessionHeader
+ */
+class SessionWriter
+{
+public:
+	explicit SessionWriter(const char* path) : File(path, std::ios::binary | std::ios::trunc)
+	{}
+
+	bool IsOpen() const
+	{ return File.is_open(); }
+
+	bool Good() const
+	{ return File.good(); }
+
+	size_t Bytes()
+	{ return File.tellp(); }
+
+	/** @return False if the remaining data could not be written */
+	bool Close()
+	{
+		File.close();
+		return !File.fail();
+	}
+
+	template<typename T>
+	void Write(const T& value)
+	{
+		File.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	/** Write rows, columns and the elements in the storage order */
+	template<typename Derived>
+	void WriteMatrix(const Eigen::PlainObjectBase<Derived>& matrix)
+	{
+		Write((int) matrix.rows());
+		Write((int) matrix.cols());
+		File.write(reinterpret_cast<const char*>(matrix.data()), sizeof(typename Derived::Scalar) * matrix.size());
+	}
+
+	template<typename Scalar, int Options>
+	void WriteSparse(const Eigen::SparseMatrix<Scalar, Options>& matrix)
+	{
+		if (!matrix.isCompressed())
+		{
+			Eigen::SparseMatrix<Scalar, Options> compressed = matrix;
+			compressed.makeCompressed();
+			WriteSparse(compressed);
+			return;
+		}
+
+		using StorageIndex = typename Eigen::SparseMatrix<Scalar, Options>::StorageIndex;
+		Write((int) matrix.rows());
+		Write((int) matrix.cols());
+		Write((int) matrix.nonZeros());
+		File.write(reinterpret_cast<const char*>(matrix.outerIndexPtr()), sizeof(StorageIndex) * (matrix.outerSize() + 1));
+		File.write(reinterpret_cast<const char*>(matrix.innerIndexPtr()), sizeof(StorageIndex) * matrix.nonZeros());
+		File.write(reinterpret_cast<const char*>(matrix.valuePtr()), sizeof(Scalar) * matrix.nonZeros());
+	}
+
+	template<typename T>
+	void WriteVector(const std::vector<T>& vector)
+	{
+		Write((int) vector.size());
+		File.write(reinterpret_cast<const char*>(vector.data()), sizeof(T) * vector.size());
+	}
+
+	/** Start a chunk, its size is written in EndChunk */
+	void BeginChunk(unsigned int type)
+	{
+		ChunkStart = File.tellp();
+		Chunk.Type = type;
+		Write(Chunk);
+	}
+
+	void EndChunk()
+	{
+		const std::streampos end = File.tellp();
+		Chunk.Size = end - ChunkStart - (std::streamoff) sizeof(SessionChunkHeader);
+		File.seekp(ChunkStart);
+		Write(Chunk);
+		File.seekp(end);
+	}
+
+private:
+	std::ofstream File;
+	SessionChunkHeader Chunk{};
+	std::streampos ChunkStart;
+};
+
+/**
+ * Rename <code>from</code> to <code>to</code>, replacing <code>to</code> if it exists
+ */
+static bool ReplaceFile(const char* from, const char* to)
+{
+#ifdef _WIN32
+	return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+	return std::rename(from, to) == 0;
+#endif
+}
+
+/**
+ * memcpy split into blocks over the threads, so the pages of a mapped file are read in parallel
+ */
+static void CopyParallel(void* to, const char* from, size_t bytes)
+{
+	const size_t blockSize = 1 << 20;
+	const int blocks = (int) ((bytes + blockSize - 1) / blockSize);
+	if (blocks <= 1)
+	{
+		std::memcpy(to, from, bytes);
+		return;
+	}
+
+#pragma omp parallel for num_threads(GetWorkerThreads())
+	for (int block = 0; block < blocks; ++block)
+	{
+		const size_t begin = block * blockSize;
+		std::memcpy(static_cast<char*>(to) + begin, from + begin, std::min(blockSize, bytes - begin));
+	}
+}
+
+/**
+ * Reads a session from memory, each read is bounds checked and fails once the end is reached
+ */
+class SessionReader
+{
+public:
+	SessionReader(const char* data, size_t size) : Position(data), End(data + size)
+	{}
+
+	size_t Remaining() const
+	{ return End - Position; }
+
+	bool ReadBytes(void* to, size_t bytes)
+	{
+		if (bytes > Remaining())
+			return false;
+		CopyParallel(to, Position, bytes);
+		Position += bytes;
+		return true;
+	}
+
+	template<typename T>
+	bool Read(T& value)
+	{
+		return ReadBytes(&value, sizeof(T));
+	}
+
+	/** Read the header of the next chunk, its contents are read with the payload reader */
+	bool ReadChunk(SessionChunkHeader& chunk, SessionReader& payload)
+	{
+		if (!Read(chunk) || chunk.Size > Remaining())
+			return false;
+		payload = SessionReader(Position, chunk.Size);
+		Position += chunk.Size;
+		return true;
+	}
+
+	template<typename Derived>
+	bool ReadMatrix(Eigen::PlainObjectBase<Derived>& matrix)
+	{
+		using Scalar = typename Derived::Scalar;
+		int rows, cols;
+		if (!Read(rows) || !Read(cols) || rows < 0 || cols < 0 ||
+		    (Derived::RowsAtCompileTime != Eigen::Dynamic && rows != Derived::RowsAtCompileTime) ||
+		    (Derived::ColsAtCompileTime != Eigen::Dynamic && cols != Derived::ColsAtCompileTime) ||
+		    (cols > 0 && (size_t) rows > Remaining() / sizeof(Scalar) / cols))
+			return false;
+
+		matrix.resize(rows, cols);
+		return ReadBytes(matrix.data(), sizeof(Scalar) * matrix.size());
+	}
+
+	/** Read a compressed sparse matrix, its inner indices must be sorted and within the matrix */
+	template<typename Scalar, int Options>
+	bool ReadSparse(Eigen::SparseMatrix<Scalar, Options>& matrix)
+	{
+		using StorageIndex = typename Eigen::SparseMatrix<Scalar, Options>::StorageIndex;
+		int rows, cols, nonZeros;
+		if (!Read(rows) || !Read(cols) || !Read(nonZeros) || rows < 0 || cols < 0 || nonZeros < 0)
+			return false;
+
+		const int outerSize = (Options & Eigen::RowMajor) ? rows : cols;
+		const int innerSize = (Options & Eigen::RowMajor) ? cols : rows;
+		if (sizeof(StorageIndex) * ((size_t) outerSize + 1) + (sizeof(StorageIndex) + sizeof(Scalar)) * nonZeros > Remaining())
+			return false;
+
+		matrix.resize(rows, cols);
+		matrix.resizeNonZeros(nonZeros);
+		if (!ReadBytes(matrix.outerIndexPtr(), sizeof(StorageIndex) * (outerSize + 1)) ||
+		    !ReadBytes(matrix.innerIndexPtr(), sizeof(StorageIndex) * nonZeros) ||
+		    !ReadBytes(matrix.valuePtr(), sizeof(Scalar) * nonZeros))
+			return false;
+
+		const StorageIndex* outer = matrix.outerIndexPtr();
+		const StorageIndex* inner = matrix.innerIndexPtr();
+		if (outer[0] != 0 || outer[outerSize] != nonZeros ||
+		    !std::is_sorted(outer, outer + outerSize + 1))
+			return false;
+		for (int o = 0; o < outerSize; ++o)
+			for (StorageIndex k = outer[o]; k < outer[o + 1]; ++k)
+				if (inner[k] < 0 || inner[k] >= innerSize || (k > outer[o] && inner[k] <= inner[k - 1]))
+					return false;
+		return true;
+	}
+
+	template<typename T>
+	bool ReadVector(std::vector<T>& vector)
+	{
+		int size;
+		if (!Read(size) || size < 0 || sizeof(T) * size > Remaining())
+			return false;
+
+		vector.resize(size);
+		return ReadBytes(vector.data(), sizeof(T) * size);
+	}
+
+private:
+	const char* Position;
+	const char* End;
+};
+
+// --- Validation
+/**
+ * @return True if all indices are in [0, size)
+ */
+template<typename Derived>
+static bool IndicesInRange(const Eigen::DenseBase<Derived>& indices, int size)
+{
+	return indices.size() == 0 || (indices.minCoeff() >= 0 && indices.maxCoeff() < size);
+}
+
+static bool IndicesInRange(const std::vector<int>& indices, int size)
+{
+	return std::all_of(indices.begin(), indices.end(), [&](int i) { return i >= 0 && i < size; });
+}
+
+/**
+ * @return True if the indices are a permutation of [0, size)
+ */
+template<typename Derived>
+static bool IsPermutation(const Eigen::DenseBase<Derived>& indices, int size)
+{
+	if (indices.size() != size)
+		return false;
+
+	std::vector<char> isUsed(size, false);
+	for (int k = 0; k < size; ++k)
+	{
+		const int i = indices(k);
+		if (i < 0 || i >= size || isUsed[i])
+			return false;
+		isUsed[i] = true;
+	}
+	return true;
+}
+
+/**
+ * @return True if the adjacency has <code>rows</code> rows and its indices are in [0, columns)
+ */
+static bool IsValidAdjacency(const CsrAdjacency& adjacency, int rows, int columns)
+{
+	return (int) adjacency.Start.size() == rows + 1 && adjacency.Start[0] == 0 &&
+	       adjacency.Start[rows] == (int) adjacency.Indices.size() &&
+	       std::is_sorted(adjacency.Start.begin(), adjacency.Start.end()) &&
+	       IndicesInRange(adjacency.Indices, columns);
+}
+
+template<typename Derived>
+static bool HasSize(const Eigen::PlainObjectBase<Derived>& matrix, int rows, int cols)
+{
+	return matrix.rows() == rows && matrix.cols() == cols;
+}
+
+// --- Chunks
+/**
+ * The factorization of an Eigen::SimplicialLLT or SimplicialLDLT is written by accessing its protected members.
+ * They are the same in Eigen 3.3 and 3.4, with other versions ARAP is precomputed again after loading instead.
+ */
+#if EIGEN_VERSION_AT_LEAST(3, 3, 0) && !EIGEN_VERSION_AT_LEAST(3, 5, 0)
+#define SESSION_CHOLESKY 1
+#else
+#define SESSION_CHOLESKY 0
+#endif
+
+#if SESSION_CHOLESKY
+/**
+ * Access to the factorization of an Eigen::SimplicialLLT or SimplicialLDLT, which has no public setter
+ */
+template<typename Solver>
+struct CholeskyAccess : Solver
+{
+	static auto& Matrix(Solver& solver)
+	{ return solver.*(&CholeskyAccess::m_matrix); }
+
+	static auto& Diag(Solver& solver)
+	{ return solver.*(&CholeskyAccess::m_diag); }
+
+	static auto& Parent(Solver& solver)
+	{ return solver.*(&CholeskyAccess::m_parent); }
+
+	static auto& NonZerosPerCol(Solver& solver)
+	{ return solver.*(&CholeskyAccess::m_nonZerosPerCol); }
+
+	static auto& P(Solver& solver)
+	{ return solver.*(&CholeskyAccess::m_P); }
+
+	static auto& Pinv(Solver& solver)
+	{ return solver.*(&CholeskyAccess::m_Pinv); }
+
+	static auto& ShiftOffset(Solver& solver)
+	{ return solver.*(&CholeskyAccess::m_shiftOffset); }
+
+	static auto& ShiftScale(Solver& solver)
+	{ return solver.*(&CholeskyAccess::m_shiftScale); }
+};
+
+template<typename Solver>
+static void WriteCholesky(SessionWriter& out, Solver& solver)
+{
+	using Access = CholeskyAccess<Solver>;
+	out.WriteSparse(Access::Matrix(solver));
+	out.WriteMatrix(Access::Diag(solver));
+	out.WriteMatrix(Access::Parent(solver));
+	out.WriteMatrix(Access::NonZerosPerCol(solver));
+	out.WriteMatrix(Access::P(solver).indices());
+	out.WriteMatrix(Access::Pinv(solver).indices());
+	out.Write(Access::ShiftOffset(solver));
+	out.Write(Access::ShiftScale(solver));
+}
+
+/**
+ * Restore a factorization written by WriteCholesky, without factorizing again
+ */
+template<typename Solver>
+static bool ReadCholesky(SessionReader& in, Solver& solver)
+{
+	using Access = CholeskyAccess<Solver>;
+	if (!in.ReadSparse(Access::Matrix(solver)))
+		return false;
+
+	// Mark the solver as factorized with a trivial factorization of the same size, then replace it
+	const typename Solver::CholMatrixType factor = Access::Matrix(solver);
+	Eigen::SparseMatrix<typename Solver::Scalar> identity(factor.rows(), factor.cols());
+	identity.setIdentity();
+	solver.compute(identity);
+	Access::Matrix(solver) = factor;
+
+	const int n = factor.rows();
+	if (!(in.ReadMatrix(Access::Diag(solver)) &&
+	      in.ReadMatrix(Access::Parent(solver)) &&
+	      in.ReadMatrix(Access::NonZerosPerCol(solver)) &&
+	      in.ReadMatrix(Access::P(solver).indices()) &&
+	      in.ReadMatrix(Access::Pinv(solver).indices()) &&
+	      in.Read(Access::ShiftOffset(solver)) &&
+	      in.Read(Access::ShiftScale(solver))))
+		return false;
+
+	// Without a fill-in reducing ordering the permutations are empty
+	const auto& P = Access::P(solver).indices();
+	const auto& Pinv = Access::Pinv(solver).indices();
+	return factor.cols() == n && (Access::Diag(solver).size() == 0 || Access::Diag(solver).size() == n) &&
+	       Access::Parent(solver).size() == n && Access::NonZerosPerCol(solver).size() == n &&
+	       ((P.size() == 0 && Pinv.size() == 0) || (IsPermutation(P, n) && IsPermutation(Pinv, n)));
+}
+#endif
+
+/**
+ * @return True if the ARAP factorization can be saved, i.e. is a Cholesky factorization without constraints.
+ * Otherwise ARAP is precomputed again after loading.
+ */
+static bool CanWriteArap(const igl::ARAPData<float>& data)
+{
+#if !SESSION_CHOLESKY
+	return false;
+#endif
+	const auto& solver = data.solver_data;
+	using SolverData = igl::min_quad_with_fixed_data<float>;
+	return solver.Aeq_li &&
+	       ((solver.solver_type == SolverData::LLT && solver.llt.info() == Eigen::Success) ||
+	        (solver.solver_type == SolverData::LDLT && solver.ldlt.info() == Eigen::Success));
+}
+
+static void WriteArap(SessionWriter& out, igl::ARAPData<float>& data)
+{
+	out.Write(data.n);
+	out.WriteMatrix(data.G);
+	out.Write((int) data.energy);
+	out.Write(data.with_dynamics);
+	out.WriteMatrix(data.f_ext);
+	out.WriteMatrix(data.vel);
+	out.Write(data.h);
+	out.Write(data.ym);
+	out.Write(data.max_iter);
+	out.WriteSparse(data.K);
+	out.WriteSparse(data.M);
+	out.WriteSparse(data.CSM);
+	out.WriteMatrix(data.b);
+	out.Write(data.dim);
+
+	auto& solver = data.solver_data;
+	out.Write(solver.n);
+	out.Write(solver.Auu_pd);
+	out.Write(solver.Auu_sym);
+	out.WriteMatrix(solver.known);
+	out.WriteMatrix(solver.unknown);
+	out.WriteMatrix(solver.lagrange);
+	out.WriteMatrix(solver.unknown_lagrange);
+	out.WriteSparse(solver.preY);
+	out.Write((int) solver.solver_type);
+	out.Write(solver.Aeq_li);
+	out.Write(solver.neq);
+#if SESSION_CHOLESKY
+	if (solver.solver_type == igl::min_quad_with_fixed_data<float>::LLT)
+		WriteCholesky(out, solver.llt);
+	else
+		WriteCholesky(out, solver.ldlt);
+#endif
+}
+
+/**
+ * @param VSize The vertices of the mesh, the indices of the ARAP data must be within them
+ */
+static bool ReadArap(SessionReader& in, igl::ARAPData<float>& data, int VSize)
+{
+	int energy;
+	if (!(in.Read(data.n) && in.ReadMatrix(data.G) && in.Read(energy) && in.Read(data.with_dynamics) &&
+	      in.ReadMatrix(data.f_ext) && in.ReadMatrix(data.vel) && in.Read(data.h) && in.Read(data.ym) &&
+	      in.Read(data.max_iter) && in.ReadSparse(data.K) && in.ReadSparse(data.M) && in.ReadSparse(data.CSM) &&
+	      in.ReadMatrix(data.b) && in.Read(data.dim)))
+		return false;
+	data.energy = (igl::ARAPEnergyType) energy;
+
+	auto& solver = data.solver_data;
+	int solverType;
+	if (!(in.Read(solver.n) && in.Read(solver.Auu_pd) && in.Read(solver.Auu_sym) && in.ReadMatrix(solver.known) &&
+	      in.ReadMatrix(solver.unknown) && in.ReadMatrix(solver.lagrange) && in.ReadMatrix(solver.unknown_lagrange) &&
+	      in.ReadSparse(solver.preY) && in.Read(solverType) && in.Read(solver.Aeq_li) && in.Read(solver.neq)))
+		return false;
+
+	const int n = VSize;
+	if (data.n != n || data.dim != 3 || (data.G.size() != 0 && data.G.size() != n) || !IndicesInRange(data.b, n) ||
+	    solver.n != n || solver.neq < 0 || solver.known.size() + solver.unknown.size() != n ||
+	    !IndicesInRange(solver.known, n) || !IndicesInRange(solver.unknown, n) ||
+	    !IndicesInRange(solver.unknown_lagrange, n + solver.neq))
+		return false;
+
+#if SESSION_CHOLESKY
+	using SolverData = igl::min_quad_with_fixed_data<float>;
+	solver.solver_type = (SolverData::SolverType) solverType;
+	if (solver.solver_type == SolverData::LLT)
+		return ReadCholesky(in, solver.llt);
+	if (solver.solver_type == SolverData::LDLT)
+		return ReadCholesky(in, solver.ldlt);
+#endif
+	return false;
+}
+
+static void WriteSelectionSets(SessionWriter& out, const SelectionSetStore& store)
+{
+	out.Write((int) store.Sets.size());
+	for (const auto& set : store.Sets)
+	{
+		out.WriteVector(std::vector<char>(set.Name.begin(), set.Name.end()));
+		out.Write(set.IsUsed);
+		out.Write(set.DirtyForBoundary);
+		out.WriteVector(set.Indices);
+	}
+	out.WriteVector(store.Summary);
+}
+
+/**
+ * @param VSize The vertices of the mesh, the sets must only contain these
+ */
+static bool ReadSelectionSets(SessionReader& in, SelectionSetStore& store, int VSize)
+{
+	int count;
+	if (!in.Read(count) || count < 0)
+		return false;
+
+	store.Sets.resize(count);
+	for (auto& set : store.Sets)
+	{
+		std::vector<char> name;
+		if (!in.ReadVector(name) || !in.Read(set.IsUsed) || !in.Read(set.DirtyForBoundary) ||
+		    !in.ReadVector(set.Indices) || !IndicesInRange(set.Indices, VSize) ||
+		    std::adjacent_find(set.Indices.begin(), set.Indices.end(), std::greater_equal<int>()) != set.Indices.end())
+			return false;
+		set.Name.assign(name.begin(), name.end());
+	}
+	if (!in.ReadVector(store.Summary))
+		return false;
+
+	// The summary is created with the first set, it is updated for the vertices of a set
+	const bool isEmpty = std::all_of(store.Sets.begin(), store.Sets.end(), [](const SelectionSet& set) {
+		return set.Indices.empty();
+	});
+	return (int) store.Summary.size() == VSize || (store.Summary.empty() && isEmpty);
+}
+
+/**
+ * Delete the caches depending on V0, F or the selections, they are replaced by those of the session or recomputed
+ */
+static void ResetCaches(MeshStateNative* native)
+{
+	delete native->ArapData;
+	native->ArapData = nullptr;
+	delete native->Smooth;
+	native->Smooth = nullptr;
+	delete native->Skinning;
+	native->Skinning = nullptr;
+	delete native->HeatGeodesics;
+	native->HeatGeodesics = nullptr;
+	delete native->SelfIntersection;
+	native->SelfIntersection = nullptr;
+	native->SymmetryAxis = -1;
+	native->Mirror.resize(0);
+	native->RestFaceShape.resize(0, 4);
+}
+
+/**
+ * Contents of a session, read and validated completely before any of it replaces the mesh data
+ */
+struct SessionData
+{
+	/** Bits of the SessionChunk types that were read */
+	unsigned int Chunks{0};
+
+	Eigen::MatrixXf V0, V, N, C, UV;
+	Eigen::MatrixXi F;
+	Eigen::VectorXi S;
+	decltype(MeshStateNative::C8) C8;
+	decltype(MeshStateNative::UV16) UV16;
+	decltype(MeshStateNative::S8) S8;
+	decltype(MeshStateNative::S16) S16;
+	Eigen::VectorXi VertexOrder, FaceOrder;
+
+	SelectionSetStore SelectionSets;
+	unsigned int BoundaryMask{0};
+	std::vector<int> BoundarySetIds;
+	Eigen::VectorXi Boundary;
+	Eigen::MatrixXf BoundaryConditions;
+	unsigned int DirtySelectionsForBoundary{0};
+	bool DirtyBoundaryConditions{true};
+	bool harmonicShowDeformationField{false};
+
+	Eigen::SparseMatrix<float> Laplacian;
+	CsrAdjacency VertexVertices, VertexFaces;
+	igl::ARAPData<float>* Arap{nullptr};
+	MeshStateNative::SkinningData* Skinning{nullptr};
+
+	~SessionData()
+	{
+		delete Arap;
+		delete Skinning;
+	}
+
+	bool Has(unsigned int type) const
+	{ return (Chunks & 1u << type) != 0; }
+};
+
+/**
+ * Read one chunk into <code>data</code> and validate it against the header
+ * @return False if the chunk is incomplete or inconsistent with the mesh
+ */
+static bool ReadChunk(SessionReader& in, unsigned int type, const SessionHeader& header, SessionData& data)
+{
+	const int VSize = header.VSize, FSize = header.FSize;
+	// Unused storage is empty, e.g. C with compact storage
+	const bool compact = header.CompactStorage != 0;
+	const int CRows = compact ? 0 : VSize, C8Rows = compact ? VSize : 0;
+
+	switch (type)
+	{
+		case SessionChunk::V0:
+			return in.ReadMatrix(data.V0) && HasSize(data.V0, VSize, 3);
+		case SessionChunk::V:
+			return in.ReadMatrix(data.V) && HasSize(data.V, VSize, 3);
+		case SessionChunk::N:
+			return in.ReadMatrix(data.N) && HasSize(data.N, VSize, 3);
+		case SessionChunk::C:
+			return in.ReadMatrix(data.C) && HasSize(data.C, CRows, 4);
+		case SessionChunk::UV:
+			return in.ReadMatrix(data.UV) && HasSize(data.UV, CRows, 2);
+		case SessionChunk::F:
+			return in.ReadMatrix(data.F) && HasSize(data.F, FSize, 3) && IndicesInRange(data.F, VSize);
+		case SessionChunk::S:
+			return in.ReadMatrix(data.S) && data.S.size() == (header.SWidth == 32 ? VSize : 0);
+		case SessionChunk::C8:
+			return in.ReadMatrix(data.C8) && data.C8.rows() == C8Rows;
+		case SessionChunk::UV16:
+			return in.ReadMatrix(data.UV16) && data.UV16.rows() == C8Rows;
+		case SessionChunk::S8:
+			return in.ReadMatrix(data.S8) && data.S8.size() == (header.SWidth == 8 ? VSize : 0);
+		case SessionChunk::S16:
+			return in.ReadMatrix(data.S16) && data.S16.size() == (header.SWidth == 16 ? VSize : 0);
+		case SessionChunk::MeshOrder:
+			return in.ReadMatrix(data.VertexOrder) && in.ReadMatrix(data.FaceOrder) &&
+			       (data.VertexOrder.size() == 0 || IsPermutation(data.VertexOrder, VSize)) &&
+			       (data.FaceOrder.size() == 0 || IsPermutation(data.FaceOrder, FSize));
+		case SessionChunk::SelectionSets:
+			return ReadSelectionSets(in, data.SelectionSets, VSize);
+		case SessionChunk::Boundary:
+			return in.Read(data.BoundaryMask) && in.ReadVector(data.BoundarySetIds) && in.ReadMatrix(data.Boundary) &&
+			       in.ReadMatrix(data.BoundaryConditions) && in.Read(data.DirtySelectionsForBoundary) &&
+			       in.Read(data.DirtyBoundaryConditions) && in.Read(data.harmonicShowDeformationField) &&
+			       IndicesInRange(data.Boundary, VSize) &&
+			       (data.BoundaryConditions.size() == 0 ||
+			        HasSize(data.BoundaryConditions, (int) data.Boundary.size(), 3));
+		case SessionChunk::Topology:
+			return in.ReadSparse(data.Laplacian) && in.ReadVector(data.VertexVertices.Start) &&
+			       in.ReadVector(data.VertexVertices.Indices) && in.ReadVector(data.VertexFaces.Start) &&
+			       in.ReadVector(data.VertexFaces.Indices) && data.Laplacian.rows() == VSize &&
+			       data.Laplacian.cols() == VSize && IsValidAdjacency(data.VertexVertices, VSize, VSize) &&
+			       IsValidAdjacency(data.VertexFaces, VSize, FSize);
+		case SessionChunk::Arap:
+		{
+			delete data.Arap;
+			data.Arap = new igl::ARAPData<float>();
+			const bool valid = ReadArap(in, *data.Arap, VSize);
+			if (!valid)
+			{
+				delete data.Arap;
+				data.Arap = nullptr;
+			}
+#if SESSION_CHOLESKY
+			return valid;
+#else
+			// The factorization cannot be read with this Eigen version, ARAP is precomputed again
+			return true;
+#endif
+		}
+		case SessionChunk::Skinning:
+		{
+			delete data.Skinning;
+			data.Skinning = new MeshStateNative::SkinningData();
+			auto& skinning = *data.Skinning;
+			return in.ReadVector(skinning.Handles) && in.ReadMatrix(skinning.VRest) && in.ReadSparse(skinning.M) &&
+			       in.ReadMatrix(skinning.T) && HasSize(skinning.VRest, VSize, 3) &&
+			       std::all_of(skinning.Handles.begin(), skinning.Handles.end(), [](int id) {
+				       return id >= 0 && id < 32;
+			       }) &&
+			       skinning.M.rows() == VSize &&
+			       skinning.M.cols() == 4 * (int) skinning.Handles.size() &&
+			       HasSize(skinning.T, 4 * (int) skinning.Handles.size(), 3);
+		}
+		default:
+			// Unknown chunks are skipped
+			return true;
+	}
+}
+
+// --- Exports
+bool SaveSession(MeshState* state, const char* path, bool includeCaches)
+{
+	state->EnsureInitialized();
+	auto* native = state->Native;
+
+	// Written to a temporary file first, so the previous session is kept if the save fails
+	const std::string tempPath = std::string(path) + ".tmp";
+	SessionWriter out(tempPath.c_str());
+	if (!out.IsOpen())
+	{
+		LOGERR("SaveSession: Could not open " << tempPath)
+		return false;
+	}
+
+	SessionHeader header{};
+	header.VSize = state->VSize;
+	header.FSize = state->FSize;
+	header.SSize = state->SSize;
+	std::copy(state->SSizes, state->SSizes + 32, header.SSizes);
+	header.SSizesAll = state->SSizesAll;
+	header.CompactStorage = native->CompactStorage;
+	header.SWidth = native->SWidth;
+	out.Write(header);
+
+	// Unused storage is empty, e.g. C with compact storage, and is written as such
+	auto writeMatrix = [&](unsigned int type, const auto& matrix) {
+		out.BeginChunk(type);
+		out.WriteMatrix(matrix);
+		out.EndChunk();
+	};
+	writeMatrix(SessionChunk::V0, *native->V0);
+	writeMatrix(SessionChunk::V, *state->V);
+	writeMatrix(SessionChunk::N, *state->N);
+	writeMatrix(SessionChunk::C, *state->C);
+	writeMatrix(SessionChunk::UV, *state->UV);
+	writeMatrix(SessionChunk::F, *state->F);
+	writeMatrix(SessionChunk::S, *state->S);
+	writeMatrix(SessionChunk::C8, native->C8);
+	writeMatrix(SessionChunk::UV16, native->UV16);
+	writeMatrix(SessionChunk::S8, native->S8);
+	writeMatrix(SessionChunk::S16, native->S16);
+
+	out.BeginChunk(SessionChunk::MeshOrder);
+	out.WriteMatrix(native->VertexOrder);
+	out.WriteMatrix(native->FaceOrder);
+	out.EndChunk();
+
+	out.BeginChunk(SessionChunk::SelectionSets);
+	WriteSelectionSets(out, native->SelectionSets);
+	out.EndChunk();
+
+	out.BeginChunk(SessionChunk::Boundary);
+	out.Write(native->BoundaryMask);
+	out.WriteVector(native->BoundarySetIds);
+	out.WriteMatrix(native->Boundary);
+	out.WriteMatrix(native->BoundaryConditions);
+	out.Write(native->DirtySelectionsForBoundary);
+	out.Write(native->DirtyBoundaryConditions);
+	out.Write(native->harmonicShowDeformationField);
+	out.EndChunk();
+
+	if (includeCaches)
+	{
+		out.BeginChunk(SessionChunk::Topology);
+		out.WriteSparse(native->Laplacian);
+		out.WriteVector(native->VertexVertices.Start);
+		out.WriteVector(native->VertexVertices.Indices);
+		out.WriteVector(native->VertexFaces.Start);
+		out.WriteVector(native->VertexFaces.Indices);
+		out.EndChunk();
+
+		if (native->ArapData != nullptr && CanWriteArap(*native->ArapData))
+		{
+			out.BeginChunk(SessionChunk::Arap);
+			WriteArap(out, *native->ArapData);
+			out.EndChunk();
+		}
+
+		if (native->Skinning != nullptr)
+		{
+			const auto& skinning = *native->Skinning;
+			out.BeginChunk(SessionChunk::Skinning);
+			out.WriteVector(skinning.Handles);
+			out.WriteMatrix(skinning.VRest);
+			out.WriteSparse(skinning.M);
+			out.WriteMatrix(skinning.T);
+			out.EndChunk();
+		}
+	}
+
+	const size_t bytes = out.Good() ? out.Bytes() : 0;
+	if (bytes == 0 || !out.Close() || !ReplaceFile(tempPath.c_str(), path))
+	{
+		out.Close();
+		std::remove(tempPath.c_str());
+		LOGERR("SaveSession: Could not write " << path)
+		return false;
+	}
+
+	LOG("SaveSession: " << bytes / 1024 << " KiB to " << path)
+	return true;
+}
+
+bool LoadSession(MeshState* state, const char* path)
+{
+	state->EnsureInitialized();
+	auto* native = state->Native;
+	const auto start = std::chrono::steady_clock::now();
+
+	MappedFile file(path);
+	if (file.Data == nullptr)
+	{
+		LOGERR("LoadSession: Could not open " << path)
+		return false;
+	}
+
+	SessionReader in(file.Data, file.Size);
+	SessionHeader header;
+	const SessionHeader expected{};
+	if (!in.Read(header) || std::memcmp(header.Magic, expected.Magic, sizeof(header.Magic)) != 0 ||
+	    header.Version != expected.Version)
+	{
+		LOGERR("LoadSession: Not a session or an unsupported version: " << path)
+		return false;
+	}
+	if (header.VSize != state->VSize || header.FSize != state->FSize)
+	{
+		LOGERR("LoadSession: The session is for a mesh with " << header.VSize << " vertices and " << header.FSize
+		       << " faces, not " << state->VSize << " and " << state->FSize)
+		return false;
+	}
+	if ((header.SWidth != 8 && header.SWidth != 16 && header.SWidth != 32) ||
+	    (header.CompactStorage == 0 && header.SWidth != 32) || header.SSize > (unsigned int) header.SWidth)
+	{
+		LOGERR("LoadSession: Invalid selection storage in " << path)
+		return false;
+	}
+
+	// Read everything before modifying the mesh, so an invalid or truncated file leaves it unchanged
+	SessionData data;
+	SessionChunkHeader chunk;
+	SessionReader payload(nullptr, 0);
+	while (in.ReadChunk(chunk, payload))
+	{
+		if (!ReadChunk(payload, chunk.Type, header, data))
+		{
+			LOGERR("LoadSession: Invalid chunk " << chunk.Type << " in " << path)
+			return false;
+		}
+		if (chunk.Type < 32)
+			data.Chunks |= 1u << chunk.Type;
+	}
+	if (in.Remaining() > 0)
+	{
+		LOGERR("LoadSession: Truncated file: " << path)
+		return false;
+	}
+
+	const unsigned int required[] = {
+			SessionChunk::V0, SessionChunk::V, SessionChunk::N, SessionChunk::C, SessionChunk::UV, SessionChunk::F,
+			SessionChunk::S, SessionChunk::C8, SessionChunk::UV16, SessionChunk::S8, SessionChunk::S16,
+			SessionChunk::SelectionSets, SessionChunk::Boundary};
+	for (const unsigned int type : required)
+		if (!data.Has(type))
+		{
+			LOGERR("LoadSession: Missing chunk " << type << " in " << path)
+			return false;
+		}
+	ResetCaches(native);
+	state->SSize = header.SSize;
+	std::copy(header.SSizes, header.SSizes + 32, state->SSizes);
+	state->SSizesAll = header.SSizesAll;
+	native->CompactStorage = header.CompactStorage != 0;
+	native->SWidth = header.SWidth;
+
+	native->V0->swap(data.V0);
+	state->V->swap(data.V);
+	state->N->swap(data.N);
+	state->C->swap(data.C);
+	state->UV->swap(data.UV);
+	state->F->swap(data.F);
+	state->S->swap(data.S);
+	native->C8.swap(data.C8);
+	native->UV16.swap(data.UV16);
+	native->S8.swap(data.S8);
+	native->S16.swap(data.S16);
+	// Sessions without the order were saved from a mesh that was not reordered
+	native->VertexOrder.swap(data.VertexOrder);
+	native->FaceOrder.swap(data.FaceOrder);
+
+	std::swap(native->SelectionSets, data.SelectionSets);
+	native->BoundaryMask = data.BoundaryMask;
+	native->BoundarySetIds.swap(data.BoundarySetIds);
+	native->Boundary.swap(data.Boundary);
+	native->BoundaryConditions.swap(data.BoundaryConditions);
+	native->DirtySelectionsForBoundary = data.DirtySelectionsForBoundary;
+	native->DirtyBoundaryConditions = data.DirtyBoundaryConditions;
+	native->harmonicShowDeformationField = data.harmonicShowDeformationField;
+	std::swap(native->ArapData, data.Arap);
+	std::swap(native->Skinning, data.Skinning);
+
+	if (data.Has(SessionChunk::Topology))
+	{
+		native->Laplacian.swap(data.Laplacian);
+		std::swap(native->VertexVertices, data.VertexVertices);
+		std::swap(native->VertexFaces, data.VertexFaces);
+	}
+	else
+	{
+		// Saved without the caches, V0 or F may differ from the mesh this was loaded into
+		BuildVertexVertices(*state->F, state->VSize, native->VertexVertices);
+		BuildVertexFaces(*state->F, state->VSize, native->VertexFaces);
+		igl::cotmatrix(*native->V0, *state->F, native->Laplacian);
+	}
+
+	// Keep the loaded colors and boundary conditions, the selection sizes are updated in ApplyDirty
+	state->DirtyState |= DirtyFlag::VDirtyExclBoundary | DirtyFlag::NDirty | DirtyFlag::CDirty | DirtyFlag::UVDirty |
+	                     DirtyFlag::FDirty | DirtyFlag::DontComputeColorsBySelection;
+	native->ExtendDirtyV(0, state->VSize);
+	state->DirtySelections = (unsigned int) -1;
+
+	// The mesh is snapshot again when it is next used in a trace
+	TraceDispose(state);
+
+	const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	LOG("LoadSession: " << path << " in " << ms << " ms")
+	return true;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+/**
+ * Type of a chunk in a session file, see SessionHeader
+ */
+struct SessionChunk
+{
+	/** Dense matrices: int Rows, int Cols followed by the elements in the storage order of the member */
+	static const unsigned int V0 = 0;
+	static const unsigned int V = 1;
+	static const unsigned int N = 2;
+	static const unsigned int C = 3;
+	static const unsigned int UV = 4;
+	static const unsigned int F = 5;
+	static const unsigned int S = 6;
+	static const unsigned int C8 = 7;
+	static const unsigned int UV16 = 8;
+	static const unsigned int S8 = 9;
+	static const unsigned int S16 = 10;
+	/** The SelectionSetStore */
+	static const unsigned int SelectionSets = 11;
+	/** Boundary of the deformations and its lazy evaluation state */
+	static const unsigned int Boundary = 12;
+	/** Laplacian, VertexVertices and VertexFaces */
+	static const unsigned int Topology = 13;
+	/** ArapData including the factorization, only if the precomputation used a Cholesky factorization */
+	static const unsigned int Arap = 14;
+	/** SkinningData */
+	static const unsigned int Skinning = 15;
+	/** VertexOrder and FaceOrder as dense matrices, empty if the mesh was not reordered, see ReorderMesh */
+	static const unsigned int MeshOrder = 16;
+};
+
+/**
+ * Header of each chunk, followed by <code>Size</code> bytes. Unknown chunks are skipped when loading.
+ * All chunks up to Boundary are required, except MeshOrder and the caches from Topology on.
+ */
+struct SessionChunkHeader
+{
+	unsigned int Type;
+	unsigned int Reserved{0};
+	unsigned long long Size;
+};
+
+/**
+ * Binary session of a mesh, see SaveSession. Layout of the file:
+ * <ol>
+ * <li>SessionHeader</li>
+ * <li>Chunks until the end of the file, each one starts with a SessionChunkHeader, see SessionChunk for the
+ * contents</li>
+ * </ol>
+ * Matrices are written in their in-memory layout so loading is a copy from the memory-mapped file.
+ * Sparse matrices are compressed: int Rows, Cols, NonZeros followed by the outer, inner index and value arrays.
+ * As with traces, a session can only be loaded on a platform with the same endianness and alignment.
+ */
+struct SessionHeader
+{
+	char Magic[4]{'L', 'S', 'E', 'S'};
+	unsigned int Version{1};
+	int VSize;
+	int FSize;
+	unsigned int SSize;
+	unsigned int SSizes[32];
+	unsigned int SSizesAll;
+	unsigned int CompactStorage;
+	int SWidth;
+};
@@ -0,0 +1,174 @@
+#include "Native.h"
+#include "Scheduler.h"
+#include "Storage.h"
+#include "Trace.h"
+#include <igl/bbw.h>
+#include <igl/harmonic.h>
+
+using SkinningData = MeshStateNative::SkinningData;
+
+/** Weights below this are dropped, so each vertex is only influenced by the nearby handles */
+static const double WeightEpsilon = 1e-3;
+
+/**
+ * Build the sparse linear blend skinning matrix from the dense weights.
+ * The weights of a vertex are renormalized to a partition of unity after dropping the small ones.
+ */
+static void BuildSkinningMatrix(SkinningData* data, const Eigen::MatrixXd& W)
+{
+	const auto& V = data->VRest;
+	std::vector<Eigen::Triplet<float>> triplets;
+	for (int i = 0; i < W.rows(); ++i)
+	{
+		double sum = 0.;
+		for (int h = 0; h < W.cols(); ++h)
+			if (W(i, h) > WeightEpsilon)
+				sum += W(i, h);
+		if (sum <= 0.)
+			continue;
+
+		for (int h = 0; h < W.cols(); ++h)
+		{
+			if (W(i, h) <= WeightEpsilon)
+				continue;
+
+			const float w = W(i, h) / sum;
+			for (int c = 0; c < 3; ++c)
+				triplets.emplace_back(i, 4 * h + c, w * V(i, c));
+			triplets.emplace_back(i, 4 * h + 3, w);
+		}
+	}
+
+	data->M.resize(W.rows(), 4 * W.cols());
+	data->M.setFromTriplets(triplets.begin(), triplets.end());
+	data->T.setZero(4 * W.cols(), 3);
+}
+
+void ComputeSkinningWeights(MeshState* state, unsigned int handleMask, bool bounded)
+{
+	TraceScope trace(state, BatchOp::ComputeSkinningWeights, [&](BatchCommand& cmd) {
+		cmd.MaskId = handleMask;
+		cmd.Flags = bounded ? BatchFlag::BoundedWeights : BatchFlag::None;
+	});
+	state->EnsureInitialized();
+
+	delete state->Native->Skinning;
+	state->Native->Skinning = nullptr;
+
+	// Each vertex constrains the handle of its lowest selection in the mask
+	std::vector<int> b, bHandle;
+	unsigned int usedMask = 0;
+	VisitS(state, [&](const auto& S) {
+		for (int i = 0; i < state->VSize; ++i)
+		{
+			const unsigned int s = S(i) & handleMask;
+			if (s == 0)
+				continue;
+
+			int selectionId = 0;
+			while ((s & (1u << selectionId)) == 0)
+				selectionId++;
+			b.push_back(i);
+			bHandle.push_back(selectionId);
+			usedMask |= 1u << selectionId;
+		}
+	});
+	if (usedMask == 0)
+	{
+		LOGWARN("ComputeSkinningWeights: No handles selected, skinning removed.")
+		return;
+	}
+
+	auto* data = new SkinningData();
+	std::vector<int> column(32, -1);
+	for (int selectionId = 0; selectionId < 32; ++selectionId)
+	{
+		if ((usedMask & (1u << selectionId)) == 0)
+			continue;
+		column[selectionId] = data->Handles.size();
+		data->Handles.push_back(selectionId);
+	}
+
+	const Eigen::VectorXi bEigen = Eigen::Map<Eigen::VectorXi>(b.data(), b.size());
+	Eigen::MatrixXd bc = Eigen::MatrixXd::Zero(b.size(), data->Handles.size());
+	for (int k = 0; k < (int) b.size(); ++k)
+		bc(k, column[bHandle[k]]) = 1.;
+
+	SolverScope scope(state, true);
+	data->VRest = *state->V;
+	const Eigen::MatrixXd V = state->V->cast<double>();
+	Eigen::MatrixXd W;
+	bool success;
+	if (bounded)
+	{
+		igl::BBWData bbwData;
+		bbwData.active_set_params.max_iter = 8;
+		bbwData.verbosity = 0;
+		success = igl::bbw(V, *state->F, bEigen, bc, bbwData, W);
+	}
+	else
+		success = igl::harmonic(V, *state->F, bEigen, bc, 2, W);
+
+	if (!success)
+	{
+		LOGERR("ComputeSkinningWeights: Computing the weights failed.")
+		delete data;
+		return;
+	}
+
+	BuildSkinningMatrix(data, W);
+	state->Native->Skinning = data;
+	LOG("Skinning: " << data->Handles.size() << " handles, " << data->M.nonZeros() / 4 << " weights.")
+}
+
+void TransformHandles(MeshState* state, Vector3 translation, float scale, Quaternion rotation, Vector3 pivot,
+                      unsigned int maskId)
+{
+	TraceScope trace(state, BatchOp::TransformHandles, [&](BatchCommand& cmd) {
+		cmd.Translation = translation;
+		cmd.Scale = scale;
+		cmd.Rotation = rotation;
+		cmd.Pivot = pivot;
+		cmd.MaskId = maskId;
+	});
+	state->EnsureInitialized();
+
+	auto* data = state->Native->Skinning;
+	if (data == nullptr)
+	{
+		LOGWARN("TransformHandles: No skinning, call ComputeSkinningWeights first.")
+		return;
+	}
+
+	using namespace Eigen;
+	Transform<float, 3, Affine> transform =
+			Translation3f(translation.AsEigen()) *
+			Translation3f(pivot.AsEigen()) * Scaling(scale) * rotation.AsEigen() * Translation3f(-pivot.AsEigen());
+
+	bool isModified = false;
+	for (int h = 0; h < (int) data->Handles.size(); ++h)
+	{
+		if ((maskId & (1u << data->Handles[h])) == 0)
+			continue;
+
+		auto block = data->T.block<4, 3>(4 * h, 0);
+		Transform<float, 3, Affine> current;
+		current.matrix().topRows<3>() = block.transpose();
+		current.matrix().topLeftCorner<3, 3>() += Matrix3f::Identity();
+
+		const Transform<float, 3, Affine> result = transform * current;
+		block = result.matrix().topRows<3>().transpose();
+		block.topRows<3>() -= Matrix3f::Identity();
+		isModified = true;
+	}
+	if (!isModified)
+		return;
+
+	// Row major sparse times dense, multithreaded by Eigen
+	auto& V = *state->V;
+	V = data->VRest;
+	V.noalias() += data->M * data->T;
+
+	state->DirtyState |= DirtyFlag::VDirty;
+	state->Native->ExtendDirtyV(0, state->VSize);
+}
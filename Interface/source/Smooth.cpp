@@ -0,0 +1,226 @@
+#include "Native.h"
+#include "Storage.h"
+#include "Trace.h"
+#include "Util.h"
+
+using SmoothData = MeshStateNative::SmoothData;
+
+/**
+ * @param rows Rows of a matrix A of the interior vertices
+ * @return The submatrix <code>A_II</code> of the interior rows and columns
+ */
+template<typename Scalar>
+static Eigen::SparseMatrix<Scalar> InteriorSubmatrix(const Eigen::SparseMatrix<Scalar, Eigen::RowMajor>& rows,
+                                                     const Eigen::VectorXi& interior, int VSize)
+{
+	std::vector<int> local(VSize, -1);
+	for (int r = 0; r < interior.size(); ++r)
+		local[interior(r)] = r;
+
+	std::vector<Eigen::Triplet<Scalar>> triplets;
+	triplets.reserve(rows.nonZeros());
+	for (int r = 0; r < rows.outerSize(); ++r)
+		for (typename Eigen::SparseMatrix<Scalar, Eigen::RowMajor>::InnerIterator it(rows, r); it; ++it)
+			if (local[it.col()] >= 0)
+				triplets.emplace_back(r, local[it.col()], it.value());
+
+	Eigen::SparseMatrix<Scalar> A(interior.size(), interior.size());
+	A.setFromTriplets(triplets.begin(), triplets.end());
+	return A;
+}
+
+/**
+ * Recalculate the SmoothData if the selected vertices have changed, the factorizations are then reset.
+ * @return The smooth data, or nullptr if no vertices are selected
+ */
+static SmoothData* UpdateSmoothData(MeshState* state, unsigned int maskId)
+{
+	auto*& data = state->Native->Smooth;
+	if (data == nullptr)
+		data = new SmoothData();
+
+	std::vector<int> interior;
+	VisitS(state, [&](const auto& S) {
+		for (int i = 0; i < state->VSize; ++i)
+			if ((S(i) & maskId) > 0)
+				interior.push_back(i);
+	});
+	if (interior.empty())
+		return nullptr;
+
+	if (data->Interior.size() == (int) interior.size() &&
+	    std::equal(interior.begin(), interior.end(), data->Interior.data()))
+		return data;
+
+	const int n = interior.size();
+	data->Interior = Eigen::Map<Eigen::VectorXi>(interior.data(), n);
+
+	// The Laplacian is symmetric, so its rows are the columns of the column major matrix which we copy directly
+	const auto& L = state->Native->Laplacian;
+	auto& LI = data->L;
+	LI.resize(n, state->VSize);
+	LI.outerIndexPtr()[0] = 0;
+	for (int r = 0; r < n; ++r)
+		LI.outerIndexPtr()[r + 1] = LI.outerIndexPtr()[r] + L.innerVector(interior[r]).nonZeros();
+	LI.resizeNonZeros(LI.outerIndexPtr()[n]);
+	data->D.setZero(n);
+
+#pragma omp parallel for num_threads(GetWorkerThreads())
+	for (int r = 0; r < n; ++r)
+	{
+		int k = LI.outerIndexPtr()[r];
+		for (Eigen::SparseMatrix<float>::InnerIterator it(L, interior[r]); it; ++it, ++k)
+		{
+			LI.innerIndexPtr()[k] = it.row();
+			LI.valuePtr()[k] = it.value();
+			if (it.row() == interior[r])
+				data->D(r) = -it.value();
+		}
+	}
+
+	data->LII = InteriorSubmatrix(LI, data->Interior, state->VSize);
+	data->HasImplicit = false;
+	data->HasFair = false;
+	return data;
+}
+
+/**
+ * @return The rows of V of the interior, dimensions Interior.size() x 3
+ */
+static Eigen::MatrixXf SliceInterior(const Eigen::MatrixXf& V, const Eigen::VectorXi& interior)
+{
+	Eigen::MatrixXf VI(interior.size(), 3);
+#pragma omp parallel for num_threads(GetWorkerThreads())
+	for (int r = 0; r < interior.size(); ++r)
+		VI.row(r) = V.row(interior(r));
+	return VI;
+}
+
+/**
+ * Solve for the three coordinates in parallel and write the result into the interior rows of V
+ */
+template<typename Scalar>
+static void SolveInterior(MeshState* state, const Eigen::SimplicialLDLT<Eigen::SparseMatrix<Scalar>>& solver,
+                          const Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>& rhs,
+                          const Eigen::VectorXi& interior)
+{
+	Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic> VI(rhs.rows(), 3);
+#pragma omp parallel for num_threads(GetWorkerThreads())
+	for (int c = 0; c < 3; ++c)
+		VI.col(c) = solver.solve(rhs.col(c));
+
+	auto& V = *state->V;
+	for (int r = 0; r < interior.size(); ++r)
+		V.row(interior(r)) = VI.row(r).template cast<float>();
+}
+
+/**
+ * Mark the interior as modified
+ */
+static void SetInteriorDirty(MeshState* state, const Eigen::VectorXi& interior)
+{
+	state->DirtyState |= DirtyFlag::VDirty;
+	state->Native->ExtendDirtyV(interior.minCoeff(), interior.maxCoeff() + 1);
+}
+
+void SmoothSelection(MeshState* state, unsigned int maskId, float lambda, int iterations)
+{
+	TraceScope trace(state, BatchOp::SmoothSelection, [&](BatchCommand& cmd) {
+		cmd.MaskId = maskId;
+		cmd.Lambda = lambda;
+		cmd.Iterations = iterations;
+	});
+	state->EnsureInitialized();
+
+	SmoothData* data = UpdateSmoothData(state, maskId);
+	if (data == nullptr || iterations <= 0)
+		return;
+
+	// Move each vertex towards the cotangent weighted mean of its neighbors: v += lambda * D^-1 L v
+	auto& V = *state->V;
+	const auto& interior = data->Interior;
+	const Eigen::VectorXf step = data->D.unaryExpr([&](float d) -> float { return d > 0.f ? lambda / d : 0.f; });
+	for (int i = 0; i < iterations; ++i)
+	{
+		const Eigen::MatrixXf LV = data->L * V;
+#pragma omp parallel for num_threads(GetWorkerThreads())
+		for (int r = 0; r < interior.size(); ++r)
+			V.row(interior(r)) += step(r) * LV.row(r);
+	}
+
+	SetInteriorDirty(state, interior);
+}
+
+void SmoothSelectionImplicit(MeshState* state, unsigned int maskId, float lambda)
+{
+	TraceScope trace(state, BatchOp::SmoothSelectionImplicit, [&](BatchCommand& cmd) {
+		cmd.MaskId = maskId;
+		cmd.Lambda = lambda;
+	});
+	state->EnsureInitialized();
+
+	// A negative lambda makes the system indefinite, zero does not move the vertices
+	SmoothData* data = UpdateSmoothData(state, maskId);
+	if (data == nullptr || lambda <= 0.f)
+		return;
+
+	const auto& interior = data->Interior;
+	const auto& LII = data->LII;
+	if (!data->HasImplicit || data->ImplicitLambda != lambda)
+	{
+		// Backward Euler step (D - lambda L_II) v_I = D v_I + lambda L_IB v_B, symmetric positive definite
+		Eigen::SparseMatrix<float> A = -lambda * LII;
+		A.diagonal() += data->D;
+		data->Implicit.compute(A);
+		if (data->Implicit.info() != Eigen::Success)
+		{
+			LOGERR("SmoothSelectionImplicit: Factorization failed.")
+			data->HasImplicit = false;
+			return;
+		}
+		data->ImplicitLambda = lambda;
+		data->HasImplicit = true;
+	}
+
+	const Eigen::MatrixXf VI = SliceInterior(*state->V, interior);
+	const Eigen::MatrixXf rhs = data->D.asDiagonal() * VI + lambda * (data->L * *state->V - LII * VI);
+	SolveInterior<float>(state, data->Implicit, rhs, interior);
+	SetInteriorDirty(state, interior);
+}
+
+void FairSelection(MeshState* state, unsigned int maskId)
+{
+	TraceScope trace(state, BatchOp::FairSelection, [&](BatchCommand& cmd) {
+		cmd.MaskId = maskId;
+	});
+	state->EnsureInitialized();
+
+	SmoothData* data = UpdateSmoothData(state, maskId);
+	if (data == nullptr)
+		return;
+
+	const auto& interior = data->Interior;
+	if (!data->HasFair)
+	{
+		// Bilaplacian K = L D^-1 L, with the lumped weights D as the mass matrix
+		const Eigen::SparseMatrix<double> L = state->Native->Laplacian.cast<double>();
+		Eigen::VectorXd DInv = -L.diagonal();
+		DInv = DInv.unaryExpr([](double d) -> double { return d > 0. ? 1. / d : 1.; });
+		data->K = (data->L.cast<double>() * DInv.asDiagonal()) * L;
+
+		data->KII = InteriorSubmatrix(data->K, interior, state->VSize);
+		data->Fair.compute(data->KII);
+		if (data->Fair.info() != Eigen::Success)
+		{
+			LOGERR("FairSelection: Factorization failed, the selection must not contain a whole component.")
+			return;
+		}
+		data->HasFair = true;
+	}
+
+	// K_II v_I = -K_IB v_B, where K_IB v_B = K_I v - K_II v_I
+	const Eigen::MatrixXd VI = SliceInterior(*state->V, interior).cast<double>();
+	const Eigen::MatrixXd KV = data->K * state->V->cast<double>();
+	SolveInterior<double>(state, data->Fair, data->KII * VI - KV, interior);
+	SetInteriorDirty(state, interior);
+}
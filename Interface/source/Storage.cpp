@@ -0,0 +1,120 @@
+#include "Native.h"
+#include "Storage.h"
+#include "Trace.h"
+
+/**
+ * @return Bits per vertex required to store <code>selectionCount</code> selections
+ */
+static int GetSWidth(unsigned int selectionCount)
+{
+	return selectionCount <= 8 ? 8 : selectionCount <= 16 ? 16 : 32;
+}
+
+/**
+ * Repack the selection vector to <code>width</code> bits per vertex, frees the previous one.
+ * All selections used must fit into the new width.
+ */
+static void SetSWidth(MeshState* state, int width)
+{
+	auto* native = state->Native;
+	if (width == native->SWidth)
+		return;
+
+	Eigen::VectorXi S32;
+	VisitS(state, [&](const auto& S) { S32 = S.template cast<int>(); });
+
+	native->S8.resize(0);
+	native->S16.resize(0);
+	state->S->resize(0);
+
+	native->SWidth = width;
+	VisitS(state, [&](auto& S) {
+		using Scalar = typename std::decay<decltype(S)>::type::Scalar;
+		S = S32.cast<Scalar>();
+	});
+}
+
+void EnsureSWidth(MeshState* state, unsigned int selectionCount)
+{
+	if (!state->Native->CompactStorage)
+		return;
+
+	const int width = GetSWidth(selectionCount);
+	if (width > state->Native->SWidth)
+		SetSWidth(state, width);
+}
+
+/**
+ * @return Bytes used by the selection sets and their summary
+ */
+static size_t GetSelectionSetBytes(const SelectionSetStore& store)
+{
+	size_t bytes = sizeof(uint64_t) * store.Summary.size();
+	for (const auto& set : store.Sets)
+		bytes += sizeof(int) * set.Indices.size();
+	return bytes;
+}
+
+size_t GetAttributeBytes(const MeshState* state)
+{
+	const auto* native = state->Native;
+	size_t attributeBytes = 0;
+	for (const auto& channel : native->Attributes.Channels)
+		attributeBytes += channel.Data.size();
+
+	return sizeof(float) * (state->V->size() + state->N->size() + state->C->size() + state->UV->size() +
+	                        native->V0->size()) +
+	       sizeof(int) * (state->F->size() + state->S->size() + native->Mirror.size() +
+	                      native->VertexOrder.size() + native->FaceOrder.size()) +
+	       sizeof(unsigned char) * (native->C8.size() + native->S8.size()) +
+	       sizeof(unsigned short) * native->S16.size() +
+	       sizeof(Eigen::half) * native->UV16.size() +
+	       GetSelectionSetBytes(native->SelectionSets) + attributeBytes;
+}
+
+void SetCompactStorage(MeshState* state, bool compact)
+{
+	TraceScope trace(state, BatchOp::SetCompactStorage, [&](BatchCommand& cmd) {
+		cmd.Flags = compact ? BatchFlag::CompactStorage : BatchFlag::None;
+	});
+	state->EnsureInitialized();
+
+	auto* native = state->Native;
+	if (native->CompactStorage == compact)
+		return;
+
+	if (compact)
+	{
+		native->C8 = (state->C->array().max(0.f).min(1.f) * 255.f + 0.5f).cast<unsigned char>();
+		state->C->resize(0, 4);
+		native->UV16 = state->UV->cast<Eigen::half>();
+		state->UV->resize(0, 2);
+
+		// Use the smallest width fitting all selections in use, including those with vertices beyond SSize
+		unsigned int selectionCount = state->SSize;
+		const unsigned int usedMask = state->S->redux([](int a, int b) -> int { return a | b; });
+		while (selectionCount < 32 && (usedMask >> selectionCount) > 0)
+			selectionCount++;
+
+		native->CompactStorage = true;
+		SetSWidth(state, GetSWidth(selectionCount));
+	}
+	else
+	{
+		*state->C = native->C8.cast<float>() / 255.f;
+		native->C8.resize(0, 4);
+		*state->UV = native->UV16.cast<float>();
+		native->UV16.resize(0, 2);
+
+		SetSWidth(state, 32);
+		native->CompactStorage = false;
+	}
+
+	LOG("SetCompactStorage(" << compact << "): " << GetAttributeBytes(state) / 1024 << " KiB")
+}
+
+unsigned long long GetMeshMemoryUsage(MeshState* state)
+{
+	state->EnsureInitialized();
+	return GetAttributeBytes(state);
+}
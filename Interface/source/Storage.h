@@ -0,0 +1,45 @@
+#pragma once
+#include "MeshState.h"
+#include "Util.h"
+
+/**
+ * Call <code>fn</code> with the selection vector in its current width (<code>S8</code>, <code>S16</code> or
+ * <code>S</code>), see MeshStateNative::SWidth. This dispatches once per call so <code>fn</code> should contain the
+ * whole loop, use a generic lambda so the kernel is compiled for each width.
+ * <example><code>VisitS(state, [&](auto& S) { S.setZero(); });</code></example>
+ */
+template<typename Fn>
+void VisitS(MeshState* state, Fn&& fn)
+{
+	switch (state->Native->SWidth)
+	{
+		case 8:
+			fn(state->Native->S8);
+			break;
+		case 16:
+			fn(state->Native->S16);
+			break;
+		default:
+			fn(*state->S);
+			break;
+	}
+}
+
+/**
+ * Ensures the selection vector can store at least <code>selectionCount</code> selections,
+ * widens the packed selection vector if required. Does nothing if compact storage is disabled.
+ */
+void EnsureSWidth(MeshState* state, unsigned int selectionCount);
+
+/**
+ * @return Bytes used by the vertex/face attributes of the mesh, including V0 and the compact storage
+ */
+size_t GetAttributeBytes(const MeshState* state);
+
+/**
+ * Convert an RGBA color to 8 bits per channel, clamps to [0, 1]
+ */
+inline Eigen::Matrix<unsigned char, 1, 4> ToRGBA8(const Color_t& color)
+{
+	return (color.array().max(0.f).min(1.f) * 255.f + 0.5f).cast<unsigned char>();
+}
@@ -0,0 +1,491 @@
+#include "Native.h"
+#include "Streaming.h"
+#include "SelectionKernels.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+using RowMatrix3f = Eigen::Matrix<float, Eigen::Dynamic, 3, Eigen::RowMajor>;
+using RowMatrix3i = Eigen::Matrix<int, Eigen::Dynamic, 3, Eigen::RowMajor>;
+using VectorXu = Eigen::Matrix<unsigned int, Eigen::Dynamic, 1>;
+
+/** Bytes of a vertex in a slot: V and S resident, V, N, C and UV in the Unity mesh data */
+static const size_t SlotVertexBytes = 4 * sizeof(float) + 12 * sizeof(float);
+/** Bytes of a face in a slot, in the Unity mesh data */
+static const size_t SlotFaceBytes = 3 * sizeof(int);
+
+/**
+ * @return Offsets in bytes of V, S and F in the file
+ */
+static std::array<size_t, 3> GetOffsets(const StreamingHeader& header)
+{
+	const size_t V = sizeof(StreamingHeader) + sizeof(StreamingChunk) * header.ChunkCount;
+	const size_t S = V + sizeof(float) * 3 * header.VSize;
+	const size_t F = S + sizeof(unsigned int) * header.VSize;
+	return {V, S, F};
+}
+
+/**
+ * Spread the lower 10 bits of x, so there are two zero bits between each of them
+ */
+static unsigned int SpreadBits(unsigned int x)
+{
+	x &= 0x3ff;
+	x = (x | (x << 16)) & 0x30000ff;
+	x = (x | (x << 8)) & 0x300f00f;
+	x = (x | (x << 4)) & 0x30c30c3;
+	x = (x | (x << 2)) & 0x9249249;
+	return x;
+}
+
+/**
+ * @return True if the chunks cover the vertices and faces contiguously and in order, each within the chunk sizes,
+ * and all faces index existing vertices
+ */
+static bool IsValid(const StreamingHeader& header, const StreamingChunk* chunks, const int* F)
+{
+	// A slot has at least one vertex, so the slot size is not zero. A mesh without faces has no faces per chunk.
+	if (header.ChunkVSize <= 0 || header.ChunkFSize < 0 || (header.ChunkFSize == 0 && header.FSize > 0))
+		return false;
+
+	int VEnd = 0, FEnd = 0;
+	for (int k = 0; k < header.ChunkCount; ++k)
+	{
+		const StreamingChunk& c = chunks[k];
+		if (c.VBegin != VEnd || c.VSize <= 0 || c.VSize > header.ChunkVSize || c.VSize > header.VSize - VEnd ||
+		    c.FBegin != FEnd || c.FSize < 0 || c.FSize > header.ChunkFSize || c.FSize > header.FSize - FEnd)
+			return false;
+		VEnd += c.VSize;
+		FEnd += c.FSize;
+	}
+	if (VEnd != header.VSize || FEnd != header.FSize)
+		return false;
+
+	const size_t indexCount = 3 * (size_t) header.FSize;
+	return std::all_of(F, F + indexCount, [&](int i) { return i >= 0 && i < header.VSize; });
+}
+
+// --- StreamingMesh
+StreamingMesh::StreamingMesh(const char* path, size_t memoryBudget) : File(path, true)
+{
+	if (File.Data == nullptr || File.Size < sizeof(StreamingHeader))
+		return;
+
+	const auto* header = reinterpret_cast<const StreamingHeader*>(File.Data);
+	const StreamingHeader expected{};
+	if (std::memcmp(header->Magic, expected.Magic, sizeof(header->Magic)) != 0 || header->Version != expected.Version ||
+	    header->ChunkCount <= 0 || header->VSize <= 0 || header->FSize < 0)
+		return;
+	const auto offsets = GetOffsets(*header);
+	if (File.Size != offsets[2] + sizeof(int) * 3 * header->FSize)
+		return;
+	const auto* chunks = reinterpret_cast<const StreamingChunk*>(File.Data + sizeof(StreamingHeader));
+	if (!IsValid(*header, chunks, reinterpret_cast<const int*>(File.Data + offsets[2])))
+		return;
+
+	Header = header;
+	Chunks = reinterpret_cast<StreamingChunk*>(File.Data + sizeof(StreamingHeader));
+	V = reinterpret_cast<float*>(File.Data + offsets[0]);
+	S = reinterpret_cast<unsigned int*>(File.Data + offsets[1]);
+	F = reinterpret_cast<const int*>(File.Data + offsets[2]);
+
+	const size_t slotBytes = SlotVertexBytes * Header->ChunkVSize + SlotFaceBytes * Header->ChunkFSize;
+	const size_t slotCount = std::max<size_t>(1, memoryBudget / slotBytes);
+	Slots.resize(std::min<size_t>(slotCount, Header->ChunkCount));
+	SlotOfChunk.assign(Header->ChunkCount, -1);
+}
+
+int StreamingMesh::ChunkOfVertex(int i) const
+{
+	const StreamingChunk* begin = Chunks;
+	const StreamingChunk* chunk = std::upper_bound(begin, begin + Header->ChunkCount, i, [](int vertex, const StreamingChunk& c) -> bool {
+		return vertex < c.VBegin;
+	});
+	return chunk - Chunks - 1;
+}
+
+void StreamingMesh::Load(int chunk, int slot)
+{
+	const StreamingChunk& c = Chunks[chunk];
+	Slot& s = Slots[slot];
+	s.Chunk = chunk;
+	s.V = Eigen::Map<const RowMatrix3f>(V + 3 * c.VBegin, c.VSize, 3);
+	s.S = Eigen::Map<const VectorXu>(S + c.VBegin, c.VSize).cast<int>();
+	s.Modified = false;
+	s.DirtyState |= DirtyFlag::VDirty | DirtyFlag::CDirty | DirtyFlag::FDirty;
+	SlotOfChunk[chunk] = slot;
+}
+
+void StreamingMesh::Evict(int slot)
+{
+	Slot& s = Slots[slot];
+	if (s.Chunk < 0)
+		return;
+
+	if (s.Modified)
+	{
+		const StreamingChunk& c = Chunks[s.Chunk];
+		Eigen::Map<RowMatrix3f>(V + 3 * c.VBegin, c.VSize, 3) = s.V;
+		Eigen::Map<VectorXu>(S + c.VBegin, c.VSize) = s.S.cast<unsigned int>();
+	}
+
+	SlotOfChunk[s.Chunk] = -1;
+	s.Chunk = -1;
+	s.V.resize(0, 3);
+	s.S.resize(0);
+	s.DirtyState |= DirtyFlag::FDirty;
+}
+
+// --- Slots of the Unity mesh data
+/**
+ * Write the vertices of a slot, the unused vertices of the slot are set to its first vertex to keep the bounds tight
+ */
+static void WriteSlotV(const StreamingMesh* mesh, int slot, const UMeshDataNative& data)
+{
+	const auto& s = mesh->Slots[slot];
+	const int ChunkVSize = mesh->Header->ChunkVSize;
+	Eigen::Map<RowMatrix3f> V(data.VPtr + 3 * slot * ChunkVSize, ChunkVSize, 3);
+	V.topRows(s.V.rows()) = s.V;
+	V.bottomRows(ChunkVSize - s.V.rows()) = s.V.row(0).replicate(ChunkVSize - s.V.rows(), 1);
+}
+
+/**
+ * Color the vertices of a slot by their visible selections, as SetColorByMask
+ */
+static void WriteSlotC(const StreamingMesh* mesh, int slot, const UMeshDataNative& data, unsigned int visibleMask)
+{
+	const auto& s = mesh->Slots[slot];
+	Eigen::Map<Eigen::Matrix<float, Eigen::Dynamic, 4, Eigen::RowMajor>>
+			C(data.CPtr + 4 * slot * mesh->Header->ChunkVSize, s.S.rows(), 4);
+	for (int i = 0; i < s.S.rows(); ++i)
+	{
+		const unsigned int m = static_cast<unsigned int>(s.S(i)) & visibleMask;
+		if (m == 0)
+		{
+			C.row(i) = Color::Gray;
+			continue;
+		}
+		C.row(i).setZero();
+		for (unsigned int selectionId = 0, b = m; b > 0; ++selectionId, b >>= 1)
+			if ((b & 1u) > 0)
+				C.row(i) += Color::GetColorById(selectionId);
+	}
+}
+
+/**
+ * Write the faces of a slot with the indices of the Unity mesh data.
+ * Faces with a vertex that is not resident and the unused faces of the slot are degenerate.
+ */
+static void WriteSlotF(const StreamingMesh* mesh, int slot, const UMeshDataNative& data)
+{
+	const auto& s = mesh->Slots[slot];
+	const int ChunkVSize = mesh->Header->ChunkVSize;
+	const int ChunkFSize = mesh->Header->ChunkFSize;
+	const int degenerate = slot * ChunkVSize;
+	int* F = data.FPtr + 3 * slot * ChunkFSize;
+
+	int f = 0;
+	if (s.Chunk >= 0)
+	{
+		const StreamingChunk& chunk = mesh->Chunks[s.Chunk];
+		const int* faces = mesh->F + 3 * chunk.FBegin;
+		for (; f < chunk.FSize; ++f)
+		{
+			int face[3];
+			bool resident = true;
+			for (int k = 0; k < 3 && resident; ++k)
+			{
+				const int i = faces[3 * f + k];
+				// Most vertices of a face are in the chunk of the face
+				const int c = i >= chunk.VBegin && i < chunk.VBegin + chunk.VSize ? s.Chunk : mesh->ChunkOfVertex(i);
+				const int other = mesh->SlotOfChunk[c];
+				resident = other >= 0;
+				face[k] = other * ChunkVSize + i - mesh->Chunks[c].VBegin;
+			}
+			for (int k = 0; k < 3; ++k)
+				F[3 * f + k] = resident ? face[k] : degenerate;
+		}
+	}
+	std::fill(F + 3 * f, F + 3 * ChunkFSize, degenerate);
+}
+
+/**
+ * Update the bounding box of the resident chunk in the file, after its vertices have moved
+ */
+static void UpdateBounds(StreamingMesh* mesh, int slot)
+{
+	const auto& s = mesh->Slots[slot];
+	StreamingChunk& chunk = mesh->Chunks[s.Chunk];
+	Eigen::Map<Eigen::RowVector3f>(chunk.Min) = s.V.colwise().minCoeff();
+	Eigen::Map<Eigen::RowVector3f>(chunk.Max) = s.V.colwise().maxCoeff();
+}
+
+// --- Exports
+bool SaveStreamingMesh(MeshState* state, const char* path, int chunkVertices)
+{
+	state->EnsureInitialized();
+	if (chunkVertices <= 0)
+	{
+		LOGERR("SaveStreamingMesh: Invalid chunk size " << chunkVertices)
+		return false;
+	}
+
+	const auto& V = *state->V;
+	const auto& F = *state->F;
+	const int VSize = state->VSize;
+	const int FSize = state->FSize;
+
+	// Sort the vertices along a Morton curve of the bounding box, so consecutive vertices are spatially close
+	const Eigen::RowVector3f min = V.colwise().minCoeff();
+	const Eigen::RowVector3f size = V.colwise().maxCoeff() - min;
+	const Eigen::RowVector3f scale = (1023.f / size.array().max(1e-12f)).matrix();
+	std::vector<std::pair<unsigned int, int>> codes(VSize);
+#pragma omp parallel for num_threads(GetWorkerThreads())
+	for (int i = 0; i < VSize; ++i)
+	{
+		const Eigen::RowVector3f p = (V.row(i) - min).cwiseProduct(scale);
+		codes[i] = {SpreadBits((unsigned int) p(0)) | SpreadBits((unsigned int) p(1)) << 1 |
+		            SpreadBits((unsigned int) p(2)) << 2, i};
+	}
+	std::sort(codes.begin(), codes.end());
+
+	std::vector<int> newIndex(VSize);
+	for (int i = 0; i < VSize; ++i)
+		newIndex[codes[i].second] = i;
+
+	StreamingHeader header;
+	header.VSize = VSize;
+	header.FSize = FSize;
+	header.ChunkCount = (VSize + chunkVertices - 1) / chunkVertices;
+	header.ChunkVSize = std::min(chunkVertices, VSize);
+
+	// Faces belong to the chunk of their first vertex, sort them by chunk
+	std::vector<StreamingChunk> chunks(header.ChunkCount);
+	std::vector<int> faceStart(header.ChunkCount + 1, 0);
+	for (int f = 0; f < FSize; ++f)
+		faceStart[newIndex[F(f, 0)] / chunkVertices + 1]++;
+	for (int c = 0; c < header.ChunkCount; ++c)
+		faceStart[c + 1] += faceStart[c];
+	RowMatrix3i FOut(FSize, 3);
+	{
+		std::vector<int> next(faceStart.begin(), faceStart.end() - 1);
+		for (int f = 0; f < FSize; ++f)
+		{
+			const int row = next[newIndex[F(f, 0)] / chunkVertices]++;
+			for (int k = 0; k < 3; ++k)
+				FOut(row, k) = newIndex[F(f, k)];
+		}
+	}
+
+	RowMatrix3f VOut(VSize, 3);
+	VectorXu SOut(VSize);
+	VisitS(state, [&](const auto& S) {
+		for (int i = 0; i < VSize; ++i)
+		{
+			VOut.row(i) = V.row(codes[i].second);
+			SOut(i) = static_cast<unsigned int>(S(codes[i].second));
+		}
+	});
+
+	header.ChunkFSize = 0;
+	for (int c = 0; c < header.ChunkCount; ++c)
+	{
+		auto& chunk = chunks[c];
+		chunk.VBegin = c * chunkVertices;
+		chunk.VSize = std::min(chunkVertices, VSize - chunk.VBegin);
+		chunk.FBegin = faceStart[c];
+		chunk.FSize = faceStart[c + 1] - faceStart[c];
+		Eigen::Map<Eigen::RowVector3f>(chunk.Min) = VOut.middleRows(chunk.VBegin, chunk.VSize).colwise().minCoeff();
+		Eigen::Map<Eigen::RowVector3f>(chunk.Max) = VOut.middleRows(chunk.VBegin, chunk.VSize).colwise().maxCoeff();
+		header.ChunkFSize = std::max(header.ChunkFSize, chunk.FSize);
+	}
+
+	std::ofstream out(path, std::ios::binary | std::ios::trunc);
+	if (!out.is_open())
+	{
+		LOGERR("SaveStreamingMesh: Could not open " << path)
+		return false;
+	}
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out.write(reinterpret_cast<const char*>(chunks.data()), sizeof(StreamingChunk) * chunks.size());
+	out.write(reinterpret_cast<const char*>(VOut.data()), sizeof(float) * VOut.size());
+	out.write(reinterpret_cast<const char*>(SOut.data()), sizeof(unsigned int) * SOut.size());
+	out.write(reinterpret_cast<const char*>(FOut.data()), sizeof(int) * FOut.size());
+	if (!out.good())
+	{
+		LOGERR("SaveStreamingMesh: Could not write " << path)
+		return false;
+	}
+
+	LOG("SaveStreamingMesh: " << header.ChunkCount << " chunks with up to " << header.ChunkVSize << " vertices and "
+	    << header.ChunkFSize << " faces to " << path)
+	return true;
+}
+
+StreamingMesh* OpenStreamingMesh(const char* path, unsigned long long memoryBudget, int& VSize, int& FSize)
+{
+	auto* mesh = new StreamingMesh(path, memoryBudget);
+	if (mesh->Header == nullptr)
+	{
+		LOGERR("OpenStreamingMesh: Could not open " << path << ", it is not a streaming mesh or is corrupt")
+		delete mesh;
+		VSize = FSize = 0;
+		return nullptr;
+	}
+
+	const int slotCount = mesh->Slots.size();
+	VSize = slotCount * mesh->Header->ChunkVSize;
+	FSize = slotCount * mesh->Header->ChunkFSize;
+	LOG("OpenStreamingMesh: " << slotCount << " of " << mesh->Header->ChunkCount << " chunks resident, "
+	    << mesh->Header->VSize << " vertices in total")
+	return mesh;
+}
+
+void CloseStreamingMesh(StreamingMesh* mesh)
+{
+	if (mesh == nullptr)
+		return;
+
+	for (int slot = 0; slot < (int) mesh->Slots.size(); ++slot)
+		mesh->Evict(slot);
+	if (!mesh->File.Flush())
+		LOGERR("CloseStreamingMesh: Could not write the modified chunks to the file")
+	delete mesh;
+}
+
+int UpdateStreaming(StreamingMesh* mesh, Vector3 brush, float brushRadius, Vector3 view, float viewRadius)
+{
+	const auto updates = ++mesh->Updates;
+	const SpherePrimitive brushSphere(brush, brushRadius);
+	const SpherePrimitive viewSphere(view, viewRadius);
+	const Eigen::Vector3f brushEigen = brush.AsEigen();
+	const Eigen::Vector3f viewEigen = view.AsEigen();
+
+	// Chunks around the brush first, then those in the view, the nearest first
+	std::vector<std::pair<float, int>> needed;
+	for (int c = 0; c < mesh->Header->ChunkCount; ++c)
+	{
+		const StreamingChunk& chunk = mesh->Chunks[c];
+		const Eigen::Vector3f center = (Eigen::Vector3f(chunk.Min) + Eigen::Vector3f(chunk.Max)) / 2.f;
+		if (brushSphere.IntersectsBox(chunk.Min, chunk.Max))
+			needed.emplace_back((center - brushEigen).norm(), c);
+		else if (viewSphere.IntersectsBox(chunk.Min, chunk.Max))
+			needed.emplace_back(brushRadius + viewRadius + (center - viewEigen).norm(), c);
+	}
+	std::sort(needed.begin(), needed.end());
+	if (needed.size() > mesh->Slots.size())
+		needed.resize(mesh->Slots.size());
+
+	for (const auto& n : needed)
+		if (mesh->SlotOfChunk[n.second] >= 0)
+			mesh->Slots[mesh->SlotOfChunk[n.second]].LastUsed = updates;
+
+	// Load the missing chunks into free slots or evict the least recently used chunks that are not needed
+	int loaded = 0;
+	for (const auto& n : needed)
+	{
+		const int chunk = n.second;
+		if (mesh->SlotOfChunk[chunk] >= 0)
+			continue;
+
+		int slot = 0;
+		for (int s = 1; s < (int) mesh->Slots.size(); ++s)
+			if (mesh->Slots[s].Chunk < 0 ||
+			    (mesh->Slots[slot].Chunk >= 0 && mesh->Slots[s].LastUsed < mesh->Slots[slot].LastUsed))
+				slot = s;
+
+		mesh->Evict(slot);
+		mesh->Load(chunk, slot);
+		mesh->Slots[slot].LastUsed = updates;
+		loaded++;
+	}
+
+	// Faces across chunks may have become (non-)degenerate
+	if (loaded > 0)
+		for (auto& s : mesh->Slots)
+			s.DirtyState |= DirtyFlag::FDirty;
+	return loaded;
+}
+
+void StreamingSelectSphere(StreamingMesh* mesh, Vector3 position, float radius, int selectionId,
+                           unsigned int selectionMode)
+{
+	if (selectionId < 0 || selectionId >= 32)
+	{
+		LOGERR("StreamingSelectSphere: Only the 32 selections are streamed, not " << selectionId)
+		return;
+	}
+
+	const SpherePrimitive sphere(position, radius);
+	for (auto& s : mesh->Slots)
+	{
+		if (s.Chunk < 0 || !sphere.IntersectsBox(mesh->Chunks[s.Chunk].Min, mesh->Chunks[s.Chunk].Max))
+			continue;
+
+		if (!SelectInside(s.V, sphere, selectionId, selectionMode, s.S))
+		{
+			LOGERR("StreamingSelectSphere: Invalid selection mode " << selectionMode)
+			return;
+		}
+		s.Modified = true;
+		s.DirtyState |= DirtyFlag::CDirty;
+	}
+}
+
+void StreamingTranslateSelection(StreamingMesh* mesh, Vector3 translation, int selectionId)
+{
+	if (selectionId < 0 || selectionId >= 32)
+	{
+		LOGERR("StreamingTranslateSelection: Only the 32 selections are streamed, not " << selectionId)
+		return;
+	}
+
+	const Eigen::RowVector3f t = translation.AsEigenRow();
+	const unsigned int maskId = 1u << selectionId;
+	const int slotCount = mesh->Slots.size();
+#pragma omp parallel for schedule(dynamic) num_threads(GetWorkerThreads())
+	for (int slot = 0; slot < slotCount; ++slot)
+	{
+		auto& s = mesh->Slots[slot];
+		if (s.Chunk < 0)
+			continue;
+
+		bool moved = false;
+		for (int i = 0; i < s.V.rows(); ++i)
+			if ((static_cast<unsigned int>(s.S(i)) & maskId) > 0)
+			{
+				s.V.row(i) += t;
+				moved = true;
+			}
+
+		if (moved)
+		{
+			UpdateBounds(mesh, slot);
+			s.Modified = true;
+			s.DirtyState |= DirtyFlag::VDirty;
+		}
+	}
+}
+
+unsigned int StreamingApplyDirty(StreamingMesh* mesh, const UMeshDataNative data, unsigned int visibleSelectionMask)
+{
+	unsigned int dirtyState = DirtyFlag::None;
+	const int slotCount = mesh->Slots.size();
+#pragma omp parallel for schedule(dynamic) num_threads(GetWorkerThreads()) reduction(|:dirtyState)
+	for (int slot = 0; slot < slotCount; ++slot)
+	{
+		auto& s = mesh->Slots[slot];
+		if (s.Chunk >= 0 && (s.DirtyState & DirtyFlag::VDirty) > 0)
+			WriteSlotV(mesh, slot, data);
+		if (s.Chunk >= 0 && (s.DirtyState & DirtyFlag::CDirty) > 0)
+			WriteSlotC(mesh, slot, data, visibleSelectionMask);
+		if ((s.DirtyState & DirtyFlag::FDirty) > 0)
+			WriteSlotF(mesh, slot, data);
+
+		dirtyState |= s.DirtyState;
+		s.DirtyState = DirtyFlag::None;
+	}
+	return dirtyState;
+}
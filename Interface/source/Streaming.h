@@ -0,0 +1,109 @@
+#pragma once
+#include "InterfaceTypes.h"
+#include "MappedFile.h"
+#include <vector>
+
+/**
+ * File of a streaming mesh, see SaveStreamingMesh. Layout of the file:
+ * <ol>
+ * <li>StreamingHeader</li>
+ * <li>ChunkCount StreamingChunk</li>
+ * <li>V: VSize x 3 floats, row major</li>
+ * <li>S: VSize unsigned ints, the selections</li>
+ * <li>F: FSize x 3 ints, row major</li>
+ * </ol>
+ * The vertices are sorted along a Morton curve and split into chunks, so a chunk is a contiguous range of spatially
+ * close vertices. The faces are sorted by the chunk of their first vertex and index the vertices of the whole mesh.
+ * The file is modified in place when modified chunks are evicted.
+ */
+struct StreamingHeader
+{
+	char Magic[4]{'L', 'S', 'T', 'R'};
+	unsigned int Version{1};
+	int VSize;
+	int FSize;
+	int ChunkCount;
+	/** Maximum number of vertices of a chunk */
+	int ChunkVSize;
+	/** Maximum number of faces of a chunk */
+	int ChunkFSize;
+};
+
+/**
+ * A range of vertices and faces in the file of a streaming mesh
+ */
+struct StreamingChunk
+{
+	/** Bounding box of the vertices, updated when resident vertices are moved */
+	float Min[3];
+	float Max[3];
+	int VBegin;
+	int VSize;
+	int FBegin;
+	int FSize;
+};
+
+/**
+ * A mesh that does not fit into the memory budget, only the chunks around the brush and view are resident.
+ * The rest stays in the memory-mapped file. The selection and transformation kernels only operate on resident chunks.<p/>
+ * Each resident chunk occupies a slot of the Unity mesh data, with ChunkVSize vertices and ChunkFSize faces,
+ * so the Unity mesh has a fixed size independent of the size of the whole mesh.
+ * Faces with a vertex in a chunk that is not resident are degenerate.
+ * @see OpenStreamingMesh
+ */
+struct StreamingMesh
+{
+	/**
+	 * A chunk that is resident in a slot
+	 */
+	struct Slot
+	{
+		/** Index of the chunk, -1 if the slot is free */
+		int Chunk{-1};
+		/** Vertices of the chunk, column major as MeshState::V */
+		Eigen::MatrixXf V;
+		/** Selections of the vertices of the chunk */
+		Eigen::VectorXi S;
+		/** Whether V or S have been modified since the chunk was loaded, they are then written back when evicted */
+		bool Modified{false};
+		/** Attributes (DirtyFlag) of the slot to write in StreamingApplyDirty */
+		unsigned int DirtyState{DirtyFlag::FDirty};
+		/** UpdateStreaming call when the chunk was last needed, the least recently used chunk is evicted first */
+		unsigned long long LastUsed{0};
+	};
+
+	MappedFile File;
+	const StreamingHeader* Header{nullptr};
+	/** Chunks and attributes in the mapped file */
+	StreamingChunk* Chunks{nullptr};
+	float* V{nullptr};
+	unsigned int* S{nullptr};
+	const int* F{nullptr};
+
+	std::vector<Slot> Slots;
+	/** Slot of each chunk, -1 if the chunk is not resident */
+	std::vector<int> SlotOfChunk;
+	/** Number of UpdateStreaming calls */
+	unsigned long long Updates{0};
+
+	/**
+	 * Map the file, check it and allocate the slots. Header is nullptr if the file is invalid.
+	 * @param memoryBudget Bytes for the resident chunks and their Unity mesh data, determines the number of slots
+	 */
+	StreamingMesh(const char* path, size_t memoryBudget);
+
+	/**
+	 * @return The chunk containing the vertex with index i in the file
+	 */
+	int ChunkOfVertex(int i) const;
+
+	/**
+	 * Copy the chunk from the file into the slot, the slot must be free
+	 */
+	void Load(int chunk, int slot);
+
+	/**
+	 * Write the chunk in the slot back to the file if it was modified, and free the slot
+	 */
+	void Evict(int slot);
+};
@@ -0,0 +1,162 @@
+#include "Symmetry.h"
+#include "Storage.h"
+#include "Trace.h"
+#include "Util.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+Eigen::Affine3f GetMirrorTransform(const MeshState* state)
+{
+	const int axis = state->Native->SymmetryAxis;
+	Eigen::Affine3f mirror = Eigen::Affine3f::Identity();
+	mirror.linear()(axis, axis) = -1.f;
+	mirror.translation()(axis) = 2.f * state->Native->SymmetryPlane;
+	return mirror;
+}
+
+void SetSymmetrySide(MeshState* state, const Vector3& brush)
+{
+	auto* native = state->Native;
+	if (native->SymmetryAxis < 0)
+		return;
+
+	const float offset = brush.AsEigen()(native->SymmetryAxis) - native->SymmetryPlane;
+	if (offset != 0.f)
+		native->SymmetrySide = offset > 0.f ? 1.f : -1.f;
+}
+
+void TransformSymmetric(MeshState* state, const Eigen::Affine3f& transform, unsigned int maskId, int& begin, int& end)
+{
+	auto* native = state->Native;
+	auto& V = *state->V;
+	const auto& V0 = *native->V0;
+	const auto& mirror = native->Mirror;
+	const int axis = native->SymmetryAxis;
+	const float plane = native->SymmetryPlane;
+	const Eigen::Affine3f reflection = GetMirrorTransform(state);
+	const Eigen::Affine3f mirrored = reflection * transform * reflection;
+
+	begin = V.rows();
+	end = 0;
+	VisitS(state, [&](const auto& S) {
+		for (int i = 0; i < V.rows(); ++i)
+		{
+			const int j = mirror(i);
+			if ((S(i) & maskId) == 0 && (j < 0 || (S(j) & maskId) == 0))
+				continue;
+
+			const Eigen::Vector3f v = V.row(i);
+			if (j == i)
+			{
+				V.row(i) = transform * v;
+				V(i, axis) = plane;
+			}
+			else if (j < 0 || (V0(i, axis) - plane) * native->SymmetrySide >= 0.f)
+				V.row(i) = transform * v;
+			else
+				V.row(i) = mirrored * v;
+			begin = std::min(begin, i);
+			end = i + 1;
+		}
+	});
+}
+
+/**
+ * Find the mirror of each vertex of V0: the nearest vertex to its reflection within the tolerance.
+ * The vertices are sorted by their cell in a uniform grid with the tolerance as the cell size,
+ * so only the vertices in the 27 cells around the reflection are compared.
+ * @return Number of vertices with a mirror
+ */
+static int ComputeMirror(MeshState* state, float tolerance)
+{
+	auto* native = state->Native;
+	const auto& V0 = *native->V0;
+	const Eigen::RowVector3f min = V0.colwise().minCoeff();
+	const Eigen::RowVector3f size = V0.colwise().maxCoeff() - min;
+	// Limit the grid to 2^20 cells per axis, so a cell key fits into 64 bits
+	const float cell = std::max({tolerance * size.norm(), size.maxCoeff() / (1 << 20), 1e-12f});
+	const float toleranceSqr = (tolerance * size.norm()) * (tolerance * size.norm());
+
+	const Eigen::Array3i dims = (size.array() / cell).cast<int>() + 1;
+	auto cellOf = [&](const Eigen::RowVector3f& v) -> Eigen::Array3i {
+		return ((v - min).array() / cell).floor().cast<int>();
+	};
+	auto keyOf = [&](const Eigen::Array3i& c) -> long long {
+		return ((long long) c(0) * dims(1) + c(1)) * dims(2) + c(2);
+	};
+
+	std::vector<std::pair<long long, int>> cells(state->VSize);
+#pragma omp parallel for num_threads(GetWorkerThreads())
+	for (int i = 0; i < state->VSize; ++i)
+		cells[i] = std::make_pair(keyOf(cellOf(V0.row(i))), i);
+	std::sort(cells.begin(), cells.end());
+
+	const Eigen::Affine3f mirror = GetMirrorTransform(state);
+	native->Mirror.resize(state->VSize);
+	int matched = 0;
+#pragma omp parallel for num_threads(GetWorkerThreads()) reduction(+ : matched)
+	for (int i = 0; i < state->VSize; ++i)
+	{
+		const Eigen::Vector3f v = V0.row(i);
+		const Eigen::RowVector3f reflection = (mirror * v).transpose();
+		const Eigen::Array3i center = cellOf(reflection);
+		int nearest = -1;
+		float nearestSqr = toleranceSqr;
+		for (int dx = -1; dx <= 1; ++dx)
+			for (int dy = -1; dy <= 1; ++dy)
+				for (int dz = -1; dz <= 1; ++dz)
+				{
+					const Eigen::Array3i c = center + Eigen::Array3i(dx, dy, dz);
+					if ((c < 0).any() || (c >= dims).any())
+						continue;
+					const long long key = keyOf(c);
+					auto it = std::lower_bound(cells.begin(), cells.end(), std::make_pair(key, -1));
+					for (; it != cells.end() && it->first == key; ++it)
+					{
+						const float distanceSqr = (V0.row(it->second) - reflection).squaredNorm();
+						if (distanceSqr <= nearestSqr)
+						{
+							nearest = it->second;
+							nearestSqr = distanceSqr;
+						}
+					}
+				}
+		native->Mirror(i) = nearest;
+		matched += nearest >= 0;
+	}
+	return matched;
+}
+
+// --- Exports
+int SetSymmetry(MeshState* state, int axis, float plane, float tolerance)
+{
+	TraceScope trace(state, BatchOp::SetSymmetry, [&](BatchCommand& cmd) {
+		cmd.Axis = axis;
+		cmd.Plane = plane;
+		cmd.Tolerance = tolerance;
+	});
+	state->EnsureInitialized();
+	auto* native = state->Native;
+
+	if (axis < 0 || axis > 2)
+	{
+		native->SymmetryAxis = -1;
+		native->Mirror.resize(0);
+		return 0;
+	}
+
+	// The mirror depends only on V0, keep it if the plane is the same
+	const bool changed = native->SymmetryAxis != axis || native->SymmetryPlane != plane ||
+	                     native->SymmetryTolerance != tolerance || native->Mirror.size() != state->VSize;
+	native->SymmetryAxis = axis;
+	native->SymmetryPlane = plane;
+	native->SymmetryTolerance = tolerance;
+	if (!changed)
+		return (native->Mirror.array() >= 0).count();
+
+	const int matched = ComputeMirror(state, tolerance);
+	LOG("Symmetry: " << matched << " of " << state->VSize << " vertices have a mirror.")
+	return matched;
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include "Native.h"
+
+/**
+ * @return The reflection across the symmetry plane of the mesh, symmetry must be enabled
+ */
+Eigen::Affine3f GetMirrorTransform(const MeshState* state);
+
+/**
+ * Remember the side of the symmetry plane the brush is on, edits are applied as given on this side
+ * and mirrored on the other. Does nothing if symmetry is disabled or the brush is on the plane.
+ */
+void SetSymmetrySide(MeshState* state, const Vector3& brush);
+
+/**
+ * Transform the selected vertices and their mirrors in one pass, symmetry must be enabled.
+ * Vertices on the side of the brush are transformed, the others by the mirrored transform
+ * and vertices on the plane stay on it.
+ * @param begin, end Range of the transformed vertices, see MeshStateNative::ExtendDirtyV
+ */
+void TransformSymmetric(MeshState* state, const Eigen::Affine3f& transform, unsigned int maskId, int& begin, int& end);
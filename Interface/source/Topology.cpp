@@ -0,0 +1,342 @@
+#include "Native.h"
+#include "Topology.h"
+#include "SelectionSets.h"
+#include "Storage.h"
+#include "Trace.h"
+#include "Util.h"
+#include <algorithm>
+
+// --- Adjacency
+void BuildVertexFaces(const Eigen::MatrixXi& F, int VSize, CsrAdjacency& VF)
+{
+	VF.Start.assign(VSize + 1, 0);
+	for (int f = 0; f < F.rows(); ++f)
+		for (int k = 0; k < 3; ++k)
+			VF.Start[F(f, k) + 1]++;
+	for (int i = 0; i < VSize; ++i)
+		VF.Start[i + 1] += VF.Start[i];
+
+	std::vector<int> next(VF.Start.begin(), VF.Start.end() - 1);
+	VF.Indices.resize(VF.Start[VSize]);
+	for (int f = 0; f < F.rows(); ++f)
+		for (int k = 0; k < 3; ++k)
+			VF.Indices[next[F(f, k)]++] = f;
+}
+
+void BuildVertexVertices(const Eigen::MatrixXi& F, int VSize, CsrAdjacency& VV)
+{
+	// Both other corners of each face of a vertex, with duplicates from the neighboring faces
+	std::vector<int> start(VSize + 1, 0);
+	for (int f = 0; f < F.rows(); ++f)
+		for (int k = 0; k < 3; ++k)
+			start[F(f, k) + 1] += 2;
+	for (int i = 0; i < VSize; ++i)
+		start[i + 1] += start[i];
+
+	std::vector<int> next(start.begin(), start.end() - 1);
+	std::vector<int> corners(start[VSize]);
+	for (int f = 0; f < F.rows(); ++f)
+		for (int k = 0; k < 3; ++k)
+		{
+			corners[next[F(f, k)]++] = F(f, (k + 1) % 3);
+			corners[next[F(f, k)]++] = F(f, (k + 2) % 3);
+		}
+
+	// Sort and remove the duplicates per vertex, then compact
+	std::vector<int> count(VSize);
+#pragma omp parallel for schedule(dynamic, 1024) num_threads(GetWorkerThreads())
+	for (int i = 0; i < VSize; ++i)
+	{
+		std::sort(corners.begin() + start[i], corners.begin() + start[i + 1]);
+		count[i] = std::unique(corners.begin() + start[i], corners.begin() + start[i + 1]) - corners.begin() - start[i];
+	}
+
+	VV.Start.resize(VSize + 1);
+	VV.Start[0] = 0;
+	for (int i = 0; i < VSize; ++i)
+		VV.Start[i + 1] = VV.Start[i] + count[i];
+	VV.Indices.resize(VV.Start[VSize]);
+	for (int i = 0; i < VSize; ++i)
+		std::copy(corners.begin() + start[i], corners.begin() + start[i] + count[i], VV.Indices.begin() + VV.Start[i]);
+}
+
+/**
+ * @return True if the edge ij has only one face, i.e. it is on the boundary of the mesh
+ */
+static bool IsBoundaryEdge(MeshState* state, int i, int j)
+{
+	const auto& F = *state->F;
+	const auto& VF = state->Native->VertexFaces;
+	int faces = 0;
+	for (const int* f = VF.Begin(i); f != VF.End(i); ++f)
+		if (F(*f, 0) == j || F(*f, 1) == j || F(*f, 2) == j)
+			faces++;
+	return faces == 1;
+}
+
+// --- Frontier sweeps
+/**
+ * @return The vertices for which <code>predicate(i)</code> is true, evaluated in parallel
+ */
+template<typename Predicate>
+static std::vector<int> FilterParallel(const std::vector<int>& vertices, Predicate predicate)
+{
+	std::vector<int> result;
+	const int count = vertices.size();
+#pragma omp parallel num_threads(GetWorkerThreads())
+	{
+		std::vector<int> local;
+#pragma omp for schedule(dynamic, 256) nowait
+		for (int k = 0; k < count; ++k)
+			if (predicate(vertices[k]))
+				local.push_back(vertices[k]);
+#pragma omp critical
+		result.insert(result.end(), local.begin(), local.end());
+	}
+	return result;
+}
+
+/**
+ * One ring of a frontier sweep, the neighbors of the frontier are gathered in parallel.
+ * @param isReached Vertices that have been reached, the new ones are marked
+ * @param crossEdge Predicate <code>(i, j)</code> whether the sweep may go from i to its neighbor j
+ * @return The newly reached vertices, the next frontier
+ */
+template<typename EdgePredicate>
+static std::vector<int> ExpandFrontier(MeshState* state, const std::vector<int>& frontier,
+                                       std::vector<char>& isReached, EdgePredicate crossEdge)
+{
+	const auto& VV = state->Native->VertexVertices;
+	std::vector<int> candidates;
+	const int count = frontier.size();
+#pragma omp parallel num_threads(GetWorkerThreads())
+	{
+		std::vector<int> local;
+#pragma omp for schedule(dynamic, 256) nowait
+		for (int k = 0; k < count; ++k)
+		{
+			const int i = frontier[k];
+			for (const int* j = VV.Begin(i); j != VV.End(i); ++j)
+				if (!isReached[*j] && crossEdge(i, *j))
+					local.push_back(*j);
+		}
+#pragma omp critical
+		candidates.insert(candidates.end(), local.begin(), local.end());
+	}
+
+	// Several frontier vertices may share a neighbor
+	std::vector<int> next;
+	for (const int j : candidates)
+	{
+		if (isReached[j])
+			continue;
+		isReached[j] = true;
+		next.push_back(j);
+	}
+	return next;
+}
+
+static bool AnyEdge(int, int)
+{ return true; }
+
+// --- Selections
+/**
+ * Get the selected vertices of a selection or selection set, sorted
+ * @return False if the selection set does not exist
+ */
+static bool GetSelected(MeshState* state, int selectionId, std::vector<int>& selected)
+{
+	selected.clear();
+	if (selectionId >= SelectionSetStore::FirstId)
+	{
+		const SelectionSet* set = GetSelectionSet(state, selectionId);
+		if (set == nullptr)
+		{
+			LOGERR("Invalid selection set: " << selectionId)
+			return false;
+		}
+		selected = set->Indices;
+		return true;
+	}
+
+	const unsigned int maskId = 1u << selectionId;
+	VisitS(state, [&](const auto& S) {
+		for (int i = 0; i < state->VSize; ++i)
+			if ((S(i) & maskId) > 0)
+				selected.push_back(i);
+	});
+	return true;
+}
+
+/**
+ * Add or remove vertices of a selection or selection set, only the given vertices are accessed
+ * @param vertices Modified vertices, are sorted
+ * @param selectionMode SelectionMode::Add or SelectionMode::Subtract
+ */
+static void ModifySelected(MeshState* state, int selectionId, std::vector<int>& vertices, unsigned int selectionMode)
+{
+	if (vertices.empty())
+		return;
+	std::sort(vertices.begin(), vertices.end());
+
+	if (selectionId >= SelectionSetStore::FirstId)
+	{
+		ModifySelectionSet(state, selectionId, vertices, selectionMode);
+		return;
+	}
+
+	const unsigned int maskId = 1u << selectionId;
+	EnsureSWidth(state, selectionId + 1);
+	VisitS(state, [&](auto& S) {
+		using Scalar = typename std::decay<decltype(S)>::type::Scalar;
+		const auto bit = static_cast<Scalar>(maskId);
+		if (selectionMode == SelectionMode::Add)
+			for (const int i : vertices)
+				S(i) |= bit;
+		else
+			for (const int i : vertices)
+				S(i) &= static_cast<Scalar>(~bit);
+	});
+	state->DirtySelections |= maskId;
+}
+
+/**
+ * @return Flags for each vertex, true for the given vertices
+ */
+static std::vector<char> ToFlags(MeshState* state, const std::vector<int>& vertices, bool value)
+{
+	std::vector<char> flags(state->VSize, !value);
+	for (const int i : vertices)
+		flags[i] = value;
+	return flags;
+}
+
+void GrowSelection(MeshState* state, int selectionId, int rings)
+{
+	TraceScope trace(state, BatchOp::GrowSelection, [&](BatchCommand& cmd) {
+		cmd.SelectionId = selectionId;
+		cmd.Iterations = rings;
+	});
+	state->EnsureInitialized();
+
+	std::vector<int> selected;
+	if (!GetSelected(state, selectionId, selected))
+		return;
+
+	std::vector<char> isReached = ToFlags(state, selected, true);
+	std::vector<int> frontier = std::move(selected), added;
+	for (int ring = 0; ring < rings && !frontier.empty(); ++ring)
+	{
+		frontier = ExpandFrontier(state, frontier, isReached, AnyEdge);
+		added.insert(added.end(), frontier.begin(), frontier.end());
+	}
+
+	ModifySelected(state, selectionId, added, SelectionMode::Add);
+}
+
+void ShrinkSelection(MeshState* state, int selectionId, int rings)
+{
+	TraceScope trace(state, BatchOp::ShrinkSelection, [&](BatchCommand& cmd) {
+		cmd.SelectionId = selectionId;
+		cmd.Iterations = rings;
+	});
+	state->EnsureInitialized();
+
+	std::vector<int> selected;
+	if (!GetSelected(state, selectionId, selected) || rings <= 0)
+		return;
+
+	// Sweep inwards from the border of the selection, see SelectBorder, unselected vertices count as reached
+	const auto& VV = state->Native->VertexVertices;
+	std::vector<char> isReached = ToFlags(state, selected, false);
+	std::vector<int> frontier = FilterParallel(selected, [&](int i) -> bool {
+		return std::any_of(VV.Begin(i), VV.End(i), [&](int j) -> bool {
+			return isReached[j] || IsBoundaryEdge(state, i, j);
+		});
+	});
+	for (const int i : frontier)
+		isReached[i] = true;
+
+	std::vector<int> removed = frontier;
+	for (int ring = 1; ring < rings && !frontier.empty(); ++ring)
+	{
+		frontier = ExpandFrontier(state, frontier, isReached, AnyEdge);
+		removed.insert(removed.end(), frontier.begin(), frontier.end());
+	}
+
+	ModifySelected(state, selectionId, removed, SelectionMode::Subtract);
+}
+
+void SelectBorder(MeshState* state, int selectionId)
+{
+	TraceScope trace(state, BatchOp::SelectBorder, [&](BatchCommand& cmd) {
+		cmd.SelectionId = selectionId;
+	});
+	state->EnsureInitialized();
+
+	std::vector<int> selected;
+	if (!GetSelected(state, selectionId, selected))
+		return;
+
+	// Remove the vertices with only selected neighbors that are not on the boundary of the mesh
+	const auto& VV = state->Native->VertexVertices;
+	const std::vector<char> isSelected = ToFlags(state, selected, true);
+	std::vector<int> interior = FilterParallel(selected, [&](int i) -> bool {
+		return std::all_of(VV.Begin(i), VV.End(i), [&](int j) -> bool {
+			return isSelected[j] && !IsBoundaryEdge(state, i, j);
+		});
+	});
+
+	ModifySelected(state, selectionId, interior, SelectionMode::Subtract);
+}
+
+void SelectBoundaryLoops(MeshState* state, int selectionId)
+{
+	TraceScope trace(state, BatchOp::SelectBoundaryLoops, [&](BatchCommand& cmd) {
+		cmd.SelectionId = selectionId;
+	});
+	state->EnsureInitialized();
+
+	std::vector<int> selected;
+	if (!GetSelected(state, selectionId, selected))
+		return;
+
+	// Sweep along the boundary edges from the selected boundary vertices
+	const auto& VV = state->Native->VertexVertices;
+	std::vector<int> frontier = FilterParallel(selected, [&](int i) -> bool {
+		return std::any_of(VV.Begin(i), VV.End(i), [&](int j) -> bool { return IsBoundaryEdge(state, i, j); });
+	});
+
+	std::vector<char> isReached = ToFlags(state, selected, true);
+	std::vector<int> added;
+	auto isBoundaryEdge = [&](int i, int j) -> bool { return IsBoundaryEdge(state, i, j); };
+	while (!frontier.empty())
+	{
+		frontier = ExpandFrontier(state, frontier, isReached, isBoundaryEdge);
+		added.insert(added.end(), frontier.begin(), frontier.end());
+	}
+
+	ModifySelected(state, selectionId, added, SelectionMode::Add);
+}
+
+void SelectConnected(MeshState* state, int selectionId)
+{
+	TraceScope trace(state, BatchOp::SelectConnected, [&](BatchCommand& cmd) {
+		cmd.SelectionId = selectionId;
+	});
+	state->EnsureInitialized();
+
+	std::vector<int> selected;
+	if (!GetSelected(state, selectionId, selected))
+		return;
+
+	std::vector<char> isReached = ToFlags(state, selected, true);
+	std::vector<int> frontier = std::move(selected), added;
+	while (!frontier.empty())
+	{
+		frontier = ExpandFrontier(state, frontier, isReached, AnyEdge);
+		added.insert(added.end(), frontier.begin(), frontier.end());
+	}
+
+	ModifySelected(state, selectionId, added, SelectionMode::Add);
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <Eigen/Core>
+#include <vector>
+
+/**
+ * Adjacency in compressed sparse rows, the neighbors of i are <code>Indices[Start[i]]</code> until
+ * <code>Indices[Start[i + 1]]</code>.
+ */
+struct CsrAdjacency
+{
+	/** Offsets into Indices, with dimensions VSize + 1 */
+	std::vector<int> Start;
+	std::vector<int> Indices;
+
+	/** @return Pointer to the first neighbor of i */
+	const int* Begin(int i) const
+	{ return Indices.data() + Start[i]; }
+
+	/** @return Pointer after the last neighbor of i */
+	const int* End(int i) const
+	{ return Indices.data() + Start[i + 1]; }
+};
+
+/**
+ * Build the vertex-vertex adjacency, the neighbors of a vertex are sorted and unique
+ */
+void BuildVertexVertices(const Eigen::MatrixXi& F, int VSize, CsrAdjacency& VV);
+
+/**
+ * Build the vertex-face adjacency, the faces of a vertex are sorted
+ */
+void BuildVertexFaces(const Eigen::MatrixXi& F, int VSize, CsrAdjacency& VF);
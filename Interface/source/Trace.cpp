@@ -0,0 +1,208 @@
+#include "Native.h"
+#include "Trace.h"
+#include "Storage.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+std::atomic<bool> s_IsTracing{false};
+thread_local int s_TraceDepth = 0;
+
+static std::mutex s_TraceMutex;
+static std::ofstream s_TraceFile;
+static std::chrono::steady_clock::time_point s_TraceStart;
+/** Incremented by every StartTrace, so calls started in a previous trace are not recorded */
+static unsigned int s_TraceGeneration = 0;
+/** Id of each mesh that has been written to the trace */
+static std::unordered_map<MeshState*, int> s_TraceMeshIds;
+static int s_NextMeshId = 0;
+
+template<typename T>
+static void Write(const T& value)
+{
+	s_TraceFile.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+/**
+ * Write the type of the next record, see TraceRecord
+ */
+static void WriteRecord(const unsigned int type)
+{
+	Write(type);
+}
+
+/**
+ * Write the matrix in row major order, i.e. the Unity layout
+ */
+template<typename Derived>
+static void WriteRowMajor(const Eigen::MatrixBase<Derived>& matrix)
+{
+	using Scalar = typename Derived::Scalar;
+	const Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> rowMajor = matrix;
+	s_TraceFile.write(reinterpret_cast<const char*>(rowMajor.data()), sizeof(Scalar) * rowMajor.size());
+}
+
+/**
+ * Write the snapshot of the mesh, see TraceMesh
+ */
+static void WriteMesh(MeshState* state, const int meshId)
+{
+	const auto* native = state->Native;
+
+	TraceMesh mesh{};
+	mesh.MeshId = meshId;
+	mesh.VSize = state->VSize;
+	mesh.FSize = state->FSize;
+	mesh.SSize = state->SSize;
+	mesh.DirtyState = state->DirtyState;
+	mesh.DirtySelections = state->DirtySelections;
+	mesh.DirtySelectionsResized = state->DirtySelectionsResized;
+	mesh.CompactStorage = native->CompactStorage;
+
+	WriteRecord(TraceRecord::Mesh);
+	Write(mesh);
+	WriteRowMajor(*native->V0);
+	WriteRowMajor(*state->V);
+	WriteRowMajor(*state->N);
+	if (native->CompactStorage)
+	{
+		WriteRowMajor(native->C8.cast<float>() * (1.f / 255.f));
+		WriteRowMajor(native->UV16.cast<float>());
+	}
+	else
+	{
+		WriteRowMajor(*state->C);
+		WriteRowMajor(*state->UV);
+	}
+	WriteRowMajor(*state->F);
+	VisitS(state, [&](const auto& S) { WriteRowMajor(S.template cast<unsigned int>()); });
+}
+
+/**
+ * Write the untraced record, see TraceUntraced
+ */
+static void WriteUntraced(const int meshId, const char* name)
+{
+	TraceUntraced untraced{};
+	untraced.MeshId = meshId;
+	std::strncpy(untraced.Name, name, sizeof(untraced.Name) - 1);
+
+	WriteRecord(TraceRecord::Untraced);
+	Write(untraced);
+}
+
+/**
+ * @return The id of the mesh in the trace, writes the snapshot when the mesh is first used
+ */
+static int GetMeshId(MeshState* state)
+{
+	auto it = s_TraceMeshIds.find(state);
+	if (it != s_TraceMeshIds.end())
+		return it->second;
+
+	const int meshId = s_NextMeshId++;
+	s_TraceMeshIds.emplace(state, meshId);
+	WriteMesh(state, meshId);
+
+	const auto& sets = state->Native->SelectionSets.Sets;
+	if (std::any_of(sets.begin(), sets.end(), [](const SelectionSet& set) { return set.IsUsed; }))
+		WriteUntraced(meshId, "SelectionSets");
+	return meshId;
+}
+
+// --- TraceScope
+void TraceScope::Begin(MeshState* state)
+{
+	// Snapshot the initialized mesh and don't include waiting for the initialization in the call
+	state->EnsureInitialized();
+
+	std::lock_guard<std::mutex> lock(s_TraceMutex);
+	if (!s_TraceFile.is_open())
+		return;
+
+	Active = true;
+	Generation = s_TraceGeneration;
+	Call.MeshId = GetMeshId(state);
+	Start = std::chrono::steady_clock::now();
+	Call.StartNs = std::chrono::duration_cast<std::chrono::nanoseconds>(Start - s_TraceStart).count();
+}
+
+void TraceScope::Untraced(MeshState* state, const char* name)
+{
+	state->EnsureInitialized();
+
+	std::lock_guard<std::mutex> lock(s_TraceMutex);
+	if (!s_TraceFile.is_open())
+		return;
+
+	WriteUntraced(GetMeshId(state), name);
+}
+
+TraceScope::~TraceScope()
+{
+	--s_TraceDepth;
+	if (!Active)
+		return;
+
+	Call.DurationNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - Start).count();
+
+	std::lock_guard<std::mutex> lock(s_TraceMutex);
+	if (!s_TraceFile.is_open() || Generation != s_TraceGeneration)
+		return;
+
+	WriteRecord(TraceRecord::Call);
+	Write(Call);
+}
+
+void TraceDispose(MeshState* state)
+{
+	if (!s_IsTracing.load(std::memory_order_relaxed))
+		return;
+
+	std::lock_guard<std::mutex> lock(s_TraceMutex);
+	auto it = s_TraceMeshIds.find(state);
+	if (it == s_TraceMeshIds.end())
+		return;
+
+	WriteRecord(TraceRecord::Dispose);
+	Write(it->second);
+	s_TraceMeshIds.erase(it);
+}
+
+// --- Exports
+bool StartTrace(const char* path)
+{
+	StopTrace();
+
+	std::lock_guard<std::mutex> lock(s_TraceMutex);
+	s_TraceFile.open(path, std::ios::binary | std::ios::trunc);
+	if (!s_TraceFile.is_open())
+	{
+		LOGERR("StartTrace: Could not open " << path)
+		return false;
+	}
+
+	Write(TraceHeader());
+	s_TraceStart = std::chrono::steady_clock::now();
+	s_TraceGeneration++;
+	s_TraceMeshIds.clear();
+	s_NextMeshId = 0;
+	s_IsTracing.store(true, std::memory_order_relaxed);
+
+	LOG("Started trace: " << path)
+	return true;
+}
+
+void StopTrace()
+{
+	std::lock_guard<std::mutex> lock(s_TraceMutex);
+	s_IsTracing.store(false, std::memory_order_relaxed);
+	if (!s_TraceFile.is_open())
+		return;
+
+	s_TraceFile.close();
+	s_TraceMeshIds.clear();
+	LOG("Stopped trace.")
+}
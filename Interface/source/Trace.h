@@ -0,0 +1,150 @@
+#pragma once
+#include "MeshState.h"
+#include <atomic>
+#include <chrono>
+
+/**
+ * Type of the next record in a trace
+ */
+struct TraceRecord
+{
+	static const unsigned int Mesh = 0;
+	static const unsigned int Dispose = 1;
+	static const unsigned int Call = 2;
+	static const unsigned int Untraced = 3;
+};
+
+/**
+ * Snapshot of a mesh, written when a mesh is used the first time after StartTrace.
+ * Followed by the arrays in the Unity (row major) layout:
+ * V0, V, N (float VSize x 3), C (float VSize x 4), UV (float VSize x 2), F (int FSize x 3), S (uint VSize).
+ * Compact storage is written converted to floats/uint.
+ */
+struct TraceMesh
+{
+	int MeshId;
+	int VSize;
+	int FSize;
+	unsigned int SSize;
+	unsigned int DirtyState;
+	unsigned int DirtySelections;
+	unsigned int DirtySelectionsResized;
+	unsigned int CompactStorage;
+};
+
+/**
+ * One exported call with its arguments, stored as the equivalent BatchCommand.
+ */
+struct TraceCall
+{
+	/** Index of the mesh in the trace, see TraceMesh */
+	int MeshId;
+	/** Time since StartTrace at the start of the call */
+	long long StartNs;
+	/** Duration of the call when recording */
+	long long DurationNs;
+	/** Arguments of the call, <code>State</code> and the <code>Data</code> pointers are null */
+	BatchCommand Command;
+};
+
+/**
+ * A call that modified the mesh but could not be recorded, e.g. as its arguments include selection sets.
+ * Also written after the snapshot of a mesh with selection sets, as they are not part of it.
+ * The replay skips the following calls of the mesh, as they would operate on a different mesh than when recording.
+ */
+struct TraceUntraced
+{
+	/** Index of the mesh in the trace, see TraceMesh */
+	int MeshId;
+	/** Name of the exported function, null terminated */
+	char Name[32];
+};
+
+/**
+ * Binary trace of the exported calls, see StartTrace. Layout of the file:
+ * <ol>
+ * <li>TraceHeader</li>
+ * <li>Records, each one starts with a TraceRecord constant
+ *   <ul>
+ *   <li>Mesh: TraceMesh followed by the snapshot arrays, see TraceMesh</li>
+ *   <li>Dispose: int MeshId</li>
+ *   <li>Call: TraceCall</li>
+ *   <li>Untraced: TraceUntraced</li>
+ *   </ul>
+ * </li>
+ * </ol>
+ * Structs are written as is, so the trace can only be replayed on a platform with the same endianness and alignment,
+ * e.g. record on a Windows x64 headset and replay on Linux x64.
+ */
+struct TraceHeader
+{
+	char Magic[4]{'L', 'T', 'R', 'C'};
+	unsigned int Version{4};
+	/** sizeof(TraceCall) when recording, used to detect a mismatching layout */
+	unsigned int CallSize{sizeof(TraceCall)};
+};
+
+/** True while a trace is being recorded, checked first so tracing is cheap when disabled */
+extern std::atomic<bool> s_IsTracing;
+/** Depth of traced calls on this thread, only the outermost call is recorded */
+extern thread_local int s_TraceDepth;
+
+/**
+ * Records the exported call it is created in, if a trace is running. Construct it first in the function.
+ * Nested calls, e.g. SetColorByMask inside ApplyDirty or the commands of ExecuteBatch, are recorded only once.
+ * <example><code>TraceScope trace(state, BatchOp::ResetV, [&](BatchCommand& cmd) {});</code></example>
+ */
+class TraceScope
+{
+public:
+	/**
+	 * @param setArgs Called with the command to fill in the arguments, only called when recording
+	 */
+	template<typename Fn>
+	TraceScope(MeshState* state, unsigned int op, Fn&& setArgs)
+	{
+		if (++s_TraceDepth > 1 || !s_IsTracing.load(std::memory_order_relaxed))
+			return;
+
+		Call.Command = BatchCommand();
+		Call.Command.Op = op;
+		Call.Command.MaskSource = -1;
+		setArgs(Call.Command);
+		Begin(state);
+	}
+
+	/**
+	 * Mark the trace as not replayable from here on, for exported calls whose arguments do not fit a BatchCommand.
+	 * <example><code>TraceScope trace(state, "AddSelectionSet");</code></example>
+	 * @param name Name of the exported function, written to the trace
+	 */
+	TraceScope(MeshState* state, const char* name)
+	{
+		if (++s_TraceDepth > 1 || !s_IsTracing.load(std::memory_order_relaxed))
+			return;
+
+		Untraced(state, name);
+	}
+
+	~TraceScope();
+
+	TraceScope(const TraceScope&) = delete;
+	TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+	bool Active{false};
+	unsigned int Generation{0};
+	TraceCall Call;
+	std::chrono::steady_clock::time_point Start;
+
+	/** Writes the mesh snapshot if required and starts the timer */
+	void Begin(MeshState* state);
+
+	/** Writes a TraceUntraced record */
+	static void Untraced(MeshState* state, const char* name);
+};
+
+/**
+ * Remove a mesh from the trace, called when the mesh is disposed, so a new mesh at the same address is snapshot again.
+ */
+void TraceDispose(MeshState* state);
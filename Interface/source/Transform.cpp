@@ -1,51 +1,97 @@
 #include "Native.h"
+#include "Storage.h"
+#include "Trace.h"
+#include "Symmetry.h"
 
 // --- Transformations
 void TranslateAllVertices(MeshState* state, Vector3 value)
 {
+	TraceScope trace(state, BatchOp::TranslateAllVertices, [&](BatchCommand& cmd) {
+		cmd.Translation = value;
+	});
+	state->EnsureInitialized();
+
 	state->V->rowwise() += value.AsEigenRow();
 	state->DirtyState |= DirtyFlag::VDirty;
+	state->Native->ExtendDirtyV(0, state->VSize);
 }
 
 void TranslateSelection(MeshState* state, Vector3 value, unsigned int maskId)
 {
+	TraceScope trace(state, BatchOp::TranslateSelection, [&](BatchCommand& cmd) {
+		cmd.Translation = value;
+		cmd.MaskId = maskId;
+	});
+	state->EnsureInitialized();
+
 	auto& V = *state->V;
-	const auto& S = *state->S;
 	const Eigen::RowVector3f valueEigen = value.AsEigenRow();
 
-	for (int i = 0; i < V.rows(); ++i)
-	{
-		if ((S(i) & maskId) > 0)
-			V.row(i) += valueEigen;
-	}
+	int begin = V.rows(), end = 0;
+	if (state->Native->SymmetryAxis >= 0)
+		TransformSymmetric(state, Eigen::Affine3f(Eigen::Translation3f(value.AsEigen())), maskId, begin, end);
+	else
+		VisitS(state, [&](const auto& S) {
+			for (int i = 0; i < V.rows(); ++i)
+			{
+				if ((S(i) & maskId) > 0)
+				{
+					V.row(i) += valueEigen;
+					begin = std::min(begin, i);
+					end = i + 1;
+				}
+			}
+		});
 
 	state->DirtyState |= DirtyFlag::VDirty;
+	state->Native->ExtendDirtyV(begin, end);
 }
 
 void TransformSelection(MeshState* state, Vector3 translation, float scale, Quaternion rotation, Vector3 pivot, unsigned int maskId)
 {
+	TraceScope trace(state, BatchOp::TransformSelection, [&](BatchCommand& cmd) {
+		cmd.Translation = translation;
+		cmd.Scale = scale;
+		cmd.Rotation = rotation;
+		cmd.Pivot = pivot;
+		cmd.MaskId = maskId;
+	});
+	state->EnsureInitialized();
+
 	auto& V = *state->V;
-	const auto& S = *state->S;
 
 	using namespace Eigen;
 	Transform<float, 3, Affine> transform =
 			Translation3f(translation.AsEigen()) *
 			Translation3f(pivot.AsEigen()) * Scaling(scale) * rotation.AsEigen() * Translation3f(-pivot.AsEigen());
 
-	for (int i = 0; i < V.rows(); ++i)
-	{
-		if ((S(i) & maskId) > 0)
-		{
-			Vector3f v = V.row(i);
-			V.row(i) = transform * v;
-		}
-	}
+	int begin = V.rows(), end = 0;
+	if (state->Native->SymmetryAxis >= 0)
+		TransformSymmetric(state, transform, maskId, begin, end);
+	else
+		VisitS(state, [&](const auto& S) {
+			for (int i = 0; i < V.rows(); ++i)
+			{
+				if ((S(i) & maskId) > 0)
+				{
+					Vector3f v = V.row(i);
+					V.row(i) = transform * v;
+					begin = std::min(begin, i);
+					end = i + 1;
+				}
+			}
+		});
 
 	state->DirtyState |= DirtyFlag::VDirty;
+	state->Native->ExtendDirtyV(begin, end);
 }
 
 void ResetV(MeshState* state)
 {
+	TraceScope trace(state, BatchOp::ResetV, [&](BatchCommand& cmd) {});
+	state->EnsureInitialized();
+
 	*state->V = *state->Native->V0;
 	state->DirtyState |= DirtyFlag::VDirty;
+	state->Native->ExtendDirtyV(0, state->VSize);
 }
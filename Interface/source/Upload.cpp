@@ -0,0 +1,244 @@
+#include "Native.h"
+#include "Upload.h"
+#include "Util.h"
+#include <unordered_set>
+
+static IUnityGraphics* s_Graphics = nullptr;
+static RenderAPI* s_CurrentAPI = nullptr;
+static UnityGfxRenderer s_DeviceType = kUnityGfxRendererNull;
+
+/**
+ * All VertexUploadData that may be uploaded. Render events may still be queued after a mesh is disposed,
+ * so UploadMesh only accepts registered pointers. Held during the upload so the data cannot be deleted meanwhile.
+ */
+static std::unordered_set<VertexUploadData*> s_Uploads;
+static std::mutex s_UploadsMutex;
+
+/**
+ * @return True if mapping a vertex buffer keeps its contents, so we can upload only the dirty range.
+ * D3D11 maps with <code>D3D11_MAP_WRITE_DISCARD</code>, for the other APIs we are conservative.
+ * The null device only has a RenderAPI if one is set with SetRenderAPI, e.g. the CPU one.
+ */
+static bool MapPreservesContents(UnityGfxRenderer deviceType)
+{
+	return deviceType == kUnityGfxRendererNull || deviceType == kUnityGfxRendererOpenGLCore;
+}
+
+// --- VertexUploadData
+VertexUploadData::VertexUploadData(void* gfxVertexBufferPtr, const Eigen::MatrixXf& V)
+		: GfxVertexBufferPtr(gfxVertexBufferPtr), VSize(V.rows())
+{
+	Buffers[0] = V;
+	Buffers[1] = V;
+
+	// Upload everything once so the vertex buffer is in sync
+	PendingEnd = VSize;
+}
+
+void VertexUploadData::Stage(const Eigen::MatrixXf& V, int begin, int end)
+{
+	int back, copyBegin = begin, copyEnd = end;
+	{
+		std::unique_lock<std::mutex> lock(Mutex);
+		back = 1 - Front;
+		Released.wait(lock, [&]() -> bool { return Reading != back; });
+
+		// The back buffer is also missing the vertices of the previous Stage
+		UnionRange(copyBegin, copyEnd, StaleBegin, StaleEnd);
+	}
+
+	// The render thread only reads Buffers[Front], so we can write without holding the lock
+	if (copyBegin < copyEnd)
+		Buffers[back].middleRows(copyBegin, copyEnd - copyBegin) = V.middleRows(copyBegin, copyEnd - copyBegin);
+
+	std::lock_guard<std::mutex> lock(Mutex);
+	Front = back;
+	StaleBegin = begin;
+	StaleEnd = end;
+	UnionRange(PendingBegin, PendingEnd, begin, end);
+}
+
+bool VertexUploadData::Upload(RenderAPI* api, bool uploadFullBuffer)
+{
+	int reading, begin, end;
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		if (PendingBegin >= PendingEnd)
+			return false;
+
+		reading = Reading = Front;
+		begin = uploadFullBuffer ? 0 : PendingBegin;
+		end = uploadFullBuffer ? VSize : PendingEnd;
+		PendingBegin = PendingEnd = 0;
+	}
+
+	size_t bufferSize = 0;
+	auto* bufferMapPtr = static_cast<float*>(api->BeginModifyVertexBuffer(GfxVertexBufferPtr, &bufferSize));
+	const bool success = bufferMapPtr != nullptr && bufferSize >= sizeof(float) * 3 * VSize;
+	if (success)
+		std::copy(Buffers[reading].data() + 3 * begin, Buffers[reading].data() + 3 * end, bufferMapPtr + 3 * begin);
+	else
+		LOGERR("UploadMesh: Could not map the vertex buffer of size " << bufferSize << " for " << VSize << " vertices.")
+
+	if (bufferMapPtr != nullptr)
+		api->EndModifyVertexBuffer(GfxVertexBufferPtr);
+
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		if (!success) // Retry on the next upload
+			UnionRange(PendingBegin, PendingEnd, begin, end);
+		Reading = -1;
+	}
+	Released.notify_all();
+	return success;
+}
+
+// --- RenderAPI_CPU
+class RenderAPI_CPU : public RenderAPI
+{
+public:
+	void ProcessDeviceEvent(UnityGfxDeviceEventType type, IUnityInterfaces* interfaces) override
+	{}
+
+	bool GetUsesReverseZ() override
+	{ return false; }
+
+	void DrawSimpleTriangles(const float worldMatrix[16], int triangleCount, const void* verticesFloat3Byte4) override
+	{}
+
+	void* BeginModifyTexture(void* textureHandle, int textureWidth, int textureHeight, int* outRowPitch) override
+	{ return nullptr; }
+
+	void EndModifyTexture(void* textureHandle, int textureWidth, int textureHeight, int rowPitch, void* dataPtr) override
+	{}
+
+	void* BeginModifyVertexBuffer(void* bufferHandle, size_t* outBufferSize) override
+	{
+		auto* buffer = static_cast<CpuVertexBuffer*>(bufferHandle);
+		if (buffer == nullptr)
+			return nullptr;
+
+		*outBufferSize = buffer->Size;
+		return buffer->Data;
+	}
+
+	void EndModifyVertexBuffer(void* bufferHandle) override
+	{}
+};
+
+RenderAPI* CreateRenderAPI_CPU()
+{
+	return new RenderAPI_CPU();
+}
+
+// --- Graphics device
+static void UNITY_INTERFACE_API OnGraphicsDeviceEvent(UnityGfxDeviceEventType eventType)
+{
+	// Create graphics API implementation upon initialization
+	if (eventType == kUnityGfxDeviceEventInitialize)
+	{
+		// With -nographics the vertex buffer handles are not CpuVertexBuffers, the managed upload is used instead
+		const UnityGfxRenderer deviceType = s_Graphics->GetRenderer();
+		if (deviceType == kUnityGfxRendererNull)
+			SetRenderAPI(nullptr, deviceType);
+		else
+		{
+#ifdef UNITY_INCLUDE_RENDER_API
+			SetRenderAPI(CreateRenderAPI(deviceType), deviceType);
+#else
+			LOGWARN("Native upload is disabled, build with UNITY_INCLUDE_RENDER_API to enable it.")
+			SetRenderAPI(nullptr, deviceType);
+#endif
+		}
+	}
+
+	// Let the implementation process the device related events
+	if (s_CurrentAPI)
+		s_CurrentAPI->ProcessDeviceEvent(eventType, s_IUnityInterfaces);
+
+	// Cleanup graphics API implementation upon shutdown
+	if (eventType == kUnityGfxDeviceEventShutdown)
+		SetRenderAPI(nullptr);
+}
+
+void InitializeGraphics(IUnityInterfaces* unityInterfaces)
+{
+	s_Graphics = unityInterfaces->Get<IUnityGraphics>();
+	s_Graphics->RegisterDeviceEventCallback(OnGraphicsDeviceEvent);
+
+	// Run OnGraphicsDeviceEvent(initialize) manually on plugin load
+	OnGraphicsDeviceEvent(kUnityGfxDeviceEventInitialize);
+}
+
+void DisposeGraphics()
+{
+	if (s_Graphics)
+		s_Graphics->UnregisterDeviceEventCallback(OnGraphicsDeviceEvent);
+	s_Graphics = nullptr;
+	SetRenderAPI(nullptr);
+}
+
+void SetRenderAPI(RenderAPI* api, UnityGfxRenderer deviceType)
+{
+	std::lock_guard<std::mutex> lock(s_UploadsMutex);
+	delete s_CurrentAPI;
+	s_CurrentAPI = api;
+	s_DeviceType = deviceType;
+}
+
+// --- Exports
+UnityRenderingEventAndData GetUploadMeshPtr()
+{
+	return UploadMesh;
+}
+
+void UNITY_INTERFACE_API UploadMesh(int eventId, void* data)
+{
+	std::lock_guard<std::mutex> lock(s_UploadsMutex);
+	if (!s_CurrentAPI)
+	{
+		LOGWARN("UploadMesh: CurrentAPI has not been initialized and is null, cannot upload to GPU.")
+		return;
+	}
+
+	auto* upload = static_cast<VertexUploadData*>(data);
+	if (s_Uploads.count(upload) == 0) // Mesh disposed since the event was issued
+		return;
+
+	upload->Upload(s_CurrentAPI, !MapPreservesContents(s_DeviceType));
+}
+
+VertexUploadData* EnableNativeUpload(MeshState* state, void* gfxVertexBufferPtr)
+{
+	state->EnsureInitialized();
+
+	DisableNativeUpload(state);
+
+	std::lock_guard<std::mutex> lock(s_UploadsMutex);
+	if (!s_CurrentAPI)
+	{
+		LOGWARN("EnableNativeUpload: No RenderAPI available, use the managed upload instead.")
+		return nullptr;
+	}
+
+	auto* upload = new VertexUploadData(gfxVertexBufferPtr, *state->V);
+	s_Uploads.insert(upload);
+
+	state->Native->Upload = upload;
+	return upload;
+}
+
+void DisableNativeUpload(MeshState* state)
+{
+	auto*& upload = state->Native->Upload;
+	if (upload == nullptr)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(s_UploadsMutex);
+		s_Uploads.erase(upload);
+	}
+
+	delete upload;
+	upload = nullptr;
+}
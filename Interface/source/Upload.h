@@ -0,0 +1,87 @@
+#pragma once
+#include <PluginAPI/IUnityGraphics.h>
+#include <RenderAPI/RenderAPI.h>
+#include <Eigen/Core>
+#include <condition_variable>
+#include <mutex>
+
+/**
+ * Double buffered vertex positions that are uploaded directly to the GPU vertex buffer on the render thread.
+ * The worker thread writes the dirty vertex range into the back buffer and publishes it in Stage().
+ * The render thread copies the published range into the mapped vertex buffer in Upload().
+ * Only the buffer that is not being read is ever written, so the two threads never touch the same memory.
+ * @note Assumes the first vertex buffer stream only contains the positions as float3, see C# Native.VertexBufferLayout
+ */
+struct VertexUploadData
+{
+	/** Native graphics handle of the vertex buffer, from C# <code>Mesh.GetNativeVertexBufferPtr(0)</code> */
+	void* GfxVertexBufferPtr;
+	int VSize;
+
+	/** Row major copies of V, the render thread reads from Buffers[Front] */
+	Eigen::Matrix<float, Eigen::Dynamic, 3, Eigen::RowMajor> Buffers[2];
+
+	VertexUploadData(void* gfxVertexBufferPtr, const Eigen::MatrixXf& V);
+
+	/**
+	 * Copy the rows [begin, end) of V into the back buffer and publish it for the next Upload().
+	 * Called on the worker thread, blocks only if the render thread is still reading the back buffer.
+	 */
+	void Stage(const Eigen::MatrixXf& V, int begin, int end);
+
+	/**
+	 * Copy the vertices published since the last upload into the GPU vertex buffer. Called on the render thread.
+	 * @param uploadFullBuffer Copy all vertices, required if mapping the buffer discards its contents
+	 * @return True if something was uploaded
+	 */
+	bool Upload(RenderAPI* api, bool uploadFullBuffer);
+
+private:
+	std::mutex Mutex;
+	/** Notified when the render thread has finished reading a buffer */
+	std::condition_variable Released;
+
+	/** Index of the published buffer */
+	int Front{0};
+	/** Index of the buffer the render thread is currently reading, -1 if none */
+	int Reading{-1};
+	/** Range of vertices [PendingBegin, PendingEnd) published but not yet uploaded */
+	int PendingBegin{0};
+	int PendingEnd{0};
+	/** Range of vertices the back buffer is missing, i.e. the range of the last Stage() */
+	int StaleBegin{0};
+	int StaleEnd{0};
+};
+
+/**
+ * Vertex buffer of the RenderAPI for running without a GPU in a test harness, see CreateRenderAPI_CPU.
+ * A vertex buffer handle is a pointer to a CpuVertexBuffer.
+ */
+struct CpuVertexBuffer
+{
+	void* Data;
+	/** Size of Data in bytes */
+	size_t Size;
+};
+
+/**
+ * Create a RenderAPI that maps CpuVertexBuffer handles to CPU memory, all other functionality does nothing.
+ * It is never created for a Unity graphics device, only install it with SetRenderAPI when all vertex buffer handles
+ * passed to EnableNativeUpload are CpuVertexBuffers.
+ */
+RenderAPI* CreateRenderAPI_CPU();
+
+/**
+ * Registers the graphics device callbacks so the correct RenderAPI is created. Called in UnityPluginLoad.
+ */
+void InitializeGraphics(IUnityInterfaces* unityInterfaces);
+
+/**
+ * Unregisters the graphics device callbacks and deletes the RenderAPI. Called in UnityPluginUnload.
+ */
+void DisposeGraphics();
+
+/**
+ * Override the RenderAPI used by UploadMesh, takes ownership. Use this when running without Unity.
+ */
+void SetRenderAPI(RenderAPI* api, UnityGfxRenderer deviceType = kUnityGfxRendererNull);
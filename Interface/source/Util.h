@@ -1,6 +1,38 @@
 #pragma once
 #include "InterfaceTypes.h"
 
+/** Thread budget of the solver running on this thread, 0 outside of a SolverScope */
+extern thread_local int s_SolverThreads;
+
+/**
+ * @return Number of threads for the OpenMP loops. Inside a SolverScope this is the budget of the mesh,
+ * otherwise the threads Eigen uses, which Initialize reduces so cores are left for the Unity main and render threads.
+ */
+inline int GetWorkerThreads()
+{
+	return s_SolverThreads > 0 ? s_SolverThreads : Eigen::nbThreads();
+}
+
+/**
+ * Union of two ranges [begin, end), an empty range has begin >= end
+ */
+inline void UnionRange(int& begin, int& end, const int otherBegin, const int otherEnd)
+{
+	if (otherBegin >= otherEnd)
+		return;
+
+	if (begin >= end)
+	{
+		begin = otherBegin;
+		end = otherEnd;
+	}
+	else
+	{
+		begin = std::min(begin, otherBegin);
+		end = std::max(end, otherEnd);
+	}
+}
+
 /**
  * Transpose an Eigen::Matrix to an Eigen::Map, given by the pointer to the first element
  * Dimensions are inferred from the Matrix
@@ -15,6 +47,20 @@ void TransposeToMap(Matrix* from, Scalar* to)
 	toMap = from->transpose();
 }
 
+/**
+ * Transpose the rows [begin, end) of an Eigen::Matrix to an Eigen::Map, given by the pointer to the first element
+ * of the <b>whole</b> matrix. Rows outside the range are not modified.
+ * @tparam Matrix An Eigen Matrix
+ * @tparam Scalar Type on one element
+ * @param to Pointer to the first element of a matrix or an array
+*/
+template<typename Matrix, typename Scalar>
+void TransposeRowsToMap(Matrix* from, Scalar* to, int begin, int end)
+{
+	auto toMap = Eigen::Map<Matrix>(to + begin * from->cols(), from->cols(), end - begin);
+	toMap = from->middleRows(begin, end - begin).transpose();
+}
+
 /**
  * Transpose an Eigen::Map to an Eigen::Matrix
  * @tparam Scalar Type on one element